@@ -15,6 +15,8 @@ struct ASYNCIO
 {
 	CLock lock;
 	IOHANDLE io;
+	ASYNCIO_ENCODER encoder;
+	void *encoder_user;
 	SEMAPHORE sphore;
 	void *thread;
 
@@ -78,6 +80,8 @@ static void aio_handle_free_and_unlock(ASYNCIO *aio) RELEASE(aio->lock)
 static void aio_thread(void *user)
 {
 	ASYNCIO *aio = (ASYNCIO *)user;
+	// the encoder has to be flushed once more if it encoded data since its last flush
+	bool encoder_flush_pending = aio->encoder != nullptr;
 
 	aio->lock.lock();
 	while(true)
@@ -91,6 +95,24 @@ static void aio_thread(void *user)
 		{
 			if(aio->finish != ASYNCIO_RUNNING)
 			{
+				if(encoder_flush_pending)
+				{
+					// flush without holding the lock, data written meanwhile is handled afterwards
+					encoder_flush_pending = false;
+					aio->lock.unlock();
+					result_io_error = aio->encoder(aio->encoder_user, aio->io, nullptr, 0);
+					io_flush(aio->io);
+					if(!result_io_error)
+					{
+						result_io_error = io_error(aio->io);
+					}
+					aio->lock.lock();
+					if(!aio->error)
+					{
+						aio->error = result_io_error;
+					}
+					continue;
+				}
 				if(aio->finish == ASYNCIO_CLOSE)
 				{
 					io_close(aio->io);
@@ -126,9 +148,21 @@ static void aio_thread(void *user)
 		aio->read_pos = (aio->read_pos + buffers.len1 + buffers.len2) % aio->buffer_size;
 		aio->lock.unlock();
 
-		io_write(aio->io, local_buffer, local_buffer_len);
+		if(aio->encoder)
+		{
+			result_io_error = aio->encoder(aio->encoder_user, aio->io, local_buffer, local_buffer_len);
+			encoder_flush_pending = true;
+		}
+		else
+		{
+			io_write(aio->io, local_buffer, local_buffer_len);
+			result_io_error = 0;
+		}
 		io_flush(aio->io);
-		result_io_error = io_error(aio->io);
+		if(!result_io_error)
+		{
+			result_io_error = io_error(aio->io);
+		}
 
 		aio->lock.lock();
 		aio->error = result_io_error;
@@ -136,6 +170,11 @@ static void aio_thread(void *user)
 }
 
 ASYNCIO *aio_new(IOHANDLE io)
+{
+	return aio_new_encoded(io, nullptr, nullptr);
+}
+
+ASYNCIO *aio_new_encoded(IOHANDLE io, ASYNCIO_ENCODER encoder, void *user)
 {
 	ASYNCIO *aio = new ASYNCIO;
 	if(!aio)
@@ -143,6 +182,8 @@ ASYNCIO *aio_new(IOHANDLE io)
 		return nullptr;
 	}
 	aio->io = io;
+	aio->encoder = encoder;
+	aio->encoder_user = user;
 	sphore_init(&aio->sphore);
 	aio->thread = nullptr;
 
@@ -14,6 +14,38 @@
  */
 ASYNCIO *aio_new(IOHANDLE io);
 
+/**
+ * Function that writes the queued data to the file on the writing thread,
+ * e.g. to compress it.
+ *
+ * @ingroup File-IO
+ *
+ * @param user Pointer passed to @link aio_new_encoded @endlink.
+ * @param io Handle to the file.
+ * @param buffer Pointer to the data that should be written, `nullptr` when
+ * the file is about to be closed and everything still buffered by the
+ * encoder should be written.
+ * @param size Number of bytes to write.
+ *
+ * @return `0` on success, or non-`0` on error.
+ */
+typedef int (*ASYNCIO_ENCODER)(void *user, IOHANDLE io, const void *buffer, unsigned size);
+
+/**
+ * Wraps a @link IOHANDLE @endlink for asynchronous writing through an
+ * encoder that runs on the writing thread.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param encoder Function that writes the data instead of @link io_write @endlink.
+ * @param user Pointer passed to the encoder, must stay valid until
+ * @link aio_wait @endlink returned.
+ *
+ * @return The handle for asynchronous writing.
+ */
+ASYNCIO *aio_new_encoded(IOHANDLE io, ASYNCIO_ENCODER encoder, void *user);
+
 /**
  * Locks the `ASYNCIO` structure so it can't be written into by
  * other threads.
@@ -32,6 +32,10 @@
 #include <sys/filio.h> // FIONBIO
 #endif
 
+#if defined(CONF_PLATFORM_LINUX)
+#include <netinet/udp.h> // UDP_SEGMENT
+#endif
+
 #include <cerrno>
 #elif defined(CONF_FAMILY_WINDOWS)
 #include <windows.h>
@@ -100,6 +104,30 @@ void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size)
 #endif
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+// the kernel refuses to split a datagram into more segments than this
+#define GSO_MAX_SEGMENTS 64
+#define GSO_MAX_SIZE 65000
+typedef struct
+{
+	int num;
+	int fds[VLEN];
+	int sizes[VLEN];
+	sockaddr_storage addrs[VLEN];
+	socklen_t addrlens[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+
+	// filled when flushing
+	struct mmsghdr msgs[VLEN];
+	struct iovec iovecs[VLEN];
+	int first_packet[VLEN];
+	char cmsgs[VLEN][CMSG_SPACE(sizeof(uint16_t))];
+
+	// whether all sockets support UDP generic segmentation offload
+	bool gso;
+} NETSOCKET_SEND_QUEUE;
+#endif
+
 struct NETSOCKET_INTERNAL
 {
 	int type;
@@ -109,6 +137,9 @@ struct NETSOCKET_INTERNAL
 	int web_ipv6sock;
 
 	NETSOCKET_BUFFER buffer;
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_QUEUE *send_queue;
+#endif
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1, -1};
 
@@ -1002,8 +1033,192 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+static bool priv_net_send_queue_push(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
+{
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(size < 0 || size > PACKETSIZE)
+		return false;
+
+	int fd;
+	sockaddr_storage sa;
+	socklen_t salen;
+	if(addr->type == NETTYPE_IPV4 && sock->ipv4sock >= 0)
+	{
+		fd = sock->ipv4sock;
+		netaddr_to_sockaddr_in(addr, (sockaddr_in *)&sa);
+		salen = sizeof(sockaddr_in);
+	}
+	else if(addr->type == NETTYPE_IPV6 && sock->ipv6sock >= 0)
+	{
+		fd = sock->ipv6sock;
+		netaddr_to_sockaddr_in6(addr, (sockaddr_in6 *)&sa);
+		salen = sizeof(sockaddr_in6);
+	}
+	else
+	{
+		// broadcasts, websockets and errors take the direct path
+		return false;
+	}
+
+	if(queue->num == VLEN)
+		net_udp_flush(sock);
+
+	const int i = queue->num++;
+	queue->fds[i] = fd;
+	queue->sizes[i] = size;
+	mem_copy(&queue->addrs[i], &sa, salen);
+	queue->addrlens[i] = salen;
+	mem_copy(queue->bufs[i], data, size);
+	return true;
+}
+
+static bool priv_net_send_queue_can_segment(const NETSOCKET_SEND_QUEUE *queue, int first, int next)
+{
+	// a segmented datagram goes to one address, all segments but the
+	// last one must have the same size
+	const int count = next - first;
+	return queue->gso &&
+	       count < GSO_MAX_SEGMENTS &&
+	       (count + 1) * queue->sizes[first] <= GSO_MAX_SIZE &&
+	       queue->fds[next] == queue->fds[first] &&
+	       queue->sizes[next - 1] == queue->sizes[first] &&
+	       queue->sizes[next] <= queue->sizes[first] &&
+	       queue->addrlens[next] == queue->addrlens[first] &&
+	       mem_comp(&queue->addrs[next], &queue->addrs[first], queue->addrlens[first]) == 0;
+}
+
+static void priv_net_send_queue_fill_msg(NETSOCKET_SEND_QUEUE *queue, int msg, int first, int count)
+{
+	mem_zero(&queue->msgs[msg], sizeof(queue->msgs[msg]));
+	msghdr *hdr = &queue->msgs[msg].msg_hdr;
+	hdr->msg_name = &queue->addrs[first];
+	hdr->msg_namelen = queue->addrlens[first];
+	hdr->msg_iov = &queue->iovecs[first];
+	hdr->msg_iovlen = count;
+	queue->first_packet[msg] = first;
+#if defined(UDP_SEGMENT)
+	if(count > 1)
+	{
+		hdr->msg_control = queue->cmsgs[msg];
+		hdr->msg_controllen = sizeof(queue->cmsgs[msg]);
+		cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+		cmsg->cmsg_level = IPPROTO_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		const uint16_t segment_size = queue->sizes[first];
+		mem_copy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+	}
+#endif
+}
+#endif
+
+void net_udp_set_batching(NETSOCKET sock, bool enabled)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(!enabled)
+	{
+		net_udp_flush(sock);
+		free(sock->send_queue);
+		sock->send_queue = nullptr;
+		return;
+	}
+	if(sock->send_queue)
+		return;
+
+	sock->send_queue = (NETSOCKET_SEND_QUEUE *)malloc(sizeof(*sock->send_queue));
+	sock->send_queue->num = 0;
+	for(int i = 0; i < VLEN; i++)
+	{
+		sock->send_queue->iovecs[i].iov_base = sock->send_queue->bufs[i];
+	}
+	sock->send_queue->gso = false;
+#if defined(UDP_SEGMENT)
+	// kernels without UDP GSO (before 4.18) don't know the option, setting
+	// it to zero keeps the datagrams of plain sends unsegmented
+	sock->send_queue->gso = true;
+	for(int fd : {sock->ipv4sock, sock->ipv6sock})
+	{
+		const int segment_size = 0;
+		if(fd >= 0 && setsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) != 0)
+			sock->send_queue->gso = false;
+	}
+#endif
+#endif
+}
+
+void net_udp_flush(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(!queue || queue->num == 0)
+		return;
+
+	for(int i = 0; i < queue->num; i++)
+	{
+		queue->iovecs[i].iov_len = queue->sizes[i];
+	}
+
+	int first = 0;
+	while(first < queue->num)
+	{
+		// one sendmmsg per underlying socket, consecutive packets to the
+		// same address are merged into one segmented datagram
+		const int fd = queue->fds[first];
+		int num_msgs = 0;
+		while(first < queue->num && queue->fds[first] == fd)
+		{
+			int next = first + 1;
+			while(next < queue->num && priv_net_send_queue_can_segment(queue, first, next))
+				next++;
+			priv_net_send_queue_fill_msg(queue, num_msgs++, first, next - first);
+			first = next;
+		}
+
+		int sent = 0;
+		while(sent < num_msgs)
+		{
+			const int result = sendmmsg(fd, &queue->msgs[sent], num_msgs - sent, 0);
+			network_stats.sent_syscalls++;
+			if(result > 0)
+			{
+				sent += result;
+				continue;
+			}
+			if(result < 0 && errno == EINTR)
+				continue;
+
+			// like a failed sendto, the datagram is lost. segmented ones
+			// are retried one by one, the route might not allow GSO
+			const msghdr *hdr = &queue->msgs[sent].msg_hdr;
+			for(size_t segment = 0; hdr->msg_controllen && segment < hdr->msg_iovlen; segment++)
+			{
+				sendto(fd, hdr->msg_iov[segment].iov_base, hdr->msg_iov[segment].iov_len, 0, (const sockaddr *)hdr->msg_name, hdr->msg_namelen);
+				network_stats.sent_syscalls++;
+			}
+			sent++;
+		}
+	}
+	queue->num = 0;
+#endif
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
+#if defined(CONF_PLATFORM_LINUX)
+	if(sock->send_queue)
+	{
+		if(priv_net_send_queue_push(sock, addr, data, size))
+		{
+			network_stats.sent_bytes += size;
+			network_stats.sent_packets++;
+			return size;
+		}
+		// keep the order of the packets that can't be queued
+		net_udp_flush(sock);
+	}
+#endif
+
 	int d = -1;
 
 	if(addr->type & NETTYPE_IPV4)
@@ -1102,6 +1317,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 
 	network_stats.sent_bytes += size;
 	network_stats.sent_packets++;
+	network_stats.sent_syscalls++;
 	return d;
 }
 
@@ -1208,6 +1424,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 
 void net_udp_close(NETSOCKET sock)
 {
+	net_udp_set_batching(sock, false);
 	priv_net_close_all_sockets(sock);
 }
 
@@ -274,6 +274,30 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
  */
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
+/**
+ * Makes `net_udp_send` queue the UDP packets of a socket until
+ * `net_udp_flush` is called, so that they can be sent with fewer
+ * system calls. Only supported on Linux, other platforms keep
+ * sending every packet right away.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to change.
+ * @param enabled Whether to queue packets. Disabling it sends the
+ *                queued packets.
+ */
+void net_udp_set_batching(NETSOCKET sock, bool enabled);
+
+/**
+ * Sends all packets queued by `net_udp_send`, using `sendmmsg` and
+ * UDP segmentation offload where available.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to flush.
+ */
+void net_udp_flush(NETSOCKET sock);
+
 /**
  * Receives a packet over an UDP socket.
  *
@@ -31,6 +31,12 @@ void sphore_wait(SEMAPHORE *sem)
 {
 	dbg_assert(WaitForSingleObject((HANDLE)*sem, INFINITE) == WAIT_OBJECT_0, "WaitForSingleObject failure");
 }
+bool sphore_trywait(SEMAPHORE *sem)
+{
+	const DWORD Result = WaitForSingleObject((HANDLE)*sem, 0);
+	dbg_assert(Result == WAIT_OBJECT_0 || Result == WAIT_TIMEOUT, "WaitForSingleObject failure");
+	return Result == WAIT_OBJECT_0;
+}
 void sphore_signal(SEMAPHORE *sem)
 {
 	dbg_assert(ReleaseSemaphore((HANDLE)*sem, 1, nullptr), "ReleaseSemaphore failure");
@@ -56,6 +62,17 @@ void sphore_wait(SEMAPHORE *sem)
 		dbg_assert(errno == EINTR, "sem_wait failure");
 	}
 }
+bool sphore_trywait(SEMAPHORE *sem)
+{
+	while(true)
+	{
+		if(sem_trywait(*sem) == 0)
+			return true;
+		if(errno == EAGAIN)
+			return false;
+		dbg_assert(errno == EINTR, "sem_trywait failure");
+	}
+}
 void sphore_signal(SEMAPHORE *sem)
 {
 	dbg_assert(sem_post(*sem) == 0, "sem_post failure");
@@ -81,6 +98,17 @@ void sphore_wait(SEMAPHORE *sem)
 		dbg_assert(errno == EINTR, "sem_wait failure");
 	}
 }
+bool sphore_trywait(SEMAPHORE *sem)
+{
+	while(true)
+	{
+		if(sem_trywait(sem) == 0)
+			return true;
+		if(errno == EAGAIN)
+			return false;
+		dbg_assert(errno == EINTR, "sem_trywait failure");
+	}
+}
 void sphore_signal(SEMAPHORE *sem)
 {
 	dbg_assert(sem_post(sem) == 0, "sem_post failure");
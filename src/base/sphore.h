@@ -45,6 +45,15 @@ void sphore_init(SEMAPHORE *sem);
  */
 void sphore_wait(SEMAPHORE *sem);
 
+/**
+ * @ingroup Semaphore
+ *
+ * Decrements the semaphore if it is greater than zero, without blocking.
+ *
+ * @return `true` if the semaphore was decremented.
+ */
+bool sphore_trywait(SEMAPHORE *sem);
+
 /**
  * @ingroup Semaphore
  */
@@ -75,6 +84,13 @@ public:
 		sphore_wait(&m_Sem);
 		m_Count.fetch_sub(1);
 	}
+	bool TryWait()
+	{
+		if(!sphore_trywait(&m_Sem))
+			return false;
+		m_Count.fetch_sub(1);
+		return true;
+	}
 	void Signal()
 	{
 		m_Count.fetch_add(1);
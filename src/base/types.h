@@ -191,6 +191,7 @@ typedef struct NETSTATS
 {
 	uint64_t sent_packets;
 	uint64_t sent_bytes;
+	uint64_t sent_syscalls;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
 } NETSTATS;
@@ -4003,6 +4003,7 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 
 	// try to start playback
 	m_DemoPlayer.SetListener(this);
+	m_DemoPlayer.SetReadAhead(g_Config.m_ClDemoReadAhead);
 	if(m_DemoPlayer.Load(Storage(), m_pConsole, pFilename, StorageType))
 	{
 		DisconnectWithReason(m_DemoPlayer.ErrorMessage());
@@ -0,0 +1,265 @@
+#include "graphics_command_list.h"
+
+#include <base/dbg.h>
+#include <base/log.h>
+#include <base/mem.h>
+#include <base/str.h>
+
+#include <typeinfo>
+
+CCommandListBufferPool::~CCommandListBufferPool()
+{
+	for(CCommandBuffer *pBuffer : m_vpFreeBuffers)
+		delete pBuffer;
+}
+
+CCommandBuffer *CCommandListBufferPool::Acquire()
+{
+	const std::unique_lock<std::mutex> Lock(m_Mutex);
+	if(m_vpFreeBuffers.empty())
+		return new CCommandBuffer(CMD_LIST_CMD_BUFFER_SIZE, CMD_LIST_DATA_BUFFER_SIZE);
+	CCommandBuffer *pBuffer = m_vpFreeBuffers.back();
+	m_vpFreeBuffers.pop_back();
+	return pBuffer;
+}
+
+void CCommandListBufferPool::Release(CCommandBuffer *pBuffer)
+{
+	pBuffer->Reset();
+	const std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_vpFreeBuffers.push_back(pBuffer);
+}
+
+CGraphicsCommandList::CGraphicsCommandList(CCommandListBufferPool *pBufferPool, CCommandBuffer::SCommand *pAnchor, const CCommandBuffer::SState &State, int ScreenWidth, int ScreenHeight, TRecordCommandListFunc &&Record) :
+	m_pAnchor(pAnchor),
+	m_pBufferPool(pBufferPool),
+	m_State(State),
+	m_ScreenWidth(ScreenWidth),
+	m_ScreenHeight(ScreenHeight),
+	m_Record(std::move(Record))
+{
+	m_vpBuffers.push_back(m_pBufferPool->Acquire());
+}
+
+void CGraphicsCommandList::Run()
+{
+	if(m_Started.exchange(true))
+		return;
+	m_Record(this);
+	m_Record = nullptr;
+	m_Recorded.Signal();
+}
+
+void CGraphicsCommandList::Finish(bool Record)
+{
+	if(m_Started.exchange(true))
+	{
+		m_Recorded.Wait();
+		return;
+	}
+	if(Record)
+		m_Record(this);
+	m_Record = nullptr;
+}
+
+void CGraphicsCommandList::MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY)
+{
+	m_State.m_ScreenTL.x = TopLeftX;
+	m_State.m_ScreenTL.y = TopLeftY;
+	m_State.m_ScreenBR.x = BottomRightX;
+	m_State.m_ScreenBR.y = BottomRightY;
+}
+
+void CGraphicsCommandList::ClipEnable(int x, int y, int w, int h)
+{
+	m_State.ClipEnable(x, y, w, h, m_ScreenWidth, m_ScreenHeight);
+}
+
+void CGraphicsCommandList::ClipDisable()
+{
+	m_State.m_ClipEnable = false;
+}
+
+void CGraphicsCommandList::BlendNone()
+{
+	m_State.m_BlendMode = EBlendMode::NONE;
+}
+
+void CGraphicsCommandList::BlendNormal()
+{
+	m_State.m_BlendMode = EBlendMode::ALPHA;
+}
+
+void CGraphicsCommandList::BlendAdditive()
+{
+	m_State.m_BlendMode = EBlendMode::ADDITIVE;
+}
+
+void CGraphicsCommandList::WrapNormal()
+{
+	m_State.m_WrapMode = EWrapMode::REPEAT;
+}
+
+void CGraphicsCommandList::WrapClamp()
+{
+	m_State.m_WrapMode = EWrapMode::CLAMP;
+}
+
+void CGraphicsCommandList::TextureSet(IGraphics::CTextureHandle Texture)
+{
+	// the texture indices are not checked, they may be changed by the main thread
+	m_State.m_Texture = Texture.Id();
+}
+
+void CGraphicsCommandList::GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY) const
+{
+	*pTopLeftX = m_State.m_ScreenTL.x;
+	*pTopLeftY = m_State.m_ScreenTL.y;
+	*pBottomRightX = m_State.m_ScreenBR.x;
+	*pBottomRightY = m_State.m_ScreenBR.y;
+}
+
+void *CGraphicsCommandList::AllocData(unsigned WantedSize)
+{
+	void *pData = m_vpBuffers.back()->AllocData(WantedSize);
+	if(pData == nullptr)
+	{
+		m_vpBuffers.push_back(m_pBufferPool->Acquire());
+		pData = m_vpBuffers.back()->AllocData(WantedSize);
+	}
+	return pData;
+}
+
+template<typename TName>
+void CGraphicsCommandList::AddCmd(const TName &Cmd)
+{
+	if(m_vpBuffers.back()->AddCommandUnsafe(Cmd))
+		return;
+
+	// the data of the command may stay in the previous buffer
+	m_vpBuffers.push_back(m_pBufferPool->Acquire());
+	dbg_assert(m_vpBuffers.back()->AddCommandUnsafe(Cmd), "graphics: failed to add command '%s' to command list", typeid(TName).name());
+}
+
+void CGraphicsCommandList::RenderTileLayer(int BufferContainerIndex, const ColorRGBA &Color, char **pOffsets, unsigned int *pIndicedVertexDrawNum, size_t NumIndicesOffset)
+{
+	if(NumIndicesOffset == 0)
+		return;
+
+	CCommandBuffer::SCommand_RenderTileLayer Cmd;
+	Cmd.m_State = m_State;
+	Cmd.m_IndicesDrawNum = NumIndicesOffset;
+	Cmd.m_BufferContainerIndex = BufferContainerIndex;
+	Cmd.m_Color = Color;
+
+	void *pData = AllocData((sizeof(char *) + sizeof(unsigned int)) * NumIndicesOffset);
+	if(pData == nullptr)
+	{
+		log_error("graphics", "Failed to allocate data for tile layer vertices in command list. NumIndicesOffset=%" PRIzu, NumIndicesOffset);
+		return;
+	}
+	Cmd.m_pIndicesOffsets = (char **)pData;
+	Cmd.m_pDrawCount = (unsigned int *)(((char *)pData) + (sizeof(char *) * NumIndicesOffset));
+	mem_copy(Cmd.m_pIndicesOffsets, pOffsets, sizeof(char *) * NumIndicesOffset);
+	mem_copy(Cmd.m_pDrawCount, pIndicedVertexDrawNum, sizeof(unsigned int) * NumIndicesOffset);
+
+	AddCmd(Cmd);
+	m_vpBuffers.back()->AddRenderCalls(NumIndicesOffset);
+}
+
+void CGraphicsCommandList::RenderBorderTiles(int BufferContainerIndex, const ColorRGBA &Color, char *pIndexBufferOffset, const vec2 &Offset, const vec2 &Scale, uint32_t DrawNum)
+{
+	if(DrawNum == 0)
+		return;
+
+	CCommandBuffer::SCommand_RenderBorderTile Cmd;
+	Cmd.m_State = m_State;
+	Cmd.m_DrawNum = DrawNum;
+	Cmd.m_BufferContainerIndex = BufferContainerIndex;
+	Cmd.m_Color = Color;
+	Cmd.m_pIndicesOffset = pIndexBufferOffset;
+	Cmd.m_Offset = Offset;
+	Cmd.m_Scale = Scale;
+
+	AddCmd(Cmd);
+	m_vpBuffers.back()->AddRenderCalls(1);
+}
+
+void CGraphicsCommandList::RenderQuadLayer(int BufferContainerIndex, SQuadRenderInfo *pQuadInfo, size_t QuadNum, int QuadOffset, bool Grouped)
+{
+	if(QuadNum == 0)
+		return;
+
+	CCommandBuffer::SCommand_RenderQuadLayer Cmd(Grouped);
+	Cmd.m_State = m_State;
+	Cmd.m_QuadNum = QuadNum;
+	Cmd.m_QuadOffset = QuadOffset;
+	Cmd.m_BufferContainerIndex = BufferContainerIndex;
+
+	// grouped quads share the render info of the first quad
+	const size_t NumInfos = Grouped ? 1 : QuadNum;
+	Cmd.m_pQuadInfo = (SQuadRenderInfo *)AllocData(NumInfos * sizeof(SQuadRenderInfo));
+	if(Cmd.m_pQuadInfo == nullptr)
+	{
+		log_error("graphics", "Failed to allocate data for quad layer in command list. QuadNum=%" PRIzu, QuadNum);
+		return;
+	}
+	mem_copy(Cmd.m_pQuadInfo, pQuadInfo, sizeof(SQuadRenderInfo) * NumInfos);
+
+	AddCmd(Cmd);
+	m_vpBuffers.back()->AddRenderCalls(Grouped ? 1 : ((QuadNum - 1) / GRAPHICS_MAX_QUADS_RENDER_COUNT) + 1);
+}
+
+CGraphicsCommandLists::~CGraphicsCommandLists()
+{
+	// the jobs of lists that were not merged may still run
+	for(auto &pList : m_vpLists)
+	{
+		pList->Finish(false);
+		for(CCommandBuffer *pBuffer : pList->m_vpBuffers)
+			delete pBuffer;
+	}
+	for(auto &vpUsedBuffers : m_avpUsedBuffers)
+	{
+		for(CCommandBuffer *pBuffer : vpUsedBuffers)
+			delete pBuffer;
+	}
+}
+
+std::shared_ptr<IJob> CGraphicsCommandLists::Add(CCommandBuffer *pFrame, const CCommandBuffer::SState &State, int ScreenWidth, int ScreenHeight, TRecordCommandListFunc &&Record)
+{
+	m_vpLists.push_back(std::make_shared<CGraphicsCommandList>(&m_BufferPool, pFrame->Tail(), State, ScreenWidth, ScreenHeight, std::move(Record)));
+	return m_vpLists.back();
+}
+
+void CGraphicsCommandLists::Merge(CCommandBuffer *pFrame, unsigned FrameIndex)
+{
+	CCommandBuffer::SCommand *pLastAnchor = nullptr;
+	CCommandBuffer::SCommand *pInsertAfter = nullptr;
+	for(size_t i = 0; i < m_vpLists.size(); i++)
+	{
+		CGraphicsCommandList *pList = m_vpLists[i].get();
+		pList->Finish(true);
+
+		// lists added at the same point are inserted after each other
+		if(i == 0 || pList->m_pAnchor != pLastAnchor)
+		{
+			pLastAnchor = pList->m_pAnchor;
+			pInsertAfter = pList->m_pAnchor;
+		}
+		for(CCommandBuffer *pBuffer : pList->m_vpBuffers)
+		{
+			pInsertAfter = pFrame->InsertCommands(pInsertAfter, *pBuffer);
+			m_avpUsedBuffers[FrameIndex].push_back(pBuffer);
+		}
+	}
+	m_vpLists.clear();
+}
+
+void CGraphicsCommandLists::OnKick(unsigned FrameIndex)
+{
+	dbg_assert(m_vpLists.empty(), "graphics: command lists must be merged before kicking");
+	for(CCommandBuffer *pBuffer : m_avpUsedBuffers[FrameIndex])
+		m_BufferPool.Release(pBuffer);
+	m_avpUsedBuffers[FrameIndex].clear();
+}
@@ -0,0 +1,124 @@
+#ifndef ENGINE_CLIENT_GRAPHICS_COMMAND_LIST_H
+#define ENGINE_CLIENT_GRAPHICS_COMMAND_LIST_H
+
+#include "graphics_threaded.h"
+
+#include <base/sphore.h>
+
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// command lists are recorded into smaller buffers, a list takes as many as it needs
+constexpr int CMD_LIST_DATA_BUFFER_SIZE = 1024 * 256;
+constexpr int CMD_LIST_CMD_BUFFER_SIZE = 1024 * 32;
+
+class CCommandListBufferPool
+{
+public:
+	~CCommandListBufferPool();
+
+	CCommandBuffer *Acquire();
+	void Release(CCommandBuffer *pBuffer);
+
+private:
+	std::mutex m_Mutex;
+	std::vector<CCommandBuffer *> m_vpFreeBuffers;
+};
+
+/**
+ * A command list recorded by a job, or by the thread that merges it if no worker started it yet.
+ */
+class CGraphicsCommandList : public IGraphicsCommandList, public IJob
+{
+public:
+	CGraphicsCommandList(CCommandListBufferPool *pBufferPool, CCommandBuffer::SCommand *pAnchor, const CCommandBuffer::SState &State, int ScreenWidth, int ScreenHeight, TRecordCommandListFunc &&Record);
+
+	void MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY) override;
+	void ClipEnable(int x, int y, int w, int h) override;
+	void ClipDisable() override;
+	void BlendNone() override;
+	void BlendNormal() override;
+	void BlendAdditive() override;
+	void WrapNormal() override;
+	void WrapClamp() override;
+	void TextureSet(IGraphics::CTextureHandle Texture) override;
+	void GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY) const override;
+
+	void RenderTileLayer(int BufferContainerIndex, const ColorRGBA &Color, char **pOffsets, unsigned int *pIndicedVertexDrawNum, size_t NumIndicesOffset) override;
+	void RenderBorderTiles(int BufferContainerIndex, const ColorRGBA &Color, char *pIndexBufferOffset, const vec2 &Offset, const vec2 &Scale, uint32_t DrawNum) override;
+	void RenderQuadLayer(int BufferContainerIndex, SQuadRenderInfo *pQuadInfo, size_t QuadNum, int QuadOffset, bool Grouped) override;
+
+	/**
+	 * Records the list on the calling thread if no worker started it, otherwise waits for the worker.
+	 *
+	 * @param Record Whether the list is recorded, it stays empty otherwise.
+	 */
+	void Finish(bool Record);
+
+	// the command of the frame after which the list is inserted, nullptr for the head
+	CCommandBuffer::SCommand *m_pAnchor;
+	std::vector<CCommandBuffer *> m_vpBuffers;
+
+protected:
+	void Run() override;
+
+private:
+	CCommandListBufferPool *m_pBufferPool;
+	CCommandBuffer::SState m_State;
+	int m_ScreenWidth;
+	int m_ScreenHeight;
+	TRecordCommandListFunc m_Record;
+
+	std::atomic<bool> m_Started = false;
+	CSemaphore m_Recorded;
+
+	void *AllocData(unsigned WantedSize);
+	template<typename TName>
+	void AddCmd(const TName &Cmd);
+};
+
+/**
+ * The command lists of the frame that is currently built, and the buffers they use.
+ */
+class CGraphicsCommandLists
+{
+public:
+	~CGraphicsCommandLists();
+
+	/**
+	 * Adds a list at the current end of the frame.
+	 *
+	 * @return The job that records the list.
+	 */
+	std::shared_ptr<IJob> Add(CCommandBuffer *pFrame, const CCommandBuffer::SState &State, int ScreenWidth, int ScreenHeight, TRecordCommandListFunc &&Record);
+
+	/**
+	 * Inserts all lists into the frame, in the order they were added. Lists that no worker
+	 * started yet are recorded on the calling thread, the others are waited for.
+	 *
+	 * @param FrameIndex Index of the frame's command buffer, the buffers of the lists are
+	 * used until it's kicked again.
+	 */
+	void Merge(CCommandBuffer *pFrame, unsigned FrameIndex);
+
+	/**
+	 * Called after a command buffer was kicked, all lists must have been merged into it.
+	 *
+	 * @param FrameIndex Index of the command buffer that is used next, the backend is done with it.
+	 */
+	void OnKick(unsigned FrameIndex);
+
+private:
+	CCommandListBufferPool m_BufferPool;
+	// lists added since the last merge, in the order they were added
+	std::vector<std::shared_ptr<CGraphicsCommandList>> m_vpLists;
+	// buffers of lists that were inserted into the command buffer of the same index
+	std::vector<CCommandBuffer *> m_avpUsedBuffers[2];
+};
+
+#endif
@@ -26,6 +26,7 @@
 #include <engine/shared/video.h>
 #endif
 
+#include "graphics_command_list.h"
 #include "graphics_threaded.h"
 
 class CSemaphore;
@@ -139,21 +140,7 @@ CGraphics_Threaded::CGraphics_Threaded()
 
 void CGraphics_Threaded::ClipEnable(int x, int y, int w, int h)
 {
-	if(x < 0)
-		w += x;
-	if(y < 0)
-		h += y;
-
-	x = std::clamp(x, 0, ScreenWidth());
-	y = std::clamp(y, 0, ScreenHeight());
-	w = std::clamp(w, 0, ScreenWidth() - x);
-	h = std::clamp(h, 0, ScreenHeight() - y);
-
-	m_State.m_ClipEnable = true;
-	m_State.m_ClipX = x;
-	m_State.m_ClipY = ScreenHeight() - (y + h);
-	m_State.m_ClipW = w;
-	m_State.m_ClipH = h;
+	m_State.ClipEnable(x, y, w, h, ScreenWidth(), ScreenHeight());
 }
 
 void CGraphics_Threaded::ClipDisable()
@@ -653,6 +640,8 @@ bool CGraphics_Threaded::IsImageFormatRgba(const char *pContextName, const CImag
 
 void CGraphics_Threaded::KickCommandBuffer()
 {
+	// also when the command buffer is full in the middle of a frame, so the lists keep their place
+	m_pCommandLists->Merge(m_pCommandBuffer, m_CurrentCommandBuffer);
 	m_pBackend->RunBuffer(m_pCommandBuffer);
 
 	std::vector<std::string> WarningStrings;
@@ -670,6 +659,19 @@ void CGraphics_Threaded::KickCommandBuffer()
 	m_CurrentCommandBuffer ^= 1;
 	m_pCommandBuffer = m_apCommandBuffers[m_CurrentCommandBuffer];
 	m_pCommandBuffer->Reset();
+
+	m_pCommandLists->OnKick(m_CurrentCommandBuffer);
+}
+
+void CGraphics_Threaded::RecordCommandList(TRecordCommandListFunc &&Record)
+{
+	dbg_assert(m_Drawing == EDrawing::NONE, "called Graphics()->RecordCommandList within begin");
+	m_pEngine->AddJob(m_pCommandLists->Add(m_pCommandBuffer, m_State, ScreenWidth(), ScreenHeight(), std::move(Record)));
+}
+
+void CGraphics_Threaded::MergeCommandLists()
+{
+	m_pCommandLists->Merge(m_pCommandBuffer, m_CurrentCommandBuffer);
 }
 
 class CScreenshotSaveJob : public IJob
@@ -2443,6 +2445,7 @@ int CGraphics_Threaded::Init()
 	for(auto &pCommandBuffer : m_apCommandBuffers)
 		pCommandBuffer = new CCommandBuffer(CMD_BUFFER_CMD_BUFFER_SIZE, CMD_BUFFER_DATA_BUFFER_SIZE);
 	m_pCommandBuffer = m_apCommandBuffers[0];
+	m_pCommandLists = std::make_unique<CGraphicsCommandLists>();
 
 	// create null texture, will get id=0
 	{
@@ -2499,6 +2502,7 @@ void CGraphics_Threaded::Shutdown()
 	// delete the command buffers
 	for(auto &pCommandBuffer : m_apCommandBuffers)
 		delete pCommandBuffer;
+	m_pCommandLists = nullptr;
 }
 
 int CGraphics_Threaded::GetNumScreens() const
@@ -7,8 +7,10 @@
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -202,6 +204,26 @@ public:
 		int m_ClipY;
 		int m_ClipW;
 		int m_ClipH;
+
+		// clips to a rect of a screen of the given size, in coordinates from the top left
+		void ClipEnable(int x, int y, int w, int h, int ScreenWidth, int ScreenHeight)
+		{
+			if(x < 0)
+				w += x;
+			if(y < 0)
+				h += y;
+
+			x = std::clamp(x, 0, ScreenWidth);
+			y = std::clamp(y, 0, ScreenHeight);
+			w = std::clamp(w, 0, ScreenWidth - x);
+			h = std::clamp(h, 0, ScreenHeight - y);
+
+			m_ClipEnable = true;
+			m_ClipX = x;
+			m_ClipY = ScreenHeight - (y + h);
+			m_ClipW = w;
+			m_ClipH = h;
+		}
 	};
 
 	struct SCommand_Clear : public SCommand
@@ -623,6 +645,32 @@ public:
 
 	const SCommand *Head() const { return m_pCmdBufferHead; }
 	SCommand *Head() { return m_pCmdBufferHead; }
+	SCommand *Tail() { return m_pCmdBufferTail; }
+
+	/**
+	 * Links the commands of another buffer into this one after `pAfter`, or at the head
+	 * if it's `nullptr`. The data of the other buffer is not copied, so it must not be
+	 * reset before this buffer has been processed.
+	 *
+	 * @return The last inserted command, or `pAfter` if the other buffer was empty.
+	 */
+	SCommand *InsertCommands(SCommand *pAfter, CCommandBuffer &Other)
+	{
+		if(!Other.m_pCmdBufferHead)
+			return pAfter;
+
+		Other.m_pCmdBufferTail->m_pNext = pAfter ? pAfter->m_pNext : m_pCmdBufferHead;
+		if(pAfter)
+			pAfter->m_pNext = Other.m_pCmdBufferHead;
+		else
+			m_pCmdBufferHead = Other.m_pCmdBufferHead;
+		if(pAfter == m_pCmdBufferTail)
+			m_pCmdBufferTail = Other.m_pCmdBufferTail;
+
+		m_CommandCount += Other.m_CommandCount;
+		m_RenderCallCount += Other.m_RenderCallCount;
+		return Other.m_pCmdBufferTail;
+	}
 
 	void Reset()
 	{
@@ -763,6 +811,8 @@ class CGraphics_Threaded : public IEngineGraphics
 	CCommandBuffer *m_pCommandBuffer;
 	unsigned m_CurrentCommandBuffer;
 
+	std::unique_ptr<class CGraphicsCommandLists> m_pCommandLists;
+
 	//
 	class IStorage *m_pStorage;
 	class IEngine *m_pEngine;
@@ -945,6 +995,7 @@ public:
 
 	// simple uncompressed RGBA loaders
 	IGraphics::CTextureHandle LoadTexture(const char *pFilename, int StorageType, int Flags = 0) override;
+	IGraphics::CTextureHandle NullTexture() const override { return m_NullTexture; }
 	bool LoadPng(CImageInfo &Image, const char *pFilename, int StorageType) override;
 	bool LoadPng(CImageInfo &Image, const uint8_t *pData, size_t DataSize, const char *pContextName) override;
 
@@ -1188,6 +1239,8 @@ public:
 	void RenderBorderTiles(int BufferContainerIndex, const ColorRGBA &Color, char *pIndexBufferOffset, const vec2 &Offset, const vec2 &Scale, uint32_t DrawNum) override;
 	void RenderQuadLayer(int BufferContainerIndex, SQuadRenderInfo *pQuadInfo, size_t QuadNum, int QuadOffset, bool Grouped = false) override;
 	void RenderText(int BufferContainerIndex, int TextQuadNum, int TextureSize, int TextureTextIndex, int TextureTextOutlineIndex, const ColorRGBA &TextColor, const ColorRGBA &TextOutlineColor) override;
+	void RecordCommandList(TRecordCommandListFunc &&Record) override;
+	void MergeCommandLists() override;
 
 	// modern GL functions
 	int CreateBufferObject(size_t UploadDataSize, void *pUploadData, int CreateFlags, bool IsMovedPointer = false) override;
@@ -2,6 +2,8 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "sound.h"
 
+#include "sound_mix.h"
+
 #include <base/bytes.h>
 #include <base/dbg.h>
 #include <base/log.h>
@@ -23,48 +25,153 @@ extern "C" {
 #include <wavpack.h>
 }
 
+#include <algorithm>
 #include <cmath>
 
 static constexpr int SAMPLE_INDEX_USED = -2;
 static constexpr int SAMPLE_INDEX_FULL = -1;
 
+void CSound::PushCommand(const CVoiceCommand &Command)
+{
+	// without an audio device there is no mixer that could play the voices
+	if(m_Device == 0)
+		return;
+
+	const unsigned Written = m_CommandsWritten.load(std::memory_order_relaxed);
+	if(Written - m_CommandsRead.load(std::memory_order_acquire) == NUM_COMMANDS)
+	{
+		// the mixer doesn't keep up or the audio device is paused, take the commands instead of it
+		const CLockScope LockScope(m_MixLock);
+		RunCommands();
+	}
+	m_aCommands[Written % NUM_COMMANDS] = Command;
+	m_CommandsWritten.store(Written + 1, std::memory_order_release);
+}
+
+void CSound::RunCommands()
+{
+	const unsigned Written = m_CommandsWritten.load(std::memory_order_acquire);
+	unsigned Read = m_CommandsRead.load(std::memory_order_relaxed);
+	for(; Read != Written; Read++)
+	{
+		const CVoiceCommand &Command = m_aCommands[Read % NUM_COMMANDS];
+		if(Command.m_Type == CVoiceCommand::SET_CHANNEL)
+		{
+			m_aMixChannels[Command.m_Id] = Command.m_Channel;
+			continue;
+		}
+
+		CVoice &Voice = m_aMixVoices[Command.m_Id];
+		if(Command.m_Type == CVoiceCommand::PLAY)
+		{
+			Voice = Command.m_Voice;
+			continue;
+		}
+		// the voice ended in the mixer before the game changed it
+		if(!Voice.m_pSample || Voice.m_Age != Command.m_Voice.m_Age)
+			continue;
+
+		switch(Command.m_Type)
+		{
+		case CVoiceCommand::UPDATE:
+			Voice.m_Vol = Command.m_Voice.m_Vol;
+			Voice.m_Position = Command.m_Voice.m_Position;
+			Voice.m_Falloff = Command.m_Voice.m_Falloff;
+			Voice.m_Shape = Command.m_Voice.m_Shape;
+			if(Voice.m_Shape == ISound::SHAPE_CIRCLE)
+				Voice.m_Circle = Command.m_Voice.m_Circle;
+			else
+				Voice.m_Rectangle = Command.m_Voice.m_Rectangle;
+			break;
+		case CVoiceCommand::SET_TICK:
+			Voice.m_Tick = Command.m_Voice.m_Tick;
+			break;
+		case CVoiceCommand::STOP:
+			Voice.m_pSample = nullptr;
+			Voice.m_pData = nullptr;
+			break;
+		}
+	}
+	// the sample data of the stopped voices is not used anymore from here on
+	m_CommandsRead.store(Read, std::memory_order_release);
+}
+
+void CSound::UpdateVoices()
+{
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
+	{
+		CVoice &Voice = m_aVoices[VoiceId];
+		// ages of voices that the mixer didn't start yet don't match
+		if(!Voice.m_pSample || m_aMixedAges[VoiceId].load(std::memory_order_acquire) != Voice.m_Age)
+			continue;
+
+		const int Tick = m_aMixedTicks[VoiceId].load(std::memory_order_relaxed);
+		if(Tick < 0)
+		{
+			Voice.m_pSample = nullptr;
+			Voice.m_Age++;
+		}
+		else
+		{
+			Voice.m_Tick = Tick;
+		}
+	}
+
+	const unsigned Read = m_CommandsRead.load(std::memory_order_acquire);
+	auto RetiredEnd = std::remove_if(m_vRetiredSampleData.begin(), m_vRetiredSampleData.end(), [&](const CRetiredSampleData &Retired) {
+		if(m_Device != 0 && (int)(Read - Retired.m_Command) < 0)
+			return false;
+		free(Retired.m_pData);
+		return true;
+	});
+	m_vRetiredSampleData.erase(RetiredEnd, m_vRetiredSampleData.end());
+}
+
+void CSound::PushVoiceCommand(int Type, int VoiceId)
+{
+	CVoiceCommand Command = {};
+	Command.m_Type = Type;
+	Command.m_Id = VoiceId;
+	Command.m_Voice = m_aVoices[VoiceId];
+	PushCommand(Command);
+}
+
+void CSound::StopVoiceLocked(int VoiceId)
+{
+	PushVoiceCommand(CVoiceCommand::STOP, VoiceId);
+	m_aVoices[VoiceId].m_pSample = nullptr;
+	m_aVoices[VoiceId].m_Age++;
+}
+
 void CSound::Mix(short *pFinalOut, unsigned Frames)
 {
 	Frames = minimum(Frames, m_MaxFrames);
 	mem_zero(m_pMixBuffer, Frames * 2 * sizeof(int));
 
-	// acquire lock while we are mixing
-	m_SoundLock.lock();
+	// the game never waits for the mixer, it only hands over the voice changes
+	const CLockScope LockScope(m_MixLock);
+	RunCommands();
 
 	const int MasterVol = m_SoundVolume.load(std::memory_order_relaxed);
 
-	for(auto &Voice : m_aVoices)
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 	{
+		CVoice &Voice = m_aMixVoices[VoiceId];
 		if(!Voice.m_pSample)
 			continue;
 
-		// mix voice
-		int *pOut = m_pMixBuffer;
-
-		const int Step = Voice.m_pSample->m_Channels; // setup input sources
-		short *pInL = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
-		short *pInR = &Voice.m_pSample->m_pData[Voice.m_Tick * Step + 1];
+		const CChannel &Channel = m_aMixChannels[Voice.m_Channel];
+		unsigned End = Voice.m_NumFrames - Voice.m_Tick;
 
-		unsigned End = Voice.m_pSample->m_NumFrames - Voice.m_Tick;
-
-		int VolumeR = round_truncate(Voice.m_pChannel->m_Vol * (Voice.m_Vol / 255.0f));
+		int VolumeR = round_truncate(Channel.m_Vol * (Voice.m_Vol / 255.0f));
 		int VolumeL = VolumeR;
 
 		// make sure that we don't go outside the sound data
 		if(Frames < End)
 			End = Frames;
 
-		// check if we have a mono sound
-		if(Voice.m_pSample->m_Channels == 1)
-			pInR = pInL;
-
 		// volume calculation
-		if(Voice.m_Flags & ISound::FLAG_POS && Voice.m_pChannel->m_Pan)
+		if(Voice.m_Flags & ISound::FLAG_POS && Channel.m_Pan)
 		{
 			// TODO: we should respect the channel panning value
 			const vec2 Delta = Voice.m_Position - vec2(m_ListenerPositionX.load(std::memory_order_relaxed), m_ListenerPositionY.load(std::memory_order_relaxed));
@@ -135,36 +242,32 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 			}
 		}
 
-		// process all frames
-		for(unsigned s = 0; s < End; s++)
+		// process all frames, voices out of range only advance
+		if(VolumeL != 0 || VolumeR != 0)
 		{
-			*pOut++ += (*pInL) * VolumeL;
-			*pOut++ += (*pInR) * VolumeR;
-			pInL += Step;
-			pInR += Step;
-			Voice.m_Tick++;
+			SoundMixVoice(m_pMixBuffer, &Voice.m_pData[Voice.m_Tick * Voice.m_Channels], Voice.m_Channels, End, VolumeL, VolumeR);
 		}
+		Voice.m_Tick += End;
 
-		// free voice if not used any more
-		if(Voice.m_Tick == Voice.m_pSample->m_NumFrames)
+		// free voice if not used any more, the game frees it when it sees the end
+		if(Voice.m_Tick == Voice.m_NumFrames)
 		{
 			if(Voice.m_Flags & ISound::FLAG_LOOP)
 			{
-				Voice.m_Tick = Voice.m_pSample->m_LoopStart;
+				Voice.m_Tick = Voice.m_LoopStart;
 			}
 			else
 			{
 				Voice.m_pSample = nullptr;
-				Voice.m_Age++;
+				Voice.m_pData = nullptr;
 			}
 		}
+		m_aMixedTicks[VoiceId].store(Voice.m_pSample ? Voice.m_Tick : -1, std::memory_order_relaxed);
+		m_aMixedAges[VoiceId].store(Voice.m_Age, std::memory_order_release);
 	}
 
-	m_SoundLock.unlock();
-
 	// clamp accumulated values
-	for(unsigned i = 0; i < Frames * 2; i++)
-		pFinalOut[i] = std::clamp<int>(((m_pMixBuffer[i] * MasterVol) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+	SoundMixToOutput(pFinalOut, m_pMixBuffer, Frames * 2, MasterVol);
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
@@ -195,18 +298,24 @@ int CSound::Init()
 	m_pGraphics = Kernel()->RequestInterface<IEngineGraphics>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 
-	// Initialize sample indices. We always need them to load sounds in
-	// the editor even if sound is disabled or failed to be enabled.
-	const CLockScope LockScope(m_SoundLock);
-	m_FirstFreeSampleIndex = 0;
-	for(size_t i = 0; i < std::size(m_aSamples) - 1; ++i)
 	{
-		m_aSamples[i].m_Index = i;
-		m_aSamples[i].m_NextFreeSampleIndex = i + 1;
-		m_aSamples[i].m_pData = nullptr;
+		// Initialize sample indices. We always need them to load sounds in
+		// the editor even if sound is disabled or failed to be enabled.
+		const CLockScope LockScope(m_SoundLock);
+		m_FirstFreeSampleIndex = 0;
+		for(size_t i = 0; i < std::size(m_aSamples) - 1; ++i)
+		{
+			m_aSamples[i].m_Index = i;
+			m_aSamples[i].m_NextFreeSampleIndex = i + 1;
+			m_aSamples[i].m_pData = nullptr;
+		}
+		m_aSamples[std::size(m_aSamples) - 1].m_Index = std::size(m_aSamples) - 1;
+		m_aSamples[std::size(m_aSamples) - 1].m_NextFreeSampleIndex = SAMPLE_INDEX_FULL;
 	}
-	m_aSamples[std::size(m_aSamples) - 1].m_Index = std::size(m_aSamples) - 1;
-	m_aSamples[std::size(m_aSamples) - 1].m_NextFreeSampleIndex = SAMPLE_INDEX_FULL;
+
+	// no voice was mixed yet
+	for(auto &MixedAge : m_aMixedAges)
+		MixedAge.store(-1, std::memory_order_relaxed);
 
 	if(!g_Config.m_SndEnable)
 		return 0;
@@ -254,6 +363,9 @@ int CSound::Init()
 int CSound::Update()
 {
 	UpdateVolume();
+
+	const CLockScope LockScope(m_SoundLock);
+	UpdateVoices();
 	return 0;
 }
 
@@ -275,6 +387,7 @@ void CSound::Shutdown()
 	m_Device = 0;
 
 	const CLockScope LockScope(m_SoundLock);
+	UpdateVoices();
 	for(auto &Sample : m_aSamples)
 	{
 		free(Sample.m_pData);
@@ -681,17 +794,19 @@ void CSound::UnloadSample(int SampleId)
 	if(Sample.IsLoaded())
 	{
 		// Stop voices using this sample
-		for(auto &Voice : m_aVoices)
+		UpdateVoices();
+		for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 		{
-			if(Voice.m_pSample == &Sample)
+			if(m_aVoices[VoiceId].m_pSample == &Sample)
 			{
-				Voice.m_pSample = nullptr;
+				StopVoiceLocked(VoiceId);
 			}
 		}
 
-		// Free data
-		free(Sample.m_pData);
+		// Free data once the mixer stopped these voices
+		m_vRetiredSampleData.push_back({Sample.m_pData, m_CommandsWritten.load(std::memory_order_relaxed)});
 		Sample.m_pData = nullptr;
+		UpdateVoices();
 	}
 
 	// Free slot
@@ -718,6 +833,7 @@ float CSound::GetSampleCurrentTime(int SampleId)
 	const CLockScope LockScope(m_SoundLock);
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	CSample *pSample = &m_aSamples[SampleId];
+	UpdateVoices();
 	for(auto &Voice : m_aVoices)
 	{
 		if(Voice.m_pSample == pSample)
@@ -736,11 +852,13 @@ void CSound::SetSampleCurrentTime(int SampleId, float Time)
 	const CLockScope LockScope(m_SoundLock);
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	CSample *pSample = &m_aSamples[SampleId];
-	for(auto &Voice : m_aVoices)
+	UpdateVoices();
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 	{
-		if(Voice.m_pSample == pSample)
+		if(m_aVoices[VoiceId].m_pSample == pSample)
 		{
-			Voice.m_Tick = pSample->m_NumFrames * Time;
+			m_aVoices[VoiceId].m_Tick = pSample->m_NumFrames * Time;
+			PushVoiceCommand(CVoiceCommand::SET_TICK, VoiceId);
 			return;
 		}
 	}
@@ -752,9 +870,14 @@ void CSound::SetChannel(int ChannelId, float Vol, float Pan)
 {
 	dbg_assert(ChannelId >= 0 && ChannelId < NUM_CHANNELS, "ChannelId invalid");
 
+	CVoiceCommand Command = {};
+	Command.m_Type = CVoiceCommand::SET_CHANNEL;
+	Command.m_Id = ChannelId;
+	Command.m_Channel.m_Vol = (int)(Vol * 255.0f);
+	Command.m_Channel.m_Pan = (int)(Pan * 255.0f); // TODO: this is only on and off right now
+
 	const CLockScope LockScope(m_SoundLock);
-	m_aChannels[ChannelId].m_Vol = (int)(Vol * 255.0f);
-	m_aChannels[ChannelId].m_Pan = (int)(Pan * 255.0f); // TODO: this is only on and off right now
+	PushCommand(Command);
 }
 
 void CSound::SetListenerPosition(vec2 Position)
@@ -776,6 +899,7 @@ void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
 
 	Volume = std::clamp(Volume, 0.0f, 1.0f);
 	m_aVoices[VoiceId].m_Vol = (int)(Volume * 255.0f);
+	PushVoiceCommand(CVoiceCommand::UPDATE, VoiceId);
 }
 
 void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
@@ -791,6 +915,7 @@ void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
 
 	Falloff = std::clamp(Falloff, 0.0f, 1.0f);
 	m_aVoices[VoiceId].m_Falloff = Falloff;
+	PushVoiceCommand(CVoiceCommand::UPDATE, VoiceId);
 }
 
 void CSound::SetVoicePosition(CVoiceHandle Voice, vec2 Position)
@@ -805,6 +930,7 @@ void CSound::SetVoicePosition(CVoiceHandle Voice, vec2 Position)
 		return;
 
 	m_aVoices[VoiceId].m_Position = Position;
+	PushVoiceCommand(CVoiceCommand::UPDATE, VoiceId);
 }
 
 void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset)
@@ -818,6 +944,7 @@ void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset)
 	if(m_aVoices[VoiceId].m_Age != Voice.Age())
 		return;
 
+	UpdateVoices();
 	if(!m_aVoices[VoiceId].m_pSample)
 		return;
 
@@ -856,6 +983,7 @@ void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset)
 		if(!(IsLooping && (minimum(m_aVoices[VoiceId].m_Tick, Tick) + m_aVoices[VoiceId].m_pSample->m_NumFrames - maximum(m_aVoices[VoiceId].m_Tick, Tick)) <= Threshold))
 		{
 			m_aVoices[VoiceId].m_Tick = Tick;
+			PushVoiceCommand(CVoiceCommand::SET_TICK, VoiceId);
 		}
 	}
 }
@@ -873,6 +1001,7 @@ void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
 
 	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_CIRCLE;
 	m_aVoices[VoiceId].m_Circle.m_Radius = maximum(0.0f, Radius);
+	PushVoiceCommand(CVoiceCommand::UPDATE, VoiceId);
 }
 
 void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
@@ -889,11 +1018,13 @@ void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
 	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_RECTANGLE;
 	m_aVoices[VoiceId].m_Rectangle.m_Width = maximum(0.0f, Width);
 	m_aVoices[VoiceId].m_Rectangle.m_Height = maximum(0.0f, Height);
+	PushVoiceCommand(CVoiceCommand::UPDATE, VoiceId);
 }
 
 ISound::CVoiceHandle CSound::Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position)
 {
 	const CLockScope LockScope(m_SoundLock);
+	UpdateVoices();
 
 	// search for voice
 	int VoiceId = -1;
@@ -914,7 +1045,11 @@ ISound::CVoiceHandle CSound::Play(int ChannelId, int SampleId, int Flags, float
 
 	// voice found, use it
 	m_aVoices[VoiceId].m_pSample = &m_aSamples[SampleId];
-	m_aVoices[VoiceId].m_pChannel = &m_aChannels[ChannelId];
+	m_aVoices[VoiceId].m_pData = m_aSamples[SampleId].m_pData;
+	m_aVoices[VoiceId].m_NumFrames = m_aSamples[SampleId].m_NumFrames;
+	m_aVoices[VoiceId].m_Channels = m_aSamples[SampleId].m_Channels;
+	m_aVoices[VoiceId].m_LoopStart = m_aSamples[SampleId].m_LoopStart;
+	m_aVoices[VoiceId].m_Channel = ChannelId;
 	if(Flags & FLAG_LOOP)
 	{
 		m_aVoices[VoiceId].m_Tick = m_aSamples[SampleId].m_PausedAt;
@@ -934,6 +1069,7 @@ ISound::CVoiceHandle CSound::Play(int ChannelId, int SampleId, int Flags, float
 	m_aVoices[VoiceId].m_Falloff = 0.0f;
 	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_CIRCLE;
 	m_aVoices[VoiceId].m_Circle.m_Radius = 1500;
+	PushVoiceCommand(CVoiceCommand::PLAY, VoiceId);
 	return CreateVoiceHandle(VoiceId, m_aVoices[VoiceId].m_Age);
 }
 
@@ -955,12 +1091,13 @@ void CSound::Pause(int SampleId)
 	const CLockScope LockScope(m_SoundLock);
 	CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
-	for(auto &Voice : m_aVoices)
+	UpdateVoices();
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 	{
-		if(Voice.m_pSample == pSample)
+		if(m_aVoices[VoiceId].m_pSample == pSample)
 		{
-			Voice.m_pSample->m_PausedAt = Voice.m_Tick;
-			Voice.m_pSample = nullptr;
+			pSample->m_PausedAt = m_aVoices[VoiceId].m_Tick;
+			StopVoiceLocked(VoiceId);
 		}
 	}
 }
@@ -973,15 +1110,17 @@ void CSound::Stop(int SampleId)
 	const CLockScope LockScope(m_SoundLock);
 	CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
-	for(auto &Voice : m_aVoices)
+	UpdateVoices();
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 	{
+		CVoice &Voice = m_aVoices[VoiceId];
 		if(Voice.m_pSample == pSample)
 		{
 			if(Voice.m_Flags & FLAG_LOOP)
-				Voice.m_pSample->m_PausedAt = Voice.m_Tick;
+				pSample->m_PausedAt = Voice.m_Tick;
 			else
-				Voice.m_pSample->m_PausedAt = 0;
-			Voice.m_pSample = nullptr;
+				pSample->m_PausedAt = 0;
+			StopVoiceLocked(VoiceId);
 		}
 	}
 }
@@ -990,16 +1129,18 @@ void CSound::StopAll()
 {
 	// TODO: a nice fade out
 	const CLockScope LockScope(m_SoundLock);
-	for(auto &Voice : m_aVoices)
+	UpdateVoices();
+	for(int VoiceId = 0; VoiceId < NUM_VOICES; VoiceId++)
 	{
+		CVoice &Voice = m_aVoices[VoiceId];
 		if(Voice.m_pSample)
 		{
 			if(Voice.m_Flags & FLAG_LOOP)
 				Voice.m_pSample->m_PausedAt = Voice.m_Tick;
 			else
 				Voice.m_pSample->m_PausedAt = 0;
+			StopVoiceLocked(VoiceId);
 		}
-		Voice.m_pSample = nullptr;
 	}
 }
 
@@ -1011,11 +1152,10 @@ void CSound::StopVoice(CVoiceHandle Voice)
 	int VoiceId = Voice.Id();
 
 	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
+	if(m_aVoices[VoiceId].m_Age != Voice.Age() || !m_aVoices[VoiceId].m_pSample)
 		return;
 
-	m_aVoices[VoiceId].m_pSample = nullptr;
-	m_aVoices[VoiceId].m_Age++;
+	StopVoiceLocked(VoiceId);
 }
 
 bool CSound::IsPlaying(int SampleId)
@@ -1024,6 +1164,7 @@ bool CSound::IsPlaying(int SampleId)
 	const CLockScope LockScope(m_SoundLock);
 	const CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
+	UpdateVoices();
 	return std::any_of(std::begin(m_aVoices), std::end(m_aVoices), [pSample](const auto &Voice) { return Voice.m_pSample == pSample; });
 }
 
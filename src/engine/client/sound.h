@@ -10,6 +10,7 @@
 #include <SDL_audio.h>
 
 #include <atomic>
+#include <vector>
 
 struct CSample
 {
@@ -43,7 +44,13 @@ struct CChannel
 struct CVoice
 {
 	CSample *m_pSample;
-	CChannel *m_pChannel;
+	// copied from the sample, the mixer never reads the samples
+	const short *m_pData;
+	int m_NumFrames;
+	int m_Channels;
+	int m_LoopStart;
+
+	int m_Channel;
 	int m_Age; // increases when reused
 	int m_Tick;
 	int m_Vol; // 0 - 255
@@ -59,6 +66,31 @@ struct CVoice
 	};
 };
 
+// a change of the voices, from the game to the mixer
+struct CVoiceCommand
+{
+	enum
+	{
+		PLAY,
+		UPDATE, // volume, falloff, position and shape
+		SET_TICK,
+		STOP,
+		SET_CHANNEL,
+	};
+
+	int m_Type;
+	int m_Id; // voice or channel
+	CVoice m_Voice; // m_Age must match the voice, except for PLAY
+	CChannel m_Channel;
+};
+
+// sample data that is freed once the mixer took the commands that stop its voices
+struct CRetiredSampleData
+{
+	short *m_pData;
+	unsigned m_Command;
+};
+
 class CSound : public IEngineSound
 {
 	enum
@@ -66,20 +98,40 @@ class CSound : public IEngineSound
 		NUM_SAMPLES = 512,
 		NUM_VOICES = 256,
 		NUM_CHANNELS = 16,
+		NUM_COMMANDS = 1024,
 	};
 
 	bool m_SoundEnabled = false;
 	SDL_AudioDeviceID m_Device = 0;
+	// Guards the state of the game side. The mixer never takes it, the voice
+	// changes reach it through the command queue.
 	CLock m_SoundLock;
+	// Taken by the mixing thread for the whole mix and only by the game side
+	// if the mixer didn't take the queued commands in time.
+	CLock m_MixLock ACQUIRED_AFTER(m_SoundLock);
 
 	CSample m_aSamples[NUM_SAMPLES] GUARDED_BY(m_SoundLock) = {{0}};
 	int m_FirstFreeSampleIndex GUARDED_BY(m_SoundLock) = 0;
 
 	CVoice m_aVoices[NUM_VOICES] GUARDED_BY(m_SoundLock) = {{nullptr}};
-	CChannel m_aChannels[NUM_CHANNELS] GUARDED_BY(m_SoundLock) = {{255, 0}};
 	int m_NextVoice GUARDED_BY(m_SoundLock) = 0;
+	std::vector<CRetiredSampleData> m_vRetiredSampleData GUARDED_BY(m_SoundLock);
 	uint32_t m_MaxFrames = 0;
 
+	// single producer, single consumer queue, written with m_SoundLock and read with m_MixLock
+	CVoiceCommand m_aCommands[NUM_COMMANDS];
+	std::atomic<unsigned> m_CommandsWritten = 0;
+	std::atomic<unsigned> m_CommandsRead = 0;
+
+	// the voices and channels as the mixer plays them
+	CVoice m_aMixVoices[NUM_VOICES] GUARDED_BY(m_MixLock) = {{nullptr}};
+	CChannel m_aMixChannels[NUM_CHANNELS] GUARDED_BY(m_MixLock) = {{255, 0}};
+	// Published by the mixer after every mix: the tick of the voice, or -1 if it
+	// ended, and the age of the voice that the tick belongs to. The age is stored
+	// last, so a matching age guarantees a tick of that voice.
+	std::atomic<int> m_aMixedTicks[NUM_VOICES];
+	std::atomic<int> m_aMixedAges[NUM_VOICES];
+
 	// This is not an std::atomic<vec2> as this would require linking with
 	// libatomic with clang x86 as there is no native support for this.
 	std::atomic<float> m_ListenerPositionX = 0.0f;
@@ -101,45 +153,53 @@ class CSound : public IEngineSound
 
 	void UpdateVolume();
 
+	void PushCommand(const CVoiceCommand &Command) REQUIRES(m_SoundLock, !m_MixLock);
+	void RunCommands() REQUIRES(m_MixLock);
+	// frees the voices that the mixer ended and the sample data it no longer uses
+	void UpdateVoices() REQUIRES(m_SoundLock);
+	// hands the current state of the voice to the mixer
+	void PushVoiceCommand(int Type, int VoiceId) REQUIRES(m_SoundLock, !m_MixLock);
+	void StopVoiceLocked(int VoiceId) REQUIRES(m_SoundLock, !m_MixLock);
+
 public:
-	int Init() override REQUIRES(!m_SoundLock);
-	int Update() override;
-	void Shutdown() override REQUIRES(!m_SoundLock);
+	int Init() override REQUIRES(!m_SoundLock, !m_MixLock);
+	int Update() override REQUIRES(!m_SoundLock, !m_MixLock);
+	void Shutdown() override REQUIRES(!m_SoundLock, !m_MixLock);
 
 	bool IsSoundEnabled() override { return m_SoundEnabled; }
 
-	int LoadOpus(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock);
-	int LoadWV(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock);
-	int LoadOpusFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock);
-	int LoadWVFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock);
-	void UnloadSample(int SampleId) override REQUIRES(!m_SoundLock);
+	int LoadOpus(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock, !m_MixLock);
+	int LoadWV(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock, !m_MixLock);
+	int LoadOpusFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock, !m_MixLock);
+	int LoadWVFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void UnloadSample(int SampleId) override REQUIRES(!m_SoundLock, !m_MixLock);
 
 	float GetSampleTotalTime(int SampleId) override REQUIRES(!m_SoundLock); // in s
-	float GetSampleCurrentTime(int SampleId) override REQUIRES(!m_SoundLock); // in s
-	void SetSampleCurrentTime(int SampleId, float Time) override REQUIRES(!m_SoundLock);
+	float GetSampleCurrentTime(int SampleId) override REQUIRES(!m_SoundLock, !m_MixLock); // in s
+	void SetSampleCurrentTime(int SampleId, float Time) override REQUIRES(!m_SoundLock, !m_MixLock);
 
-	void SetChannel(int ChannelId, float Vol, float Pan) override REQUIRES(!m_SoundLock);
+	void SetChannel(int ChannelId, float Vol, float Pan) override REQUIRES(!m_SoundLock, !m_MixLock);
 	void SetListenerPosition(vec2 Position) override;
 
-	void SetVoiceVolume(CVoiceHandle Voice, float Volume) override REQUIRES(!m_SoundLock);
-	void SetVoiceFalloff(CVoiceHandle Voice, float Falloff) override REQUIRES(!m_SoundLock);
-	void SetVoicePosition(CVoiceHandle Voice, vec2 Position) override REQUIRES(!m_SoundLock);
-	void SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset) override REQUIRES(!m_SoundLock); // in s
+	void SetVoiceVolume(CVoiceHandle Voice, float Volume) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void SetVoiceFalloff(CVoiceHandle Voice, float Falloff) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void SetVoicePosition(CVoiceHandle Voice, vec2 Position) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset) override REQUIRES(!m_SoundLock, !m_MixLock); // in s
 
-	void SetVoiceCircle(CVoiceHandle Voice, float Radius) override REQUIRES(!m_SoundLock);
-	void SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height) override REQUIRES(!m_SoundLock);
+	void SetVoiceCircle(CVoiceHandle Voice, float Radius) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height) override REQUIRES(!m_SoundLock, !m_MixLock);
 
-	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) REQUIRES(!m_SoundLock);
-	CVoiceHandle PlayAt(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) override REQUIRES(!m_SoundLock);
-	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume) override REQUIRES(!m_SoundLock);
-	void Pause(int SampleId) override REQUIRES(!m_SoundLock);
-	void Stop(int SampleId) override REQUIRES(!m_SoundLock);
-	void StopAll() override REQUIRES(!m_SoundLock);
-	void StopVoice(CVoiceHandle Voice) override REQUIRES(!m_SoundLock);
-	bool IsPlaying(int SampleId) override REQUIRES(!m_SoundLock);
+	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) REQUIRES(!m_SoundLock, !m_MixLock);
+	CVoiceHandle PlayAt(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) override REQUIRES(!m_SoundLock, !m_MixLock);
+	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void Pause(int SampleId) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void Stop(int SampleId) override REQUIRES(!m_SoundLock, !m_MixLock);
+	void StopAll() override REQUIRES(!m_SoundLock, !m_MixLock);
+	void StopVoice(CVoiceHandle Voice) override REQUIRES(!m_SoundLock, !m_MixLock);
+	bool IsPlaying(int SampleId) override REQUIRES(!m_SoundLock, !m_MixLock);
 
 	int MixingRate() const override { return m_MixingRate; }
-	void Mix(short *pFinalOut, unsigned Frames) override REQUIRES(!m_SoundLock);
+	void Mix(short *pFinalOut, unsigned Frames) override REQUIRES(!m_MixLock);
 
 	void PauseAudioDevice() override;
 	void UnpauseAudioDevice() override;
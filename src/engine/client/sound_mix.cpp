@@ -0,0 +1,104 @@
+#include "sound_mix.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOUND_MIX_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SOUND_MIX_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(SOUND_MIX_SIMD_SSE2)
+// adds 4 stereo frames, `Volume` holds alternating left and right volumes
+static inline void MixStereo4(int *pOut, __m128i In, __m128i Volume)
+{
+	// full 32 bit products from the low and high halves of the 16 bit multiplication
+	const __m128i Lo = _mm_mullo_epi16(In, Volume);
+	const __m128i Hi = _mm_mulhi_epi16(In, Volume);
+	__m128i *pOut0 = (__m128i *)pOut;
+	__m128i *pOut1 = (__m128i *)(pOut + 4);
+	_mm_storeu_si128(pOut0, _mm_add_epi32(_mm_loadu_si128(pOut0), _mm_unpacklo_epi16(Lo, Hi)));
+	_mm_storeu_si128(pOut1, _mm_add_epi32(_mm_loadu_si128(pOut1), _mm_unpackhi_epi16(Lo, Hi)));
+}
+#elif defined(SOUND_MIX_SIMD_NEON)
+static inline void MixStereo4(int *pOut, int16x8_t In, int16x8_t Volume)
+{
+	vst1q_s32(pOut, vaddq_s32(vld1q_s32(pOut), vmull_s16(vget_low_s16(In), vget_low_s16(Volume))));
+	vst1q_s32(pOut + 4, vaddq_s32(vld1q_s32(pOut + 4), vmull_high_s16(In, Volume)));
+}
+#endif
+
+void SoundMixVoice(int *pMixBuffer, const short *pData, int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	unsigned i = 0;
+#if defined(SOUND_MIX_SIMD_SSE2) || defined(SOUND_MIX_SIMD_NEON)
+	// the vector multiplication takes 16 bit volumes, which the channel and voice volumes always fit in
+	const bool VolumeLFits = VolumeL >= std::numeric_limits<short>::min() && VolumeL <= std::numeric_limits<short>::max();
+	const bool VolumeRFits = VolumeR >= std::numeric_limits<short>::min() && VolumeR <= std::numeric_limits<short>::max();
+	if(VolumeLFits && VolumeRFits)
+	{
+#if defined(SOUND_MIX_SIMD_SSE2)
+		const __m128i Volume = _mm_set_epi16(VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL);
+		if(Channels == 1)
+		{
+			for(; i + 8 <= Frames; i += 8)
+			{
+				const __m128i In = _mm_loadu_si128((const __m128i *)(pData + i));
+				MixStereo4(pMixBuffer + i * 2, _mm_unpacklo_epi16(In, In), Volume);
+				MixStereo4(pMixBuffer + i * 2 + 8, _mm_unpackhi_epi16(In, In), Volume);
+			}
+		}
+		else
+		{
+			for(; i + 4 <= Frames; i += 4)
+				MixStereo4(pMixBuffer + i * 2, _mm_loadu_si128((const __m128i *)(pData + i * 2)), Volume);
+		}
+#else
+		const short aVolume[8] = {(short)VolumeL, (short)VolumeR, (short)VolumeL, (short)VolumeR, (short)VolumeL, (short)VolumeR, (short)VolumeL, (short)VolumeR};
+		const int16x8_t Volume = vld1q_s16(aVolume);
+		if(Channels == 1)
+		{
+			for(; i + 8 <= Frames; i += 8)
+			{
+				const int16x8_t In = vld1q_s16(pData + i);
+				MixStereo4(pMixBuffer + i * 2, vzip1q_s16(In, In), Volume);
+				MixStereo4(pMixBuffer + i * 2 + 8, vzip2q_s16(In, In), Volume);
+			}
+		}
+		else
+		{
+			for(; i + 4 <= Frames; i += 4)
+				MixStereo4(pMixBuffer + i * 2, vld1q_s16(pData + i * 2), Volume);
+		}
+#endif
+	}
+#endif
+
+	// remaining frames
+	int *pOut = pMixBuffer + i * 2;
+	if(Channels == 1)
+	{
+		for(; i < Frames; i++)
+		{
+			*pOut++ += pData[i] * VolumeL;
+			*pOut++ += pData[i] * VolumeR;
+		}
+	}
+	else
+	{
+		for(; i < Frames; i++)
+		{
+			*pOut++ += pData[i * 2] * VolumeL;
+			*pOut++ += pData[i * 2 + 1] * VolumeR;
+		}
+	}
+}
+
+void SoundMixToOutput(short *pFinalOut, const int *pMixBuffer, unsigned Samples, int MasterVolume)
+{
+	for(unsigned i = 0; i < Samples; i++)
+		pFinalOut[i] = std::clamp<int>(((pMixBuffer[i] * MasterVolume) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+}
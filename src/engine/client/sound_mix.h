@@ -0,0 +1,16 @@
+#ifndef ENGINE_CLIENT_SOUND_MIX_H
+#define ENGINE_CLIENT_SOUND_MIX_H
+
+/**
+ * Adds `Frames` frames of a mono or stereo voice to the interleaved stereo mix buffer.
+ * The volumes are applied like `Sample * Volume` in integer math, so the result does not
+ * depend on whether the SIMD or the scalar path was taken.
+ */
+void SoundMixVoice(int *pMixBuffer, const short *pData, int Channels, unsigned Frames, int VolumeL, int VolumeR);
+
+/**
+ * Applies the master volume (0 - 100) to `Samples` accumulated samples and clamps them to `short`.
+ */
+void SoundMixToOutput(short *pFinalOut, const int *pMixBuffer, unsigned Samples, int MasterVolume);
+
+#endif
@@ -8,6 +8,7 @@
 #include <memory>
 
 class CFutureLogger;
+class CJobPool;
 class IJob;
 class ILogger;
 
@@ -18,6 +19,7 @@ class IEngine : public IInterface
 public:
 	virtual void Init() = 0;
 	virtual void AddJob(std::shared_ptr<IJob> pJob) = 0;
+	virtual CJobPool *JobPool() = 0;
 	virtual void ShutdownJobs() = 0;
 	virtual void SetAdditionalLogger(std::shared_ptr<ILogger> &&pLogger) = 0;
 };
@@ -183,6 +183,9 @@ typedef std::function<void()> WINDOW_PROPS_CHANGED_FUNC;
 typedef std::function<bool(uint32_t &Width, uint32_t &Height, CImageInfo::EImageFormat &Format, std::vector<uint8_t> &vDstData)> TGLBackendReadPresentedImageData;
 
 struct CDataSprite;
+class IGraphicsCommandList;
+
+typedef std::function<void(IGraphicsCommandList *pCommandList)> TRecordCommandListFunc;
 
 class IGraphics : public IInterface
 {
@@ -292,6 +295,7 @@ public:
 	virtual CTextureHandle LoadTextureRaw(const CImageInfo &Image, int Flags, const char *pTexName = nullptr) = 0;
 	virtual CTextureHandle LoadTextureRawMove(CImageInfo &Image, int Flags, const char *pTexName = nullptr) = 0;
 	virtual CTextureHandle LoadTexture(const char *pFilename, int StorageType, int Flags = 0) = 0;
+	virtual CTextureHandle NullTexture() const = 0;
 	virtual void TextureSet(CTextureHandle Texture) = 0;
 	void TextureClear() { TextureSet(CTextureHandle()); }
 
@@ -314,6 +318,22 @@ public:
 	virtual void RenderQuadLayer(int BufferContainerIndex, SQuadRenderInfo *pQuadInfo, size_t QuadNum, int QuadOffset, bool Grouped = false) = 0;
 	virtual void RenderText(int BufferContainerIndex, int TextQuadNum, int TextureSize, int TextureTextIndex, int TextureTextOutlineIndex, const ColorRGBA &TextColor, const ColorRGBA &TextOutlineColor) = 0;
 
+	/**
+	 * Records draw commands on a worker thread. They are executed at the current point of the
+	 * frame, before all commands added after this call, so lists are merged deterministically,
+	 * no matter which thread finishes first.
+	 *
+	 * @param Record Called with a command list that starts with the current state of the graphics.
+	 * The list is only valid during this call. It must not wait for the main thread, which waits
+	 * for all lists when the commands are submitted and records the ones no worker has started yet.
+	 */
+	virtual void RecordCommandList(TRecordCommandListFunc &&Record) = 0;
+	/**
+	 * Waits for all recorded command lists and inserts them into the frame. Data that is read
+	 * by their record functions can be freed afterwards.
+	 */
+	virtual void MergeCommandLists() = 0;
+
 	// opengl 3.3 functions
 
 	enum EBufferObjectCreateFlags
@@ -614,6 +634,34 @@ protected:
 	}
 };
 
+/**
+ * Draw commands recorded independently from the graphics, see @link IGraphics::RecordCommandList @endlink.
+ *
+ * Only the state and buffer container rendering are supported, as they do not depend on
+ * other data of the graphics. Buffer containers and textures must stay valid until the frame is swapped.
+ */
+class IGraphicsCommandList
+{
+public:
+	virtual ~IGraphicsCommandList() = default;
+
+	virtual void MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY) = 0;
+	virtual void ClipEnable(int x, int y, int w, int h) = 0;
+	virtual void ClipDisable() = 0;
+	virtual void BlendNone() = 0;
+	virtual void BlendNormal() = 0;
+	virtual void BlendAdditive() = 0;
+	virtual void WrapNormal() = 0;
+	virtual void WrapClamp() = 0;
+	virtual void TextureSet(IGraphics::CTextureHandle Texture) = 0;
+	void TextureClear() { TextureSet(IGraphics::CTextureHandle()); }
+	virtual void GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY) const = 0;
+
+	virtual void RenderTileLayer(int BufferContainerIndex, const ColorRGBA &Color, char **pOffsets, unsigned int *pIndicedVertexDrawNum, size_t NumIndicesOffset) = 0;
+	virtual void RenderBorderTiles(int BufferContainerIndex, const ColorRGBA &Color, char *pIndexBufferOffset, const vec2 &Offset, const vec2 &Scale, uint32_t DrawNum) = 0;
+	virtual void RenderQuadLayer(int BufferContainerIndex, SQuadRenderInfo *pQuadInfo, size_t QuadNum, int QuadOffset, bool Grouped = false) = 0;
+};
+
 class IEngineGraphics : public IGraphics
 {
 	MACRO_INTERFACE("enginegraphics")
@@ -86,6 +86,14 @@ public:
 	// returns number of bytes read into the buffer
 	virtual int GetBlob(int Col, unsigned char *pBuffer, int BufferSize) = 0;
 
+	// groups all following statements into one transaction until it is
+	// committed or rolled back, connection has to be established
+	//
+	// returns true on success
+	virtual bool BeginTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool CommitTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool RollbackTransaction(char *pError, int ErrorSize) = 0;
+
 	// SQL statements, that can't be abstracted, has side effects to the result
 	virtual bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) = 0;
 
@@ -6,10 +6,12 @@
 #include <base/mem.h>
 #include <base/str.h>
 #include <base/thread.h>
+#include <base/time.h>
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <iterator>
@@ -70,6 +72,7 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	std::chrono::nanoseconds m_QueueTime{0};
 };
 
 CSqlExecData::CSqlExecData(
@@ -123,25 +126,82 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Ptr.m_Print.m_Mode = m;
 }
 
-void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+void CDbConnectionPool::CSharedData::OnQueued(CSqlExecData *pData)
+{
+	pData->m_QueueTime = time_get_nanoseconds();
+	const std::lock_guard<std::mutex> Lock(m_StatsMutex);
+	CQueryStats &Stats = m_Stats[pData->m_pName];
+	Stats.m_Queued++;
+	Stats.m_MaxQueued = std::max(Stats.m_MaxQueued, Stats.m_Queued);
+}
+
+void CDbConnectionPool::CSharedData::Complete(CSqlExecData *pData, bool Success)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
+	if(pData->m_pThreadData == nullptr)
+		return;
+	{
+		const std::chrono::nanoseconds Latency = time_get_nanoseconds() - pData->m_QueueTime;
+		const std::lock_guard<std::mutex> Lock(m_StatsMutex);
+		CQueryStats &Stats = m_Stats[pData->m_pName];
+		Stats.m_Queued--;
+		(Success ? Stats.m_NumCompleted : Stats.m_NumFailed)++;
+		Stats.m_TotalLatency += Latency;
+		Stats.m_MaxLatency = std::max(Stats.m_MaxLatency, Latency);
+	}
+	if(pData->m_pThreadData->m_pResult != nullptr)
+	{
+		pData->m_pThreadData->m_pResult->m_Success = Success;
+		pData->m_pThreadData->m_pResult->m_Completed.store(true);
+	}
+}
+
+void CDbConnectionPool::AddQuery(std::unique_ptr<CSqlExecData> pData)
+{
+	if(pData->m_pThreadData != nullptr)
+		m_pShared->OnQueued(pData.get());
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pData);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+{
+	if(DatabaseMode == Mode::READ)
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		for(const auto &pReadDatabase : m_pShared->m_vpReadDatabases)
+		{
+			auto pConnection = CreateConnection(pReadDatabase.get());
+			if(pConnection)
+				pConnection->Print(pConsole, "Read");
+		}
+		if(m_pShared->m_vpReadDatabases.empty())
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFilename);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadDatabases.push_back(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadDatabases.push_back(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
 }
 
 void CDbConnectionPool::Execute(
@@ -149,9 +209,21 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	auto pData = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
+	m_pShared->OnQueued(pData.get());
+	if(m_Shutdown)
+	{
+		dbg_msg("sql", "%s dismissed read request after shutdown", pName);
+		m_pShared->Complete(pData.get(), false);
+		return;
+	}
+	StartReadWorkers();
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_ReadQueues[pName].push_back(std::move(pData));
+		m_pShared->m_NumReadQueued++;
+	}
+	m_pShared->m_ReadCv.notify_one();
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -159,9 +231,35 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	// only the main thread may read the config
+	m_pShared->m_MaxWriteBatch.store(g_Config.m_SvSqlWriteBatch);
+	AddQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
+}
+
+void CDbConnectionPool::PrintStats(IConsole *pConsole)
+{
+	char aBuf[512];
+	const std::lock_guard<std::mutex> Lock(m_pShared->m_StatsMutex);
+	str_format(aBuf, sizeof(aBuf), "write transactions with more than one query: %" PRId64 ", containing %" PRId64 " writes",
+		m_pShared->m_NumWriteBatches, m_pShared->m_NumBatchedWrites);
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	for(const auto &[Name, Stats] : m_pShared->m_Stats)
+	{
+		const int64_t NumDone = Stats.m_NumCompleted + Stats.m_NumFailed;
+		str_format(aBuf, sizeof(aBuf), "%s: queued=%d max_queued=%d completed=%" PRId64 " failed=%" PRId64 " avg_latency=%.1fms max_latency=%.1fms",
+			Name.c_str(), Stats.m_Queued, Stats.m_MaxQueued, Stats.m_NumCompleted, Stats.m_NumFailed,
+			NumDone > 0 ? Stats.m_TotalLatency.count() / 1e6 / NumDone : 0.0,
+			Stats.m_MaxLatency.count() / 1e6);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+	if(m_pShared->m_Stats.empty())
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "No database queries yet");
+}
+
+std::map<std::string, CDbConnectionPool::CQueryStats> CDbConnectionPool::Stats()
+{
+	const std::lock_guard<std::mutex> Lock(m_pShared->m_StatsMutex);
+	return m_pShared->m_Stats;
 }
 
 void CDbConnectionPool::OnShutdown()
@@ -169,6 +267,14 @@ void CDbConnectionPool::OnShutdown()
 	if(m_Shutdown)
 		return;
 	m_Shutdown = true;
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_ReadShutdown = true;
+	}
+	m_pShared->m_ReadCv.notify_all();
+	for(void *pThread : m_vpReadWorkerThreads)
+		thread_wait(pThread);
+	m_vpReadWorkerThreads.clear();
 	m_pShared->m_Shutdown.store(true);
 	m_pShared->m_NumBackup.Signal();
 	int i = 0;
@@ -216,9 +322,13 @@ void CBackup::Start(void *pUser)
 
 void CBackup::ProcessQueries()
 {
+	// the job was already taken from the semaphore while batching writes
+	bool Pending = false;
 	for(int JobNum = 0;; JobNum++)
 	{
-		m_pShared->m_NumBackup.Wait();
+		if(!Pending)
+			m_pShared->m_NumBackup.Wait();
+		Pending = false;
 		CSqlExecData *pThreadData = m_pShared->m_aQueries[JobNum % std::size(m_pShared->m_aQueries)].get();
 
 		// work through all database jobs after OnShutdown is called before exiting the thread
@@ -235,9 +345,38 @@ void CBackup::ProcessQueries()
 		}
 		else if(pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS && m_pWriteBackup.get())
 		{
-			bool Success = CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData, Write::BACKUP_FIRST);
-			if(m_DebugSql || !Success)
-				dbg_msg("sql", "[%i] %s done on write backup database, Success=%i", JobNum, pThreadData->m_pName, Success);
+			// write all queued writes in one transaction, a slot is only
+			// read once the semaphore says that it has been queued
+			std::vector<CSqlExecData *> vpBatch = {pThreadData};
+			while((int)vpBatch.size() < m_pShared->m_MaxWriteBatch.load() && m_pShared->m_NumBackup.TryWait())
+			{
+				CSqlExecData *pNext = m_pShared->m_aQueries[(JobNum + vpBatch.size()) % std::size(m_pShared->m_aQueries)].get();
+				if(pNext == nullptr || pNext->m_Mode != CSqlExecData::WRITE_ACCESS)
+				{
+					Pending = true;
+					break;
+				}
+				vpBatch.push_back(pNext);
+			}
+			if(vpBatch.size() > 1 && CDbConnectionPool::ExecSqlBatch(m_pWriteBackup.get(), vpBatch, Write::BACKUP_FIRST))
+			{
+				if(m_DebugSql)
+					dbg_msg("sql", "[%i-%i] %d writes done on write backup database", JobNum, JobNum + (int)vpBatch.size() - 1, (int)vpBatch.size());
+			}
+			else
+			{
+				for(size_t i = 0; i < vpBatch.size(); i++)
+				{
+					bool Success = CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), vpBatch[i], Write::BACKUP_FIRST);
+					if(m_DebugSql || !Success)
+						dbg_msg("sql", "[%i] %s done on write backup database, Success=%i", JobNum + (int)i, vpBatch[i]->m_pName, Success);
+				}
+			}
+			for(size_t i = 1; i < vpBatch.size(); i++)
+			{
+				m_pShared->m_NumWorker.Signal();
+			}
+			JobNum += (int)vpBatch.size() - 1;
 		}
 		m_pShared->m_NumWorker.Signal();
 	}
@@ -257,6 +396,9 @@ public:
 
 private:
 	void Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode);
+	bool ProcessWrite(int JobNum, CSqlExecData *pThreadData, bool *pFailMode);
+	void ProcessWrites(int FirstJobNum, std::vector<std::unique_ptr<CSqlExecData>> &vpBatch, bool *pFailMode);
+	void Complete(int JobNum, CSqlExecData *pThreadData, bool Success);
 
 	bool m_DebugSql;
 
@@ -267,8 +409,8 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
+	// The READ servers are used by the read workers (CReadWorker).
 	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -285,18 +427,20 @@ void CWorker::Start(void *pUser)
 
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// until all requests are handled
 	bool FailMode = false;
+	// the job was already taken from the semaphore while batching writes
+	bool Pending = false;
 	for(int JobNum = 0;; JobNum++)
 	{
-		if(FailMode && m_pShared->m_NumWorker.GetApproximateValue() == 0)
+		if(FailMode && !Pending && m_pShared->m_NumWorker.GetApproximateValue() == 0)
 		{
 			FailMode = false;
 		}
-		m_pShared->m_NumWorker.Wait();
+		if(!Pending)
+			m_pShared->m_NumWorker.Wait();
+		Pending = false;
 		auto pThreadData = std::move(m_pShared->m_aQueries[JobNum % std::size(m_pShared->m_aQueries)]);
 		// work through all database jobs after OnShutdown is called before exiting the thread
 		if(pThreadData == nullptr)
@@ -308,70 +452,35 @@ void CWorker::ProcessQueries()
 		switch(pThreadData->m_Mode)
 		{
 		case CSqlExecData::READ_ACCESS:
+			dbg_assert_failed("reads are executed by the read workers");
+		case CSqlExecData::WRITE_ACCESS:
 		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			// execute all writes which are already queued in one transaction,
+			// a slot is only read once the semaphore says that it has been queued
+			const int FirstJobNum = JobNum;
+			std::vector<std::unique_ptr<CSqlExecData>> vpBatch;
+			vpBatch.push_back(std::move(pThreadData));
+			while((int)vpBatch.size() < m_pShared->m_MaxWriteBatch.load() && m_pShared->m_NumWorker.TryWait())
 			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
+				const CSqlExecData *pNext = m_pShared->m_aQueries[(JobNum + 1) % std::size(m_pShared->m_aQueries)].get();
+				if(pNext == nullptr || pNext->m_Mode != CSqlExecData::WRITE_ACCESS)
 				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
+					Pending = true;
 					break;
 				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					if(m_DebugSql)
-						dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
-			}
-			if(!Success)
-			{
-				FailMode = true;
-			}
-		}
-		break;
-		case CSqlExecData::WRITE_ACCESS:
-		{
-			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
-			}
-			else if(FailMode && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
-			}
-			else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData.get(), Write::NORMAL))
-			{
-				if(m_DebugSql)
-					dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
-				Success = true;
-			}
-			// enter fail mode if not successful
-			FailMode = FailMode || !Success;
-			const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
-			if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData.get(), w))
-			{
-				if(m_DebugSql)
-					dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
-				Success = true;
+				JobNum++;
+				vpBatch.push_back(std::move(m_pShared->m_aQueries[JobNum % std::size(m_pShared->m_aQueries)]));
 			}
+			ProcessWrites(FirstJobNum, vpBatch, &FailMode);
+			continue;
 		}
-		break;
 		case CSqlExecData::ADD_MYSQL:
 		{
-			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_Mysql.m_Config);
+			auto pMysql = CDbConnectionPool::CreateConnection(pThreadData.get());
 			switch(pThreadData->m_Ptr.m_Mysql.m_Mode)
 			{
 			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
+				dbg_assert_failed("read databases are registered with the read workers");
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pMysql);
 				break;
@@ -386,12 +495,11 @@ void CWorker::ProcessQueries()
 		}
 		case CSqlExecData::ADD_SQLITE:
 		{
-			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_Filename, true);
+			auto pSqlite = CDbConnectionPool::CreateConnection(pThreadData.get());
 			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
 			{
 			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
+				dbg_assert_failed("read databases are registered with the read workers");
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pSqlite);
 				break;
@@ -409,26 +517,88 @@ void CWorker::ProcessQueries()
 			Success = true;
 			break;
 		}
-		if(!Success)
-			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
-		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
+		Complete(JobNum, pThreadData.get(), Success);
+	}
+}
+
+bool CWorker::ProcessWrite(int JobNum, CSqlExecData *pThreadData, bool *pFailMode)
+{
+	bool Success = false;
+	if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
+	{
+		dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
+	}
+	else if(*pFailMode && m_pWriteBackup != nullptr)
+	{
+		dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
+	}
+	else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData, Write::NORMAL))
+	{
+		if(m_DebugSql)
+			dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
+		Success = true;
+	}
+	// enter fail mode if not successful
+	*pFailMode = *pFailMode || !Success;
+	const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
+	if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData, w))
+	{
+		if(m_DebugSql)
+			dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
+		Success = true;
+	}
+	return Success;
+}
+
+void CWorker::ProcessWrites(int FirstJobNum, std::vector<std::unique_ptr<CSqlExecData>> &vpBatch, bool *pFailMode)
+{
+	const int LastJobNum = FirstJobNum + (int)vpBatch.size() - 1;
+	std::vector<CSqlExecData *> vpData;
+	for(auto &pThreadData : vpBatch)
+		vpData.push_back(pThreadData.get());
+
+	// writes are only grouped on the write database, during shutdown and
+	// FailMode they are moved on the backup database one by one
+	const bool SkipWriteDatabase = (m_pShared->m_Shutdown || *pFailMode) && m_pWriteBackup != nullptr;
+	if(vpBatch.size() == 1 || SkipWriteDatabase || !CDbConnectionPool::ExecSqlBatch(m_pWriteConnection.get(), vpData, Write::NORMAL))
+	{
+		if(vpBatch.size() > 1 && !SkipWriteDatabase)
+			dbg_msg("sql", "[%i-%i] retrying writes one by one", FirstJobNum, LastJobNum);
+		for(size_t i = 0; i < vpData.size(); i++)
 		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
+			Complete(FirstJobNum + (int)i, vpData[i], ProcessWrite(FirstJobNum + (int)i, vpData[i], pFailMode));
 		}
+		return;
 	}
+
+	if(m_DebugSql)
+		dbg_msg("sql", "[%i-%i] %d writes done on write database", FirstJobNum, LastJobNum, (int)vpData.size());
+	if(m_pWriteBackup && !CDbConnectionPool::ExecSqlBatch(m_pWriteBackup.get(), vpData, Write::NORMAL_SUCCEEDED))
+	{
+		for(CSqlExecData *pThreadData : vpData)
+			CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData, Write::NORMAL_SUCCEEDED);
+	}
+	{
+		const std::lock_guard<std::mutex> Lock(m_pShared->m_StatsMutex);
+		m_pShared->m_NumWriteBatches++;
+		m_pShared->m_NumBatchedWrites += vpData.size();
+	}
+	for(size_t i = 0; i < vpData.size(); i++)
+	{
+		Complete(FirstJobNum + (int)i, vpData[i], true);
+	}
+}
+
+void CWorker::Complete(int JobNum, CSqlExecData *pThreadData, bool Success)
+{
+	if(!Success)
+		dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
+	m_pShared->Complete(pThreadData, Success);
 }
 
 void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
@@ -444,6 +614,109 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute the read queries, each with its own connections
+// to all read databases. They take turns between the query kinds, so that
+// e.g. many slow /top5 queries don't delay the player data loaded on join.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, int DebugSql, int Id) :
+		m_DebugSql(DebugSql), m_Id(Id), m_pShared(std::move(pShared)) {}
+	static void Start(void *pUser);
+	void ProcessQueries();
+
+private:
+	bool m_DebugSql;
+	int m_Id;
+
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	while(true)
+	{
+		std::unique_ptr<CSqlExecData> pThreadData;
+		const char *pDismissed = nullptr;
+		{
+			std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+			if(m_pShared->m_NumReadQueued == 0)
+			{
+				m_pShared->m_ReadFailMode = false;
+			}
+			m_pShared->m_ReadCv.wait(Lock, [&]() { return m_pShared->m_NumReadQueued > 0 || m_pShared->m_ReadShutdown; });
+			// work through all read queries after OnShutdown is called before exiting the thread
+			if(m_pShared->m_NumReadQueued == 0)
+			{
+				return;
+			}
+			// continue with the next query kind after the previously executed one
+			auto It = m_pShared->m_ReadQueues.upper_bound(m_pShared->m_LastReadKind);
+			if(It == m_pShared->m_ReadQueues.end())
+			{
+				It = m_pShared->m_ReadQueues.begin();
+			}
+			m_pShared->m_LastReadKind = It->first;
+			pThreadData = std::move(It->second.front());
+			It->second.pop_front();
+			if(It->second.empty())
+			{
+				m_pShared->m_ReadQueues.erase(It);
+			}
+			m_pShared->m_NumReadQueued--;
+
+			while(m_vpReadConnections.size() < m_pShared->m_vpReadDatabases.size())
+			{
+				m_vpReadConnections.push_back(CDbConnectionPool::CreateConnection(m_pShared->m_vpReadDatabases[m_vpReadConnections.size()].get()));
+			}
+			if(m_pShared->m_ReadShutdown)
+				pDismissed = "shutdown";
+			else if(m_pShared->m_ReadFailMode)
+				pDismissed = "FailMode";
+		}
+
+		bool Success = false;
+		if(pDismissed != nullptr)
+		{
+			dbg_msg("sql", "[read %d] %s dismissed read request during %s", m_Id, pThreadData->m_pName, pDismissed);
+		}
+		else
+		{
+			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			{
+				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+				{
+					ReadServer = CurServer;
+					if(m_DebugSql)
+						dbg_msg("sql", "[read %d] %s done on read database %d", m_Id, pThreadData->m_pName, CurServer);
+					Success = true;
+					break;
+				}
+			}
+			if(!Success)
+			{
+				dbg_msg("sql", "[read %d] %s failed on all databases", m_Id, pThreadData->m_pName);
+				const std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+				m_pShared->m_ReadFailMode = true;
+			}
+		}
+		m_pShared->Complete(pThreadData.get(), Success);
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -478,6 +751,66 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 	return Success;
 }
 
+/* static */
+std::unique_ptr<IDbConnection> CDbConnectionPool::CreateConnection(const CSqlExecData *pData)
+{
+	switch(pData->m_Mode)
+	{
+	case CSqlExecData::ADD_MYSQL:
+		return CreateMysqlConnection(pData->m_Ptr.m_Mysql.m_Config);
+	case CSqlExecData::ADD_SQLITE:
+		return CreateSqliteConnection(pData->m_Ptr.m_Sqlite.m_Filename, true);
+	default:
+		dbg_assert_failed("unreachable");
+	}
+}
+
+/* static */
+bool CDbConnectionPool::ExecSqlBatch(IDbConnection *pConnection, const std::vector<CSqlExecData *> &vpData, Write w)
+{
+	if(pConnection == nullptr)
+	{
+		dbg_msg("sql", "No database given");
+		return false;
+	}
+	char aError[256] = "unknown error";
+	if(!pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed connecting to db: %s", aError);
+		return false;
+	}
+	const char *pFailed = "begin transaction";
+	bool Success = pConnection->BeginTransaction(aError, sizeof(aError));
+	for(size_t i = 0; Success && i < vpData.size(); i++)
+	{
+		pFailed = vpData[i]->m_pName;
+		Success = vpData[i]->m_Ptr.m_pWriteFunc(pConnection, vpData[i]->m_pThreadData.get(), w, aError, sizeof(aError));
+	}
+	if(Success)
+	{
+		pFailed = "commit transaction";
+		Success = pConnection->CommitTransaction(aError, sizeof(aError));
+	}
+	if(!Success)
+	{
+		dbg_msg("sql", "%s failed in transaction of %d writes: %s", pFailed, (int)vpData.size(), aError);
+		if(!pConnection->RollbackTransaction(aError, sizeof(aError)))
+			dbg_msg("sql", "rollback transaction failed: %s", aError);
+	}
+	pConnection->Disconnect();
+	return Success;
+}
+
+void CDbConnectionPool::StartReadWorkers()
+{
+	// only the main thread may read the config
+	while((int)m_vpReadWorkerThreads.size() < g_Config.m_SvSqlReadWorkers)
+	{
+		CReadWorker *pWorker = new CReadWorker(m_pShared, g_Config.m_DbgSql, m_vpReadWorkerThreads.size());
+		m_vpReadWorkerThreads.push_back(thread_init(CReadWorker::Start, pWorker, "database read worker thread"));
+	}
+}
+
 CDbConnectionPool::CDbConnectionPool()
 {
 	m_pShared = std::make_shared<CSharedData>();
@@ -4,7 +4,13 @@
 #include <base/sphore.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 class IDbConnection;
@@ -77,7 +83,23 @@ public:
 		NUM_MODES,
 	};
 
+	// statistics per query kind, the kind is the name passed to Execute/ExecuteWrite
+	class CQueryStats
+	{
+	public:
+		// queries waiting in the queue or being executed
+		int m_Queued = 0;
+		int m_MaxQueued = 0;
+		int64_t m_NumCompleted = 0;
+		int64_t m_NumFailed = 0;
+		// time from being queued until completion
+		std::chrono::nanoseconds m_TotalLatency{0};
+		std::chrono::nanoseconds m_MaxLatency{0};
+	};
+
 	void Print(IConsole *pConsole, Mode DatabaseMode);
+	void PrintStats(IConsole *pConsole);
+	std::map<std::string, CQueryStats> Stats();
 
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
@@ -97,9 +119,15 @@ public:
 
 	friend class CWorker;
 	friend class CBackup;
+	friend class CReadWorker;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
+	// executes all writes in one transaction, rolls back if one of them fails
+	static bool ExecSqlBatch(IDbConnection *pConnection, const std::vector<struct CSqlExecData *> &vpData, Write w);
+	static std::unique_ptr<IDbConnection> CreateConnection(const struct CSqlExecData *pData);
+	void AddQuery(std::unique_ptr<struct CSqlExecData> pData);
+	void StartReadWorkers();
 
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
@@ -124,11 +152,45 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+
+		// Maximum number of queued writes executed in one transaction, copy
+		// of sv_sql_write_batch updated by the main thread.
+		std::atomic_int m_MaxWriteBatch{1};
+
+		// guards the statistics below
+		std::mutex m_StatsMutex;
+		std::map<std::string, CQueryStats> m_Stats;
+		// transactions with more than one write
+		int64_t m_NumWriteBatches = 0;
+		int64_t m_NumBatchedWrites = 0;
+
+		// Read queries don't go through the queue above, they are executed
+		// by separate read worker threads, so they don't wait for writes.
+		// Everything below is guarded by m_ReadMutex.
+		std::mutex m_ReadMutex;
+		std::condition_variable m_ReadCv;
+		// One queue per query kind. The kinds take turns, so a burst of slow
+		// queries of one kind doesn't delay the other kinds.
+		std::map<std::string, std::deque<std::unique_ptr<struct CSqlExecData>>> m_ReadQueues;
+		std::string m_LastReadKind;
+		int m_NumReadQueued = 0;
+		bool m_ReadShutdown = false;
+		// Entered when a read fails on all databases, queued reads are
+		// dismissed until the read queues are empty again.
+		bool m_ReadFailMode = false;
+		// registrations of the read databases, each read worker creates
+		// its own connections from them
+		std::vector<std::unique_ptr<struct CSqlExecData>> m_vpReadDatabases;
+
+		void OnQueued(struct CSqlExecData *pData);
+		void Complete(struct CSqlExecData *pData, bool Success);
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
 	void *m_pWorkerThread = nullptr;
 	void *m_pBackupThread = nullptr;
+	// started on demand by the main thread, up to sv_sql_read_workers
+	std::vector<void *> m_vpReadWorkerThreads;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
@@ -106,6 +106,10 @@ public:
 	void GetString(int Col, char *pBuffer, int BufferSize) override;
 	int GetBlob(int Col, unsigned char *pBuffer, int BufferSize) override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) override;
 
 private:
@@ -120,6 +124,7 @@ private:
 	void StoreErrorStmt(const char *pContext);
 	bool ConnectImpl();
 	bool PrepareAndExecuteStatement(const char *pStmt);
+	void FreeResult();
 
 	union UParameterExtra
 	{
@@ -139,6 +144,9 @@ private:
 	// copy of m_Config vars
 	CMysqlConfig m_Config;
 
+	// the automatic reconnect silently drops open transactions
+	unsigned long m_TransactionThreadId = 0;
+
 	std::atomic_bool m_InUse;
 };
 
@@ -191,6 +199,15 @@ bool CMysqlConnection::PrepareAndExecuteStatement(const char *pStmt)
 	return true;
 }
 
+void CMysqlConnection::FreeResult()
+{
+	if(m_pStmt && mysql_stmt_free_result(m_pStmt.get()))
+	{
+		StoreErrorStmt("free_result");
+		dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
+	}
+}
+
 void CMysqlConnection::Print(IConsole *pConsole, const char *pMode)
 {
 	char aBuf[512];
@@ -223,11 +240,7 @@ bool CMysqlConnection::ConnectImpl()
 {
 	if(m_HaveConnection)
 	{
-		if(m_pStmt && mysql_stmt_free_result(m_pStmt.get()))
-		{
-			StoreErrorStmt("free_result");
-			dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
-		}
+		FreeResult();
 		if(!mysql_select_db(&m_Mysql, m_Config.m_aDatabase))
 		{
 			// Success.
@@ -660,6 +673,49 @@ const char *CMysqlConnection::MedianMapTime(char *pBuffer, int BufferSize) const
 	return pBuffer;
 }
 
+bool CMysqlConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	FreeResult();
+	if(mysql_query(&m_Mysql, "START TRANSACTION"))
+	{
+		StoreErrorMysql("start_transaction");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return false;
+	}
+	m_TransactionThreadId = mysql_thread_id(&m_Mysql);
+	return true;
+}
+
+bool CMysqlConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	FreeResult();
+	if(mysql_thread_id(&m_Mysql) != m_TransactionThreadId)
+	{
+		// statements before the reconnect were rolled back by the server
+		str_copy(pError, "connection lost during transaction", ErrorSize);
+		return false;
+	}
+	if(mysql_commit(&m_Mysql))
+	{
+		StoreErrorMysql("commit");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return false;
+	}
+	return true;
+}
+
+bool CMysqlConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	FreeResult();
+	if(mysql_rollback(&m_Mysql))
+	{
+		StoreErrorMysql("rollback");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return false;
+	}
+	return true;
+}
+
 bool CMysqlConnection::AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize)
 {
 	char aBuf[512];
@@ -10,6 +10,12 @@
 #include <sqlite3.h>
 
 #include <atomic>
+#include <mutex>
+
+// The database threads connect to the same file concurrently. SQLite reports
+// the lock upgrades of concurrent table creations as deadlock instead of
+// waiting for the busy timeout, so the setup is done by one connection at a time.
+static std::mutex gs_SetupMutex;
 
 class CSqliteConnection : public IDbConnection
 {
@@ -55,6 +61,10 @@ public:
 	// passing a negative buffer size is undefined behavior
 	int GetBlob(int Col, unsigned char *pBuffer, int BufferSize) override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) override;
 
 	// fail safe
@@ -151,6 +161,7 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 	if(m_Setup)
 	{
+		const std::lock_guard<std::mutex> Lock(gs_SetupMutex);
 		if(!Execute("PRAGMA journal_mode=WAL", pError, ErrorSize))
 			return false;
 		char aBuf[1024];
@@ -397,6 +408,30 @@ void CSqliteConnection::AssertNoError(int Result)
 	}
 }
 
+bool CSqliteConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	// take the write lock right away, a deferred transaction can't wait for
+	// other connections when upgrading from a read to a write lock
+	return Execute("BEGIN IMMEDIATE", pError, ErrorSize);
+}
+
+bool CSqliteConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	// statements still in progress keep the transaction from being committed
+	if(m_pStmt != nullptr)
+		sqlite3_finalize(m_pStmt);
+	m_pStmt = nullptr;
+	return Execute("COMMIT", pError, ErrorSize);
+}
+
+bool CSqliteConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	if(m_pStmt != nullptr)
+		sqlite3_finalize(m_pStmt);
+	m_pStmt = nullptr;
+	return Execute("ROLLBACK", pError, ErrorSize);
+}
+
 bool CSqliteConnection::AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize)
 {
 	char aBuf[512];
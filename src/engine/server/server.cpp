@@ -1027,7 +1027,11 @@ void CServer::DoSnapshot()
 			m_aDemoRecorder[RECORDER_AUTO].RecordSnapshot(Tick(), Data.AsSnapshot(), SnapshotSize);
 	}
 
+	if(m_SnapshotPipeline.NumThreads() != Config()->m_SvSnapshotThreads)
+		m_SnapshotPipeline.Init(Config()->m_SvSnapshotThreads, &*m_pSnapshotDelta, &*m_pSnapshotDeltaSixup);
+
 	// create snapshots for all clients
+	m_SnapshotPipeline.Clear();
 	for(int i = 0; i < MaxClients(); i++)
 	{
 		// client must be ingame to receive snapshots
@@ -1046,96 +1050,87 @@ void CServer::DoSnapshot()
 		if(!IsGlobalSnap && !(m_aClients[i].m_ForceHighBandwidthOnSpectate && GameServer()->IsClientHighBandwidth(i)))
 			continue;
 
-		{
-			m_pSnapshotBuilder->Init(m_aClients[i].m_Sixup);
+		m_pSnapshotBuilder->Init(m_aClients[i].m_Sixup);
 
-			// only snap events on global ticks
-			GameServer()->OnSnap(i, IsGlobalSnap, m_aDemoRecorder[i].IsRecording());
+		// only snap events on global ticks
+		GameServer()->OnSnap(i, IsGlobalSnap, m_aDemoRecorder[i].IsRecording());
 
-			// finish snapshot
-			CSnapshotBuffer Data;
-			int SnapshotSize = m_pSnapshotBuilder->Finish(Data);
+		// finish snapshot
+		CSnapshotPipeline::CJob *pJob = m_SnapshotPipeline.NewJob();
+		pJob->m_SnapshotSize = m_pSnapshotBuilder->Finish(pJob->m_Snapshot);
 
-			if(m_aDemoRecorder[i].IsRecording())
-			{
-				// write snapshot
-				m_aDemoRecorder[i].RecordSnapshot(Tick(), Data.AsSnapshot(), SnapshotSize);
-			}
+		if(m_aDemoRecorder[i].IsRecording())
+		{
+			// write snapshot
+			m_aDemoRecorder[i].RecordSnapshot(Tick(), pJob->m_Snapshot.AsSnapshot(), pJob->m_SnapshotSize);
+		}
 
-			int Crc = Data.AsSnapshot()->Crc();
+		pJob->m_ClientId = i;
+		pJob->m_Sixup = IsSixup(i);
+		pJob->m_Tick = m_CurrentGameTick;
+		// keep 3 seconds worth of snapshots
+		pJob->m_PurgeUntilTick = m_CurrentGameTick - TickSpeed() * 3;
+		pJob->m_AckedTick = m_aClients[i].m_LastAckedSnapshot;
+		pJob->m_Tagtime = time_get();
+		pJob->m_pStorage = &m_aClients[i].m_Snapshots;
+	}
 
-			// remove old snapshots
-			// keep 3 seconds worth of snapshots
-			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
+	// crc, delta and compress the snapshots, possibly on multiple threads
+	m_SnapshotPipeline.Run(&*m_pSnapshotDelta, &*m_pSnapshotDeltaSixup);
 
-			// save the snapshot
-			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, Data.AsSnapshot(), 0, nullptr);
+	// send them in client order
+	for(int Job = 0; Job < m_SnapshotPipeline.NumJobs(); Job++)
+	{
+		const CSnapshotPipeline::CJob *pJob = m_SnapshotPipeline.Job(Job);
+		const CSnapshotPipeline::CJob *pResult = pJob->Result();
+		const int i = pJob->m_ClientId;
+		const int DeltaTick = pJob->m_DeltaTick;
 
-			// find snapshot that we can perform delta against
-			int DeltaTick = -1;
-			const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
-			{
-				int DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
-				if(DeltashotSize >= 0)
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				else
-				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
-				}
-			}
+		// no acked package found, force client to recover rate
+		if(DeltaTick < 0 && m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
+			m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
 
-			// create delta
-			CSnapshotDelta *const pSnapshotDelta = IsSixup(i) ? &*m_pSnapshotDeltaSixup : &*m_pSnapshotDelta;
-			int32_t aDeltaData[CSnapshot::MAX_SIZE / sizeof(int32_t)];
-			int DeltaSize = pSnapshotDelta->CreateDelta(*pDeltashot, *Data.AsSnapshot(), rust::Slice(aDeltaData, std::size(aDeltaData)));
+		if(pResult->m_CompressedSize)
+		{
+			const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+			int NumPackets = (pResult->m_CompressedSize + MaxSize - 1) / MaxSize;
 
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+			for(int n = 0, Left = pResult->m_CompressedSize; Left > 0; n++)
+			{
+				int Chunk = Left < MaxSize ? Left : MaxSize;
+				Left -= Chunk;
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
+				if(NumPackets == 1)
 				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
-
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
+					CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(pResult->m_Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&pResult->m_aCompressedData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				}
+				else
+				{
+					CMsgPacker Msg(NETMSG_SNAP, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(NumPackets);
+					Msg.AddInt(n);
+					Msg.AddInt(pResult->m_Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&pResult->m_aCompressedData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
 				}
 			}
-			else
-			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
-			}
+		}
+		else
+		{
+			CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+			Msg.AddInt(m_CurrentGameTick);
+			Msg.AddInt(m_CurrentGameTick - DeltaTick);
+			SendMsg(&Msg, MSGFLAG_FLUSH, i);
 		}
 	}
 
@@ -3424,6 +3419,21 @@ int CServer::Run()
 			if(!NonActive)
 				PumpNetwork(PacketWaiting);
 
+			// send everything that was queued since the last wait at once
+			m_NetServer.SetSendBatching(Config()->m_SvNetBatchSend);
+			m_NetServer.FlushSends();
+			m_NetServer.SetRecvThread(Config()->m_SvNetRecvThread);
+			if(Config()->m_Debug && NewTicks && Tick() % TickSpeed() == 0)
+			{
+				NETSTATS NetStats;
+				net_stats(&NetStats);
+				const uint64_t Packets = NetStats.sent_packets - m_NetStatsPrev.sent_packets;
+				const uint64_t Syscalls = NetStats.sent_syscalls - m_NetStatsPrev.sent_syscalls;
+				log_debug("server", "sent %" PRIu64 " packets with %" PRIu64 " syscalls in the last second, %.1f syscalls saved per tick",
+					Packets, Syscalls, ((float)Packets - (float)Syscalls) / TickSpeed());
+				m_NetStatsPrev = NetStats;
+			}
+
 			NonActive = true;
 			for(const auto &Client : m_aClients)
 			{
@@ -3461,14 +3471,14 @@ int CServer::Run()
 				!m_aDemoRecorder[RECORDER_MANUAL].IsRecording() &&
 				!m_aDemoRecorder[RECORDER_AUTO].IsRecording())
 			{
-				PacketWaiting = net_socket_read_wait(m_NetServer.Socket(), 1s);
+				PacketWaiting = m_NetServer.Wait(1s);
 			}
 			else
 			{
 				set_new_tick();
 				LastTime = time_get();
 				const auto MicrosecondsToWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(TickStartTime(m_CurrentGameTick + 1) - LastTime)) + 1us;
-				PacketWaiting = MicrosecondsToWait > 0us ? net_socket_read_wait(m_NetServer.Socket(), MicrosecondsToWait) : true;
+				PacketWaiting = MicrosecondsToWait > 0us ? m_NetServer.Wait(MicrosecondsToWait) : true;
 			}
 			if(IsInterrupted())
 			{
@@ -3498,6 +3508,7 @@ int CServer::Run()
 	m_Fifo.Shutdown();
 	m_pHttp->Shutdown();
 	Engine()->ShutdownJobs();
+	m_SnapshotPipeline.Shutdown();
 
 	GameServer()->OnShutdown(nullptr);
 	GameServer()->Map()->Unload();
@@ -4121,6 +4132,12 @@ void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CServer::ConDumpSqlStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	pSelf->DbPool()->PrintStats(pSelf->Console());
+}
+
 void CServer::ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pThis = static_cast<CServer *>(pUserData);
@@ -4418,6 +4435,7 @@ void CServer::RegisterCommands()
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
+	Console()->Register("dump_sqlstats", "", CFGFLAG_SERVER, ConDumpSqlStats, this, "dumps queue depth and latency of the database queries per query kind");
 
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
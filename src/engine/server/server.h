@@ -7,6 +7,7 @@
 #include "authmanager.h"
 #include "name_ban.h"
 #include "snap_id_pool.h"
+#include "snapshot_pipeline.h"
 
 #include <base/hash.h>
 
@@ -216,6 +217,8 @@ public:
 	rust::Box<CSnapshotDelta> m_pSnapshotDelta;
 	rust::Box<CSnapshotDelta> m_pSnapshotDeltaSixup;
 	rust::Box<CSnapshotBuilder> m_pSnapshotBuilder;
+	CSnapshotPipeline m_SnapshotPipeline;
+	NETSTATS m_NetStatsPrev = {};
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -451,6 +454,7 @@ public:
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
+	static void ConDumpSqlStats(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData);
 	static void ConReloadMaplist(IConsole::IResult *pResult, void *pUserData);
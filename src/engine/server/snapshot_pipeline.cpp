@@ -0,0 +1,185 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+
+#include "snapshot_pipeline.h"
+
+#include <base/math.h>
+#include <base/mem.h>
+#include <base/str.h>
+#include <base/thread.h>
+
+#include <engine/shared/compression.h>
+
+#include <iterator>
+
+CSnapshotPipeline::CWorker::CWorker(CSnapshotPipeline *pPipeline, CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup) :
+	m_pPipeline(pPipeline),
+	m_pDelta(pDelta->Clone()),
+	m_pDeltaSixup(pDeltaSixup->Clone())
+{
+	m_Context.m_pDelta = &*m_pDelta;
+	m_Context.m_pDeltaSixup = &*m_pDeltaSixup;
+}
+
+CSnapshotPipeline::CSnapshotPipeline() :
+	m_pMainContext(std::make_unique<CContext>())
+{
+}
+
+CSnapshotPipeline::~CSnapshotPipeline()
+{
+	Shutdown();
+}
+
+void CSnapshotPipeline::Init(int NumThreads, CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup)
+{
+	Shutdown();
+
+	m_Shutdown.store(false);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		m_vpWorkers.push_back(std::make_unique<CWorker>(this, pDelta, pDeltaSixup));
+		char aName[32];
+		str_format(aName, sizeof(aName), "snapshot worker %d", i);
+		m_vpWorkers.back()->m_pThread = thread_init(WorkerThread, m_vpWorkers.back().get(), aName);
+	}
+}
+
+void CSnapshotPipeline::Shutdown()
+{
+	if(m_vpWorkers.empty())
+		return;
+
+	m_Shutdown.store(true);
+	for(size_t i = 0; i < m_vpWorkers.size(); i++)
+		m_StartSemaphore.Signal();
+	for(auto &pWorker : m_vpWorkers)
+		thread_wait(pWorker->m_pThread);
+	m_vpWorkers.clear();
+}
+
+CSnapshotPipeline::CJob *CSnapshotPipeline::NewJob()
+{
+	if(m_NumJobs == (int)m_vpJobs.size())
+		m_vpJobs.push_back(std::make_unique<CJob>());
+	return m_vpJobs[m_NumJobs++].get();
+}
+
+void CSnapshotPipeline::Run(CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup)
+{
+	m_pMainContext->m_pDelta = pDelta;
+	m_pMainContext->m_pDeltaSixup = pDeltaSixup;
+
+	RunStage(STAGE_STORE);
+	FindSharedJobs();
+	RunStage(STAGE_DELTA);
+}
+
+void CSnapshotPipeline::RunStage(EStage Stage)
+{
+	m_Stage = Stage;
+	m_NextJob.store(0);
+
+	// only wake up as many workers as there are jobs left for them
+	const int NumWorkers = minimum<int>(m_vpWorkers.size(), m_NumJobs - 1);
+	for(int i = 0; i < NumWorkers; i++)
+		m_StartSemaphore.Signal();
+
+	ProcessJobs(m_pMainContext.get());
+
+	for(int i = 0; i < NumWorkers; i++)
+		m_DoneSemaphore.Wait();
+}
+
+void CSnapshotPipeline::FindSharedJobs()
+{
+	for(int i = 0; i < m_NumJobs; i++)
+	{
+		CJob *pJob = m_vpJobs[i].get();
+		pJob->m_pShared = nullptr;
+		for(int j = 0; j < i; j++)
+		{
+			const CJob *pOther = m_vpJobs[j].get();
+			if(pOther->m_pShared != nullptr ||
+				pOther->m_Crc != pJob->m_Crc ||
+				pOther->m_SnapshotSize != pJob->m_SnapshotSize ||
+				pOther->m_Sixup != pJob->m_Sixup ||
+				pOther->m_DeltaTick != pJob->m_DeltaTick ||
+				pOther->m_DeltashotSize != pJob->m_DeltashotSize)
+			{
+				continue;
+			}
+			// the CRC is only a sum, so confirm that both the snapshots and
+			// the snapshots they are deltaed against are really the same
+			if(mem_comp(pOther->m_Snapshot.m_aData, pJob->m_Snapshot.m_aData, pJob->m_SnapshotSize) != 0)
+				continue;
+			if(pOther->m_pDeltashot != pJob->m_pDeltashot && mem_comp(pOther->m_pDeltashot, pJob->m_pDeltashot, pJob->m_DeltashotSize) != 0)
+				continue;
+			pJob->m_pShared = pOther;
+			break;
+		}
+	}
+}
+
+void CSnapshotPipeline::WorkerThread(void *pUser)
+{
+	CWorker *pWorker = static_cast<CWorker *>(pUser);
+	CSnapshotPipeline *pPipeline = pWorker->m_pPipeline;
+	while(true)
+	{
+		pPipeline->m_StartSemaphore.Wait();
+		if(pPipeline->m_Shutdown.load())
+			break;
+		pPipeline->ProcessJobs(&pWorker->m_Context);
+		pPipeline->m_DoneSemaphore.Signal();
+	}
+}
+
+void CSnapshotPipeline::ProcessJobs(CContext *pContext)
+{
+	int Index;
+	while((Index = m_NextJob.fetch_add(1)) < m_NumJobs)
+	{
+		if(m_Stage == STAGE_STORE)
+			StoreJob(m_vpJobs[Index].get());
+		else
+			DeltaJob(m_vpJobs[Index].get(), pContext);
+	}
+}
+
+void CSnapshotPipeline::StoreJob(CJob *pJob)
+{
+	const CSnapshot *pSnapshot = pJob->m_Snapshot.AsSnapshot();
+	pJob->m_Crc = pSnapshot->Crc();
+
+	// remove old snapshots
+	pJob->m_pStorage->PurgeUntil(pJob->m_PurgeUntilTick);
+
+	// save the snapshot
+	pJob->m_pStorage->Add(pJob->m_Tick, pJob->m_Tagtime, pJob->m_SnapshotSize, pSnapshot, 0, nullptr);
+
+	// find snapshot that we can perform delta against
+	pJob->m_DeltaTick = -1;
+	pJob->m_pDeltashot = CSnapshot::EmptySnapshot();
+	pJob->m_DeltashotSize = pJob->m_pStorage->Get(pJob->m_AckedTick, nullptr, &pJob->m_pDeltashot, nullptr);
+	if(pJob->m_DeltashotSize >= 0)
+		pJob->m_DeltaTick = pJob->m_AckedTick;
+	else
+		pJob->m_DeltashotSize = sizeof(CSnapshot);
+}
+
+void CSnapshotPipeline::DeltaJob(CJob *pJob, CContext *pContext)
+{
+	// the delta of an identical job is reused when sending
+	if(pJob->m_pShared)
+		return;
+
+	// create delta
+	CSnapshotDelta *pSnapshotDelta = pJob->m_Sixup ? pContext->m_pDeltaSixup : pContext->m_pDelta;
+	const int DeltaSize = pSnapshotDelta->CreateDelta(*pJob->m_pDeltashot, *pJob->m_Snapshot.AsSnapshot(), rust::Slice(pContext->m_aDeltaData, std::size(pContext->m_aDeltaData)));
+
+	// compress it
+	pJob->m_CompressedSize = 0;
+	if(DeltaSize)
+		pJob->m_CompressedSize = CVariableInt::Compress(pContext->m_aDeltaData, DeltaSize, pJob->m_aCompressedData, sizeof(pJob->m_aCompressedData));
+}
@@ -0,0 +1,147 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+
+#ifndef ENGINE_SERVER_SNAPSHOT_PIPELINE_H
+#define ENGINE_SERVER_SNAPSHOT_PIPELINE_H
+
+#include <base/sphore.h>
+
+#include <engine/shared/snapshot.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Runs the per-client snapshot stages that don't depend on game state
+ * (CRC, storage, delta creation and compression) for a batch of clients,
+ * optionally spread over a set of worker threads.
+ *
+ * Building the snapshots (`IGameServer::OnSnap`) and sending them stays on
+ * the game thread. Jobs are filled in client order and read back in the
+ * same order, so the resulting packets don't depend on the thread count.
+ *
+ * Clients that get byte-identical snapshots deltaed against identical base
+ * snapshots (e.g. spectators following the same player) share a single
+ * delta, see `CJob::Result`.
+ */
+class CSnapshotPipeline
+{
+public:
+	class CJob
+	{
+	public:
+		// filled by the game thread
+		int m_ClientId;
+		bool m_Sixup;
+		int m_Tick;
+		int m_PurgeUntilTick;
+		int m_AckedTick;
+		int64_t m_Tagtime;
+		CSnapshotStorage *m_pStorage;
+		CSnapshotBuffer m_Snapshot;
+		int m_SnapshotSize;
+
+		// filled by the pipeline
+		int m_Crc;
+		int m_DeltaTick; // -1 if the acked snapshot is no longer available
+		const CSnapshot *m_pDeltashot;
+		int m_DeltashotSize;
+		// earlier job with the same snapshot and delta base, its compressed
+		// delta is used instead of the one of this job
+		const CJob *m_pShared;
+		int m_CompressedSize; // 0 if the delta is empty
+		char m_aCompressedData[CSnapshot::MAX_SIZE];
+
+		const CJob *Result() const { return m_pShared ? m_pShared : this; }
+	};
+
+private:
+	class CContext
+	{
+	public:
+		CSnapshotDelta *m_pDelta;
+		CSnapshotDelta *m_pDeltaSixup;
+		int32_t m_aDeltaData[CSnapshot::MAX_SIZE / sizeof(int32_t)];
+	};
+
+	class CWorker
+	{
+	public:
+		CSnapshotPipeline *m_pPipeline;
+		rust::Box<CSnapshotDelta> m_pDelta;
+		rust::Box<CSnapshotDelta> m_pDeltaSixup;
+		CContext m_Context;
+		void *m_pThread = nullptr;
+
+		CWorker(CSnapshotPipeline *pPipeline, CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup);
+	};
+
+	enum EStage
+	{
+		STAGE_STORE,
+		STAGE_DELTA,
+	};
+
+	std::vector<std::unique_ptr<CJob>> m_vpJobs;
+	int m_NumJobs = 0;
+	std::atomic<int> m_NextJob{0};
+	EStage m_Stage = STAGE_STORE;
+
+	std::vector<std::unique_ptr<CWorker>> m_vpWorkers;
+	CSemaphore m_StartSemaphore;
+	CSemaphore m_DoneSemaphore;
+	std::atomic<bool> m_Shutdown{false};
+
+	std::unique_ptr<CContext> m_pMainContext;
+
+	static void WorkerThread(void *pUser);
+	void RunStage(EStage Stage);
+	void ProcessJobs(CContext *pContext);
+	void FindSharedJobs();
+	static void StoreJob(CJob *pJob);
+	static void DeltaJob(CJob *pJob, CContext *pContext);
+
+public:
+	CSnapshotPipeline();
+	~CSnapshotPipeline();
+
+	/**
+	 * Starts the given number of additional worker threads. The game thread
+	 * always takes part in processing, so `0` processes all jobs serially.
+	 *
+	 * @param NumThreads Number of worker threads.
+	 * @param pDelta Delta used as a template for the worker threads.
+	 * @param pDeltaSixup Delta for 0.7 clients used as a template for the worker threads.
+	 *
+	 * @remark The deltas must already have all static sizes registered.
+	 */
+	void Init(int NumThreads, CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup);
+	void Shutdown();
+	int NumThreads() const { return m_vpWorkers.size(); }
+
+	/**
+	 * Returns the next unused job of the current batch.
+	 */
+	CJob *NewJob();
+	int NumJobs() const { return m_NumJobs; }
+	CJob *Job(int Index) { return m_vpJobs[Index].get(); }
+
+	/**
+	 * Processes all jobs of the current batch and waits for their completion.
+	 * Storing the snapshots and creating the deltas are two separate stages,
+	 * so that identical jobs can be found in between.
+	 *
+	 * @param pDelta Delta used for jobs processed by the calling thread.
+	 * @param pDeltaSixup Delta for 0.7 clients used for jobs processed by the calling thread.
+	 */
+	void Run(CSnapshotDelta *pDelta, CSnapshotDelta *pDeltaSixup);
+
+	/**
+	 * Clears the current batch. Job buffers are kept for the next batch.
+	 */
+	void Clear() { m_NumJobs = 0; }
+};
+
+#endif
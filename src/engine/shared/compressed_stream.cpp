@@ -0,0 +1,184 @@
+#include "compressed_stream.h"
+
+#include <base/bytes.h>
+#include <base/dbg.h>
+#include <base/io.h>
+#include <base/math.h>
+#include <base/mem.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+
+const unsigned char CCompressedStream::MAGIC[MAGIC_SIZE] = {'D', 'D', 'N', 'E', 'T', 'Z', 'B', 1};
+
+bool CCompressedStream::IsCompressed(const void *pData, int DataSize)
+{
+	return DataSize >= MAGIC_SIZE && mem_comp(pData, MAGIC, MAGIC_SIZE) == 0;
+}
+
+CCompressedStreamWriter::CCompressedStreamWriter(int Level, int BlockSize) :
+	m_Level(Level), m_BlockSize(BlockSize)
+{
+	dbg_assert(BlockSize > 0 && BlockSize <= CCompressedStream::MAX_BLOCK_SIZE, "invalid block size");
+	m_vBuffer.reserve(m_BlockSize);
+}
+
+int CCompressedStreamWriter::Write(IOHANDLE File, const void *pData, unsigned DataSize)
+{
+	const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+	while(DataSize > 0)
+	{
+		// compress directly from the input if nothing is buffered
+		if(m_vBuffer.empty() && DataSize >= m_BlockSize)
+		{
+			const int Error = WriteBlock(File, pBytes, m_BlockSize);
+			if(Error)
+				return Error;
+			pBytes += m_BlockSize;
+			DataSize -= m_BlockSize;
+			continue;
+		}
+
+		const unsigned Size = minimum<unsigned>(DataSize, m_BlockSize - m_vBuffer.size());
+		m_vBuffer.insert(m_vBuffer.end(), pBytes, pBytes + Size);
+		pBytes += Size;
+		DataSize -= Size;
+		if(m_vBuffer.size() == m_BlockSize)
+		{
+			const int Error = WriteBlock(File, m_vBuffer.data(), m_vBuffer.size());
+			m_vBuffer.clear();
+			if(Error)
+				return Error;
+		}
+	}
+	return 0;
+}
+
+int CCompressedStreamWriter::Flush(IOHANDLE File)
+{
+	int Error = 0;
+	if(!m_vBuffer.empty() || !m_MagicWritten)
+	{
+		Error = WriteBlock(File, m_vBuffer.data(), m_vBuffer.size());
+		m_vBuffer.clear();
+	}
+	return Error;
+}
+
+int CCompressedStreamWriter::AioEncoder(void *pUser, IOHANDLE File, const void *pData, unsigned DataSize)
+{
+	CCompressedStreamWriter *pWriter = static_cast<CCompressedStreamWriter *>(pUser);
+	if(!pData)
+		return pWriter->Flush(File);
+	return pWriter->Write(File, pData, DataSize);
+}
+
+int CCompressedStreamWriter::WriteBlock(IOHANDLE File, const unsigned char *pData, unsigned DataSize)
+{
+	if(!m_MagicWritten)
+	{
+		if(io_write(File, CCompressedStream::MAGIC, sizeof(CCompressedStream::MAGIC)) != sizeof(CCompressedStream::MAGIC))
+			return 1;
+		m_MagicWritten = true;
+	}
+	if(DataSize == 0)
+		return 0;
+
+	uLongf CompressedSize = compressBound(DataSize);
+	m_vCompressed.resize(CCompressedStream::BLOCK_HEADER_SIZE + CompressedSize);
+	const int Result = compress2(m_vCompressed.data() + CCompressedStream::BLOCK_HEADER_SIZE, &CompressedSize, pData, DataSize, m_Level);
+	if(Result != Z_OK)
+		return Result;
+
+	uint_to_bytes_be(&m_vCompressed[0], DataSize);
+	uint_to_bytes_be(&m_vCompressed[4], CompressedSize);
+	uint_to_bytes_be(&m_vCompressed[8], m_Offset >> 32);
+	uint_to_bytes_be(&m_vCompressed[12], m_Offset & 0xffffffffu);
+	m_Offset += DataSize;
+
+	const unsigned Size = CCompressedStream::BLOCK_HEADER_SIZE + CompressedSize;
+	return io_write(File, m_vCompressed.data(), Size) != Size;
+}
+
+bool CCompressedStreamReader::Open(IOHANDLE File)
+{
+	m_File = File;
+	unsigned char aMagic[CCompressedStream::MAGIC_SIZE];
+	m_Error = io_read(File, aMagic, sizeof(aMagic)) != sizeof(aMagic) || !CCompressedStream::IsCompressed(aMagic, sizeof(aMagic));
+	return !m_Error;
+}
+
+bool CCompressedStreamReader::ReadBlock(std::vector<unsigned char> &vData, uint64_t *pOffset)
+{
+	if(m_Error || !m_File)
+		return false;
+
+	unsigned char aHeader[CCompressedStream::BLOCK_HEADER_SIZE];
+	const unsigned HeaderRead = io_read(m_File, aHeader, sizeof(aHeader));
+	if(HeaderRead == 0)
+		return false;
+
+	m_Error = true;
+	if(HeaderRead != sizeof(aHeader))
+		return false;
+	const unsigned Size = bytes_be_to_uint(&aHeader[0]);
+	const unsigned CompressedSize = bytes_be_to_uint(&aHeader[4]);
+	if(Size == 0 || Size > CCompressedStream::MAX_BLOCK_SIZE || CompressedSize > compressBound(CCompressedStream::MAX_BLOCK_SIZE))
+		return false;
+
+	m_vCompressed.resize(CompressedSize);
+	if(io_read(m_File, m_vCompressed.data(), CompressedSize) != CompressedSize)
+		return false;
+
+	vData.resize(Size);
+	uLongf UncompressedSize = Size;
+	if(uncompress(vData.data(), &UncompressedSize, m_vCompressed.data(), CompressedSize) != Z_OK || UncompressedSize != Size)
+		return false;
+
+	if(pOffset)
+		*pOffset = ((uint64_t)bytes_be_to_uint(&aHeader[8]) << 32) | bytes_be_to_uint(&aHeader[12]);
+	m_Error = false;
+	return true;
+}
+
+bool CCompressedStreamReader::ReadBlockTable()
+{
+	if(m_Error || !m_File)
+		return false;
+
+	m_vBlocks.clear();
+	const int64_t Start = io_tell(m_File);
+	const int64_t FileSize = io_length(m_File);
+	int64_t FilePos = Start;
+	uint64_t Offset = 0;
+	while(FileSize - FilePos >= CCompressedStream::BLOCK_HEADER_SIZE)
+	{
+		unsigned char aHeader[CCompressedStream::BLOCK_HEADER_SIZE];
+		if(io_seek(m_File, FilePos, IOSEEK_START) != 0 || io_read(m_File, aHeader, sizeof(aHeader)) != sizeof(aHeader))
+			break;
+		const unsigned Size = bytes_be_to_uint(&aHeader[0]);
+		const unsigned CompressedSize = bytes_be_to_uint(&aHeader[4]);
+		if(Size == 0 || Size > CCompressedStream::MAX_BLOCK_SIZE || FileSize - FilePos - CCompressedStream::BLOCK_HEADER_SIZE < CompressedSize)
+			break;
+		m_vBlocks.push_back({FilePos, Offset, Size});
+		Offset += Size;
+		FilePos += CCompressedStream::BLOCK_HEADER_SIZE + CompressedSize;
+	}
+	return io_seek(m_File, Start, IOSEEK_START) == 0;
+}
+
+uint64_t CCompressedStreamReader::Size() const
+{
+	return m_vBlocks.empty() ? 0 : m_vBlocks.back().m_Offset + m_vBlocks.back().m_Size;
+}
+
+bool CCompressedStreamReader::SeekBlock(uint64_t Offset)
+{
+	auto It = std::upper_bound(m_vBlocks.begin(), m_vBlocks.end(), Offset, [](uint64_t Value, const CBlock &Block) { return Value < Block.m_Offset; });
+	if(It == m_vBlocks.begin() || Offset >= Size())
+		return false;
+	--It;
+	m_Error = io_seek(m_File, It->m_FilePos, IOSEEK_START) != 0;
+	return !m_Error;
+}
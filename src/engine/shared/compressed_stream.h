@@ -0,0 +1,130 @@
+#ifndef ENGINE_SHARED_COMPRESSED_STREAM_H
+#define ENGINE_SHARED_COMPRESSED_STREAM_H
+
+#include <base/types.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Container for a compressed stream of bytes, e.g. a teehistorian file.
+ *
+ * The stream is split into blocks that are compressed with zlib
+ * independently of each other, so a file that was cut off (e.g. by a
+ * server crash) can be decoded up to the last complete block and a reader
+ * can start decoding at any block.
+ *
+ * Format: an 8 byte magic followed by blocks, each consisting of a 16 byte
+ * header (uncompressed size, compressed size and 64 bit offset of the block
+ * in the uncompressed stream, all big endian) and the zlib data.
+ */
+class CCompressedStream
+{
+public:
+	enum
+	{
+		MAGIC_SIZE = 8,
+		BLOCK_HEADER_SIZE = 16,
+		DEFAULT_BLOCK_SIZE = 256 * 1024,
+		MAX_BLOCK_SIZE = 16 * 1024 * 1024,
+	};
+	static const unsigned char MAGIC[MAGIC_SIZE];
+
+	static bool IsCompressed(const void *pData, int DataSize);
+};
+
+class CCompressedStreamWriter
+{
+public:
+	CCompressedStreamWriter(int Level, int BlockSize = CCompressedStream::DEFAULT_BLOCK_SIZE);
+
+	/**
+	 * Buffers the data and writes every complete block.
+	 *
+	 * @return `0` on success, or non-`0` on error.
+	 */
+	int Write(IOHANDLE File, const void *pData, unsigned DataSize);
+
+	/**
+	 * Writes the buffered data as a last, possibly smaller block.
+	 *
+	 * @return `0` on success, or non-`0` on error.
+	 */
+	int Flush(IOHANDLE File);
+
+	/**
+	 * Encoder for @link aio_new_encoded @endlink, the user pointer has to
+	 * point to a `CCompressedStreamWriter`.
+	 */
+	static int AioEncoder(void *pUser, IOHANDLE File, const void *pData, unsigned DataSize);
+
+private:
+	int WriteBlock(IOHANDLE File, const unsigned char *pData, unsigned DataSize);
+
+	int m_Level;
+	unsigned m_BlockSize;
+	bool m_MagicWritten = false;
+	uint64_t m_Offset = 0;
+	std::vector<unsigned char> m_vBuffer;
+	std::vector<unsigned char> m_vCompressed;
+};
+
+class CCompressedStreamReader
+{
+public:
+	/**
+	 * Checks the magic at the current position of the file, which is left
+	 * at the first block afterwards.
+	 */
+	bool Open(IOHANDLE File);
+
+	/**
+	 * Decompresses the next block.
+	 *
+	 * @param vData Receives the uncompressed data of the block.
+	 * @param pOffset Optionally receives the offset of the block in the
+	 * uncompressed stream.
+	 *
+	 * @return `false` at the end of the file or on error, see @link Error @endlink.
+	 */
+	bool ReadBlock(std::vector<unsigned char> &vData, uint64_t *pOffset = nullptr);
+
+	/**
+	 * @return `true` if the file is corrupted or cut off in the middle of a block.
+	 */
+	bool Error() const { return m_Error; }
+
+	/**
+	 * Reads the headers of all blocks without decompressing them, which
+	 * allows seeking with @link SeekBlock @endlink. A block that is cut off
+	 * ends the stream. The file is left at the first block afterwards.
+	 */
+	bool ReadBlockTable();
+
+	/**
+	 * @return Size of the uncompressed stream, only valid after
+	 * @link ReadBlockTable @endlink.
+	 */
+	uint64_t Size() const;
+
+	/**
+	 * Moves to the block containing the given offset of the uncompressed
+	 * stream, the next @link ReadBlock @endlink decompresses it.
+	 */
+	bool SeekBlock(uint64_t Offset);
+
+private:
+	struct CBlock
+	{
+		int64_t m_FilePos;
+		uint64_t m_Offset;
+		unsigned m_Size;
+	};
+
+	IOHANDLE m_File = nullptr;
+	bool m_Error = false;
+	std::vector<unsigned char> m_vCompressed;
+	std::vector<CBlock> m_vBlocks;
+};
+
+#endif
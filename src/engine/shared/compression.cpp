@@ -4,8 +4,17 @@
 
 #include <base/dbg.h>
 
+#include <bit>
 #include <iterator> // std::size
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VARINT_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define VARINT_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 // Format: ESDDDDDD EDDDDDDD EDD... Extended, Data, Sign
 unsigned char *CVariableInt::Pack(unsigned char *pDst, int i, int DstSize)
 {
@@ -65,6 +74,87 @@ const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut
 	return pSrc;
 }
 
+#if defined(VARINT_SIMD_SSE2) || defined(VARINT_SIMD_NEON)
+// Most ints of snapshot deltas are in [-64, 63] and packed into a single
+// byte without the extend bit. These helpers handle 16 of them at once and
+// return how many of the leading ints (bytes) actually were single byte
+// ones, everything they wrote after those has to be ignored.
+static int PackSingleBytes(const int *pSrc, unsigned char *pDst)
+{
+#if defined(VARINT_SIMD_SSE2)
+	__m128i aBytes[4];
+	__m128i aFits[4];
+	for(int i = 0; i < 4; i++)
+	{
+		const __m128i Int = _mm_loadu_si128((const __m128i *)(pSrc + i * 4));
+		const __m128i Sign = _mm_srai_epi32(Int, 31);
+		const __m128i Value = _mm_xor_si128(Int, Sign); // ~i for negative ints
+		aFits[i] = _mm_cmpeq_epi32(_mm_srli_epi32(Value, 6), _mm_setzero_si128());
+		aBytes[i] = _mm_or_si128(Value, _mm_and_si128(Sign, _mm_set1_epi32(0x40)));
+	}
+	const __m128i Bytes = _mm_packus_epi16(_mm_packs_epi32(aBytes[0], aBytes[1]), _mm_packs_epi32(aBytes[2], aBytes[3]));
+	const __m128i Fits = _mm_packs_epi16(_mm_packs_epi32(aFits[0], aFits[1]), _mm_packs_epi32(aFits[2], aFits[3]));
+	_mm_storeu_si128((__m128i *)pDst, Bytes);
+	return std::countr_one((unsigned)_mm_movemask_epi8(Fits));
+#else
+	int16x8_t aBytes[2];
+	uint16x8_t aFits[2];
+	for(int i = 0; i < 2; i++)
+	{
+		int16x4_t aNarrowBytes[2];
+		uint16x4_t aNarrowFits[2];
+		for(int j = 0; j < 2; j++)
+		{
+			const int32x4_t Int = vld1q_s32(pSrc + i * 8 + j * 4);
+			const int32x4_t Sign = vshrq_n_s32(Int, 31);
+			const int32x4_t Value = veorq_s32(Int, Sign); // ~i for negative ints
+			aNarrowFits[j] = vmovn_u32(vceqq_s32(vshrq_n_s32(Value, 6), vdupq_n_s32(0)));
+			aNarrowBytes[j] = vqmovn_s32(vorrq_s32(Value, vandq_s32(Sign, vdupq_n_s32(0x40))));
+		}
+		aBytes[i] = vcombine_s16(aNarrowBytes[0], aNarrowBytes[1]);
+		aFits[i] = vcombine_u16(aNarrowFits[0], aNarrowFits[1]);
+	}
+	vst1q_u8(pDst, vcombine_u8(vqmovun_s16(aBytes[0]), vqmovun_s16(aBytes[1])));
+	const uint8x16_t Fits = vcombine_u8(vmovn_u16(aFits[0]), vmovn_u16(aFits[1]));
+	// one nibble per byte
+	const uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Fits), 4)), 0);
+	return std::countr_one(Mask) / 4;
+#endif
+}
+
+static int UnpackSingleBytes(const unsigned char *pSrc, int *pDst)
+{
+#if defined(VARINT_SIMD_SSE2)
+	const __m128i Bytes = _mm_loadu_si128((const __m128i *)pSrc);
+	const __m128i Sign = _mm_cmpeq_epi8(_mm_and_si128(Bytes, _mm_set1_epi8(0x40)), _mm_set1_epi8(0x40));
+	// the sign extension of ~Data is ~i
+	const __m128i Result = _mm_xor_si128(_mm_and_si128(Bytes, _mm_set1_epi8(0x3F)), Sign);
+	const __m128i Low = _mm_unpacklo_epi8(Result, Result);
+	const __m128i High = _mm_unpackhi_epi8(Result, Result);
+	_mm_storeu_si128((__m128i *)(pDst + 0), _mm_srai_epi32(_mm_unpacklo_epi16(Low, Low), 24));
+	_mm_storeu_si128((__m128i *)(pDst + 4), _mm_srai_epi32(_mm_unpackhi_epi16(Low, Low), 24));
+	_mm_storeu_si128((__m128i *)(pDst + 8), _mm_srai_epi32(_mm_unpacklo_epi16(High, High), 24));
+	_mm_storeu_si128((__m128i *)(pDst + 12), _mm_srai_epi32(_mm_unpackhi_epi16(High, High), 24));
+	return std::countr_zero((unsigned)_mm_movemask_epi8(Bytes) | 0x10000u);
+#else
+	const uint8x16_t Bytes = vld1q_u8(pSrc);
+	const uint8x16_t Sign = vtstq_u8(Bytes, vdupq_n_u8(0x40));
+	// the sign extension of ~Data is ~i
+	const int8x16_t Result = vreinterpretq_s8_u8(veorq_u8(vandq_u8(Bytes, vdupq_n_u8(0x3F)), Sign));
+	const int16x8_t Low = vmovl_s8(vget_low_s8(Result));
+	const int16x8_t High = vmovl_s8(vget_high_s8(Result));
+	vst1q_s32(pDst + 0, vmovl_s16(vget_low_s16(Low)));
+	vst1q_s32(pDst + 4, vmovl_s16(vget_high_s16(Low)));
+	vst1q_s32(pDst + 8, vmovl_s16(vget_low_s16(High)));
+	vst1q_s32(pDst + 12, vmovl_s16(vget_high_s16(High)));
+	// one nibble per byte
+	const uint8x16_t Extended = vcltq_s8(vreinterpretq_s8_u8(Bytes), vdupq_n_s8(0));
+	const uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Extended), 4)), 0);
+	return std::countr_zero(Mask) / 4;
+#endif
+}
+#endif
+
 long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int DstSize)
 {
 	dbg_assert(DstSize % sizeof(int) == 0, "invalid bounds");
@@ -75,6 +165,16 @@ long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int Dst
 	const int *pIntDstEnd = pIntDst + DstSize / sizeof(int); // NOLINT(bugprone-sizeof-expression)
 	while(pCharSrc < pCharSrcEnd)
 	{
+#if defined(VARINT_SIMD_SSE2) || defined(VARINT_SIMD_NEON)
+		if(pCharSrcEnd - pCharSrc >= 16 && pIntDstEnd - pIntDst >= 16)
+		{
+			const int Num = UnpackSingleBytes(pCharSrc, pIntDst);
+			pCharSrc += Num;
+			pIntDst += Num;
+			if(Num == 16)
+				continue;
+		}
+#endif
 		if(pIntDst >= pIntDstEnd)
 			return -1;
 		pCharSrc = CVariableInt::Unpack(pCharSrc, pIntDst, pCharSrcEnd - pCharSrc);
@@ -95,6 +195,17 @@ long CVariableInt::Compress(const void *pSrc, int SrcSize, void *pDst, int DstSi
 	SrcSize /= sizeof(int);
 	while(SrcSize)
 	{
+#if defined(VARINT_SIMD_SSE2) || defined(VARINT_SIMD_NEON)
+		if(SrcSize >= 16 && pCharDstEnd - pCharDst >= 16)
+		{
+			const int Num = PackSingleBytes(pIntSrc, pCharDst);
+			pCharDst += Num;
+			pIntSrc += Num;
+			SrcSize -= Num;
+			if(Num == 16)
+				continue;
+		}
+#endif
 		pCharDst = CVariableInt::Pack(pCharDst, *pIntSrc, pCharDstEnd - pCharDst);
 		if(!pCharDst)
 			return -1;
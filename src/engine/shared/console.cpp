@@ -667,9 +667,46 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+unsigned CConsole::NameHash(const char *pName)
+{
+	// same as str_quickhash, but ignoring the case like str_comp_nocase
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+	{
+		const char c = *pName >= 'A' && *pName <= 'Z' ? *pName - 'A' + 'a' : *pName;
+		Hash = ((Hash << 5) + Hash) + c;
+	}
+	return Hash;
+}
+
+void CConsole::AddCommandIndex(CCommand *pCommand)
+{
+	// sorted like AddCommandSorted, so the first match is the same as in the command list
+	std::vector<CCommand *> &vpBucket = m_CommandIndex[NameHash(pCommand->m_pName)];
+	auto It = std::find_if(vpBucket.begin(), vpBucket.end(), [pCommand](const CCommand *pOther) {
+		return str_comp(pCommand->m_pName, pOther->m_pName) <= 0;
+	});
+	vpBucket.insert(It, pCommand);
+}
+
+void CConsole::RemoveCommandIndex(CCommand *pCommand)
+{
+	auto BucketIt = m_CommandIndex.find(NameHash(pCommand->m_pName));
+	if(BucketIt == m_CommandIndex.end())
+		return;
+	std::vector<CCommand *> &vpBucket = BucketIt->second;
+	vpBucket.erase(std::remove(vpBucket.begin(), vpBucket.end(), pCommand), vpBucket.end());
+	if(vpBucket.empty())
+		m_CommandIndex.erase(BucketIt);
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto BucketIt = m_CommandIndex.find(NameHash(pName));
+	if(BucketIt == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : BucketIt->second)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -935,12 +972,11 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 
 void CConsole::AddCommandSorted(CCommand *pCommand)
 {
+	AddCommandIndex(pCommand);
+
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->Next())
-			pCommand->SetNext(m_pFirstCommand);
-		else
-			pCommand->SetNext(nullptr);
+		pCommand->SetNext(m_pFirstCommand);
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -1045,6 +1081,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandIndex(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1052,6 +1089,16 @@ void CConsole::DeregisterTemp(const char *pName)
 
 void CConsole::DeregisterTempAll()
 {
+	for(auto BucketIt = m_CommandIndex.begin(); BucketIt != m_CommandIndex.end();)
+	{
+		std::vector<CCommand *> &vpBucket = BucketIt->second;
+		vpBucket.erase(std::remove_if(vpBucket.begin(), vpBucket.end(), [](const CCommand *pCommand) { return pCommand->m_Temp; }), vpBucket.end());
+		if(vpBucket.empty())
+			BucketIt = m_CommandIndex.erase(BucketIt);
+		else
+			++BucketIt;
+	}
+
 	// set non temp as first one
 	for(; m_pFirstCommand && m_pFirstCommand->m_Temp; m_pFirstCommand = m_pFirstCommand->Next())
 		;
@@ -1118,7 +1165,11 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto BucketIt = m_CommandIndex.find(NameHash(pName));
+	if(BucketIt == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : BucketIt->second)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
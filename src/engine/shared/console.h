@@ -9,6 +9,7 @@
 #include <engine/storage.h>
 
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 class CConsole : public IConsole
@@ -163,6 +164,13 @@ class CConsole : public IConsole
 	};
 	std::vector<CExecutionQueueEntry> m_vExecutionQueue;
 
+	// commands by case insensitive hash of their name, each bucket in the
+	// same order as the command list
+	std::unordered_map<unsigned, std::vector<CCommand *>> m_CommandIndex;
+	static unsigned NameHash(const char *pName);
+	void AddCommandIndex(CCommand *pCommand);
+	void RemoveCommandIndex(CCommand *pCommand);
+
 	void AddCommandSorted(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
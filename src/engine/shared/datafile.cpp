@@ -3,6 +3,7 @@
 
 #include "datafile.h"
 
+#include "jobs.h"
 #include "uuid_manager.h"
 
 #include <base/bytes.h>
@@ -19,8 +20,11 @@
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdlib>
 #include <limits>
+#include <numeric>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
@@ -1144,21 +1148,111 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+void CDataFileWriter::CompressData(CDataInfo &DataInfo)
+{
+	unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
+	DataInfo.m_pCompressedData = malloc(CompressedSize);
+	const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+	DataInfo.m_CompressedSize = CompressedSize;
+	free(DataInfo.m_pUncompressedData);
+	DataInfo.m_pUncompressedData = nullptr;
+	dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+}
+
+// Data blocks are claimed one at a time by the compression jobs and the thread
+// calling Finish, so Finish makes progress even if no worker thread is available.
+class CDataFileWriter::CCompression
+{
+public:
+	std::vector<CDataInfo> *m_pvDatas;
+	// largest blocks first, so a large image is not compressed last
+	std::vector<int> m_vOrder;
+	std::atomic<size_t> m_NextOrder = 0;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_DoneCondition;
+	size_t m_NumDone = 0;
+
+	CCompression(std::vector<CDataInfo> *pvDatas) :
+		m_pvDatas(pvDatas),
+		m_vOrder(pvDatas->size())
+	{
+		std::iota(m_vOrder.begin(), m_vOrder.end(), 0);
+		std::stable_sort(m_vOrder.begin(), m_vOrder.end(), [&](int Left, int Right) {
+			return (*pvDatas)[Left].m_UncompressedSize > (*pvDatas)[Right].m_UncompressedSize;
+		});
+	}
+
+	void Run()
+	{
+		while(true)
+		{
+			// the data must not be accessed once all blocks have been claimed,
+			// because Finish may already have returned
+			const size_t Order = m_NextOrder++;
+			if(Order >= m_vOrder.size())
+			{
+				return;
+			}
+			CompressData((*m_pvDatas)[m_vOrder[Order]]);
+
+			const std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_NumDone++;
+			if(m_NumDone == m_vOrder.size())
+			{
+				m_DoneCondition.notify_all();
+			}
+		}
+	}
+
+	void Wait()
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_DoneCondition.wait(Lock, [&]() { return m_NumDone == m_vOrder.size(); });
+	}
+};
+
+class CDataFileWriter::CCompressionJob : public IJob
+{
+	std::shared_ptr<CCompression> m_pCompression;
+
+	void Run() override
+	{
+		m_pCompression->Run();
+	}
+
+public:
+	CCompressionJob(std::shared_ptr<CCompression> pCompression) :
+		m_pCompression(std::move(pCompression))
+	{
+	}
+};
+
+void CDataFileWriter::Finish(CJobPool *pJobPool)
 {
 	dbg_assert((bool)m_File, "File not open");
 
 	// Compress data. This takes the majority of the time when saving a datafile,
-	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+	// so it's delayed until the end so it can be off-loaded to other threads.
+	// Every block is compressed independently, so the output does not depend on
+	// the number of threads.
+	const int NumJobs = pJobPool == nullptr ? 0 : minimum<int>(pJobPool->NumThreads(), (int)m_vDatas.size() - 1);
+	if(NumJobs > 0)
+	{
+		std::shared_ptr<CCompression> pCompression = std::make_shared<CCompression>(&m_vDatas);
+		for(int i = 0; i < NumJobs; i++)
+		{
+			pJobPool->Add(std::make_shared<CCompressionJob>(pCompression));
+		}
+		pCompression->Run();
+		pCompression->Wait();
+	}
+	else
 	{
-		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
-		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
-		DataInfo.m_CompressedSize = CompressedSize;
-		free(DataInfo.m_pUncompressedData);
-		DataInfo.m_pUncompressedData = nullptr;
-		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+		for(CDataInfo &DataInfo : m_vDatas)
+		{
+			CompressData(DataInfo);
+		}
 	}
 
 	// Calculate total size of items
@@ -14,6 +14,8 @@
 #include <map>
 #include <vector>
 
+class CJobPool;
+
 enum
 {
 	ITEMTYPE_EX = 0xFFFF,
@@ -107,6 +109,9 @@ private:
 		CUuid m_Uuid;
 	};
 
+	class CCompression;
+	class CCompressionJob;
+
 	IOHANDLE m_File;
 	std::map<uint16_t, CItemTypeInfo, std::less<>> m_ItemTypes; // item types must be sorted in ascending order
 	std::vector<CItemInfo> m_vItems;
@@ -115,6 +120,7 @@ private:
 
 	int GetTypeFromIndex(int Index) const;
 	int GetExtendedItemTypeIndex(int Type, const CUuid *pUuid);
+	static void CompressData(CDataInfo &DataInfo);
 
 public:
 	CDataFileWriter();
@@ -134,7 +140,14 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
-	void Finish();
+	/**
+	 * Compresses all data and writes the file.
+	 *
+	 * @param pJobPool Optional job pool to compress data blocks in parallel. The calling
+	 * thread compresses blocks as well, so this is safe to call from a job of the same pool.
+	 * The written file is identical to the one written without job pool.
+	 */
+	void Finish(CJobPool *pJobPool = nullptr);
 };
 
 #endif
@@ -8,6 +8,7 @@
 #include <base/math.h>
 #include <base/mem.h>
 #include <base/str.h>
+#include <base/thread.h>
 #include <base/time.h>
 
 #include <engine/console.h>
@@ -23,6 +24,8 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <utility>
+
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
 		0x9b, 0x5b, 0x12, 0x89, 0xc8, 0x42, 0xd7, 0x80}};
@@ -207,6 +210,8 @@ int CDemoRecorder::Start(IStorage *pStorage, IConsole *pConsole, const char *pFi
 	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
+	m_DataStart = io_tell(DemoFile);
+	m_vKeyFrames.clear();
 	m_NumTimelineMarkers = 0;
 
 	if(m_pConsole)
@@ -248,11 +253,39 @@ enum
 	CHUNKMASK_TYPE = 0x60,
 	CHUNKMASK_SIZE = 0x1f,
 
+	CHUNKTYPE_KEYFRAME_INDEX = 0, // skipped by players that don't know about it
 	CHUNKTYPE_SNAPSHOT = 1,
 	CHUNKTYPE_MESSAGE = 2,
 	CHUNKTYPE_DELTA = 3,
 };
 
+/*
+	Keyframe index, appended when the recording is stopped
+
+	Index chunks
+		0	= Number of keyframes in this chunk
+		1-n	= Pairs of tick and file position, each relative to the
+			  previous keyframe, the first one relative to tick 0 and
+			  the start of the chunks
+
+	Trailer chunk, always the last chunk of the file
+		see `EKeyFrameIndexTrailer`
+*/
+
+static const int gs_KeyFrameIndexMagic = 0x4b465831; // "KFX1"
+static const int gs_KeyFramesPerIndexChunk = 1024;
+
+enum EKeyFrameIndexTrailer
+{
+	TRAILER_MAGIC,
+	TRAILER_INDEX_START_HIGH,
+	TRAILER_INDEX_START_LOW,
+	TRAILER_NUM_KEYFRAMES,
+	TRAILER_FIRST_TICK,
+	TRAILER_LAST_TICK,
+	NUM_TRAILER_FIELDS,
+};
+
 void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 {
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
@@ -332,6 +365,11 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 {
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
 	{
+		// remember the keyframe for the index
+		const int64_t Filepos = io_tell(m_File);
+		if(Filepos >= 0)
+			m_vKeyFrames.emplace_back(Filepos, Tick);
+
 		// write full tickmarker
 		WriteTickMarker(Tick, true);
 
@@ -370,6 +408,40 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 	Write(CHUNKTYPE_MESSAGE, pData, Size);
 }
 
+void CDemoRecorder::WriteKeyFrameIndex()
+{
+	const int64_t IndexStart = io_tell(m_File);
+	if(m_vKeyFrames.empty() || m_DataStart < 0 || IndexStart < 0)
+		return;
+
+	int32_t aIndex[1 + gs_KeyFramesPerIndexChunk * 2];
+	int PrevTick = 0;
+	int64_t PrevFilepos = m_DataStart;
+	for(size_t First = 0; First < m_vKeyFrames.size(); First += gs_KeyFramesPerIndexChunk)
+	{
+		const int Num = minimum<size_t>(m_vKeyFrames.size() - First, gs_KeyFramesPerIndexChunk);
+		aIndex[0] = Num;
+		for(int i = 0; i < Num; i++)
+		{
+			const CDemoKeyFrame &KeyFrame = m_vKeyFrames[First + i];
+			aIndex[1 + i * 2] = KeyFrame.m_Tick - PrevTick;
+			aIndex[2 + i * 2] = KeyFrame.m_Filepos - PrevFilepos;
+			PrevTick = KeyFrame.m_Tick;
+			PrevFilepos = KeyFrame.m_Filepos;
+		}
+		Write(CHUNKTYPE_KEYFRAME_INDEX, aIndex, (1 + Num * 2) * sizeof(int32_t));
+	}
+
+	int32_t aTrailer[NUM_TRAILER_FIELDS];
+	aTrailer[TRAILER_MAGIC] = gs_KeyFrameIndexMagic;
+	aTrailer[TRAILER_INDEX_START_HIGH] = (uint32_t)(IndexStart >> 32);
+	aTrailer[TRAILER_INDEX_START_LOW] = (uint32_t)IndexStart;
+	aTrailer[TRAILER_NUM_KEYFRAMES] = m_vKeyFrames.size();
+	aTrailer[TRAILER_FIRST_TICK] = m_FirstTick;
+	aTrailer[TRAILER_LAST_TICK] = m_LastTickMarker;
+	Write(CHUNKTYPE_KEYFRAME_INDEX, aTrailer, sizeof(aTrailer));
+}
+
 int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename)
 {
 	if(!m_File)
@@ -377,6 +449,9 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 
 	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE)
 	{
+		// append the keyframe index so that players don't have to scan the file
+		WriteKeyFrameIndex();
+
 		// add the demo length to the header
 		io_seek(m_File, offsetof(CDemoHeader, m_aLength), IOSEEK_START);
 		unsigned char aLength[sizeof(int32_t)];
@@ -493,9 +568,12 @@ void CDemoPlayer::Construct(CSnapshotDelta *pSnapshotDelta, CSnapshotDelta *pSna
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_pSnapshotDeltaSixup = pSnapshotDeltaSixup;
-	m_LastSnapshotDataSize = -1;
+	m_Decoder.m_pConsole = nullptr;
+	m_Decoder.m_File = nullptr;
+	m_Decoder.m_LastSnapshotDataSize = -1;
 	m_pListener = nullptr;
 	m_UseVideo = UseVideo;
+	m_ReadAhead = false;
 
 	m_aFilename[0] = '\0';
 	m_aErrorMessage[0] = '\0';
@@ -523,13 +601,18 @@ void CDemoPlayer::SetListener(IListener *pListener)
 	m_pListener = pListener;
 }
 
-CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
+void CDemoPlayer::SetReadAhead(bool ReadAhead)
+{
+	m_ReadAhead = ReadAhead;
+}
+
+CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadChunkHeader(IOHANDLE File, int Version, int *pType, int *pSize, int *pTick)
 {
 	*pSize = 0;
 	*pType = 0;
 
 	unsigned char Chunk = 0;
-	if(io_read(m_File, &Chunk, sizeof(Chunk)) != sizeof(Chunk))
+	if(io_read(File, &Chunk, sizeof(Chunk)) != sizeof(Chunk))
 		return CHUNKHEADER_EOF;
 
 	if(Chunk & CHUNKTYPEFLAG_TICKMARKER)
@@ -539,7 +622,7 @@ CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadChunkHeader(int *pType, int
 		*pType = Chunk & (CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_KEYFRAME);
 
 		int NewTick;
-		if(m_Info.m_Header.m_Version < gs_VersionTickCompression && TickdeltaLegacy != 0)
+		if(Version < gs_VersionTickCompression && TickdeltaLegacy != 0)
 		{
 			if(*pTick < 0) // initial tick not initialized before a tick delta
 				return CHUNKHEADER_ERROR;
@@ -555,7 +638,7 @@ CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadChunkHeader(int *pType, int
 		else
 		{
 			unsigned char aTickdata[sizeof(int32_t)];
-			if(io_read(m_File, aTickdata, sizeof(aTickdata)) != sizeof(aTickdata))
+			if(io_read(File, aTickdata, sizeof(aTickdata)) != sizeof(aTickdata))
 				return CHUNKHEADER_ERROR;
 			NewTick = bytes_be_to_uint(aTickdata);
 		}
@@ -572,14 +655,14 @@ CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadChunkHeader(int *pType, int
 		if(*pSize == 30)
 		{
 			unsigned char aSizedata[1];
-			if(io_read(m_File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
+			if(io_read(File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
 				return CHUNKHEADER_ERROR;
 			*pSize = aSizedata[0];
 		}
 		else if(*pSize == 31)
 		{
 			unsigned char aSizedata[2];
-			if(io_read(m_File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
+			if(io_read(File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
 				return CHUNKHEADER_ERROR;
 			*pSize = (aSizedata[1] << 8) | aSizedata[0];
 		}
@@ -613,7 +696,7 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 			return ResetToStartPosition(EScanFileResult::ERROR_RECOVERABLE);
 		}
 		int ChunkType, ChunkSize;
-		const EReadChunkHeaderResult Result = ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick);
+		const EReadChunkHeaderResult Result = ReadChunkHeader(m_File, m_Info.m_Header.m_Version, &ChunkType, &ChunkSize, &ChunkTick);
 		if(Result != CHUNKHEADER_SUCCESS ||
 			(ChunkSize > 0 && io_skip(m_File, ChunkSize) != 0))
 		{
@@ -630,7 +713,7 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 		}
 
 		int ChunkType, ChunkSize;
-		const EReadChunkHeaderResult Result = ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick);
+		const EReadChunkHeaderResult Result = ReadChunkHeader(m_File, m_Info.m_Header.m_Version, &ChunkType, &ChunkSize, &ChunkTick);
 		if(Result == CHUNKHEADER_EOF)
 		{
 			break;
@@ -665,40 +748,170 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 	return ResetToStartPosition(m_vKeyFrames.empty() ? EScanFileResult::ERROR_UNRECOVERABLE : EScanFileResult::SUCCESS);
 }
 
-void CDemoPlayer::DoTick()
+static int DecompressChunk(const void *pData, int Size, void *pOutput, int OutputSize)
 {
-	// update ticks
-	m_Info.m_PreviousTick = m_Info.m_Info.m_CurrentTick;
-	m_Info.m_Info.m_CurrentTick = m_Info.m_NextTick;
-	int ChunkTick = m_Info.m_Info.m_CurrentTick;
+	unsigned char aDecompressed[CSnapshot::MAX_SIZE];
+	const int DecompressedSize = CNetBase::Decompress(pData, Size, aDecompressed, sizeof(aDecompressed));
+	if(DecompressedSize < 0)
+		return -1;
+	return CVariableInt::Decompress(aDecompressed, DecompressedSize, pOutput, OutputSize);
+}
 
-	UpdateTimes();
+bool CDemoPlayer::ReadKeyFrameIndex()
+{
+	const int64_t DataStart = io_tell(m_File);
+	if(DataStart < 0)
+		return false;
+
+	const auto &Fail = [&]() {
+		m_vKeyFrames.clear();
+		io_seek(m_File, DataStart, IOSEEK_START);
+		return false;
+	};
+
+	// the trailer is the last chunk, find it by trying all chunk sizes that
+	// would end exactly at the end of the file
+	if(io_seek(m_File, 0, IOSEEK_END) != 0)
+		return Fail();
+	const int64_t FileSize = io_tell(m_File);
+	unsigned char aTail[2 + 255];
+	const int TailSize = minimum<int64_t>(FileSize - DataStart, sizeof(aTail));
+	if(TailSize <= 0 ||
+		io_seek(m_File, FileSize - TailSize, IOSEEK_START) != 0 ||
+		io_read(m_File, aTail, TailSize) != (unsigned)TailSize)
+	{
+		return Fail();
+	}
+
+	int32_t aTrailer[NUM_TRAILER_FIELDS];
+	int64_t TrailerStart = -1;
+	for(int Size = 1; Size <= 255 && TrailerStart < 0; Size++)
+	{
+		int HeaderSize;
+		if(Size < 30 && Size + 1 <= TailSize && aTail[TailSize - Size - 1] == (CHUNKTYPE_KEYFRAME_INDEX << 5 | Size))
+			HeaderSize = 1;
+		else if(Size >= 30 && Size + 2 <= TailSize && aTail[TailSize - Size - 2] == (CHUNKTYPE_KEYFRAME_INDEX << 5 | 30) && aTail[TailSize - Size - 1] == Size)
+			HeaderSize = 2;
+		else
+			continue;
+
+		if(DecompressChunk(aTail + TailSize - Size, Size, aTrailer, sizeof(aTrailer)) == (int)sizeof(aTrailer) &&
+			aTrailer[TRAILER_MAGIC] == gs_KeyFrameIndexMagic)
+		{
+			TrailerStart = FileSize - Size - HeaderSize;
+		}
+	}
+	if(TrailerStart < 0)
+		return Fail();
+
+	const int64_t IndexStart = ((int64_t)(uint32_t)aTrailer[TRAILER_INDEX_START_HIGH] << 32) | (uint32_t)aTrailer[TRAILER_INDEX_START_LOW];
+	const int NumKeyFrames = aTrailer[TRAILER_NUM_KEYFRAMES];
+	const int FirstTick = aTrailer[TRAILER_FIRST_TICK];
+	const int LastTick = aTrailer[TRAILER_LAST_TICK];
+	if(IndexStart <= DataStart || IndexStart >= TrailerStart || NumKeyFrames <= 0 ||
+		FirstTick < MIN_TICK || LastTick < FirstTick || LastTick >= MAX_TICK ||
+		io_seek(m_File, IndexStart, IOSEEK_START) != 0)
+	{
+		return Fail();
+	}
+
+	// read the index chunks up to the trailer
+	m_vKeyFrames.clear();
+	m_vKeyFrames.reserve(NumKeyFrames);
+	int Tick = 0;
+	int64_t Filepos = DataStart;
+	unsigned char aCompressed[CSnapshot::MAX_SIZE];
+	int32_t aIndex[1 + gs_KeyFramesPerIndexChunk * 2];
+	while((int)m_vKeyFrames.size() < NumKeyFrames)
+	{
+		int ChunkType, ChunkSize, ChunkTick = -1;
+		if(ReadChunkHeader(m_File, m_Info.m_Header.m_Version, &ChunkType, &ChunkSize, &ChunkTick) != CHUNKHEADER_SUCCESS ||
+			ChunkType != CHUNKTYPE_KEYFRAME_INDEX || ChunkSize <= 0 ||
+			io_read(m_File, aCompressed, ChunkSize) != (unsigned)ChunkSize)
+		{
+			return Fail();
+		}
+
+		const int IndexSize = DecompressChunk(aCompressed, ChunkSize, aIndex, sizeof(aIndex));
+		if(IndexSize < (int)sizeof(int32_t) ||
+			aIndex[0] <= 0 || aIndex[0] > NumKeyFrames - (int)m_vKeyFrames.size() ||
+			IndexSize != (1 + aIndex[0] * 2) * (int)sizeof(int32_t))
+		{
+			return Fail();
+		}
+
+		for(int i = 0; i < aIndex[0]; i++)
+		{
+			const int TickDelta = aIndex[1 + i * 2];
+			const int FileposDelta = aIndex[2 + i * 2];
+			// ticks and file positions are strictly increasing, the first
+			// keyframe is usually the first chunk
+			if(TickDelta < (m_vKeyFrames.empty() ? 0 : 1) || TickDelta > LastTick - Tick ||
+				FileposDelta < (m_vKeyFrames.empty() ? 0 : 1) || FileposDelta >= IndexStart - Filepos)
+			{
+				return Fail();
+			}
+			Tick += TickDelta;
+			Filepos += FileposDelta;
+			m_vKeyFrames.emplace_back(Filepos, Tick);
+		}
+	}
+	if(io_tell(m_File) != TrailerStart || m_vKeyFrames.front().m_Tick < FirstTick)
+		return Fail();
+
+	// make sure the index belongs to this file
+	int ChunkType, ChunkSize, ChunkTick = -1;
+	if(io_seek(m_File, m_vKeyFrames.back().m_Filepos, IOSEEK_START) != 0 ||
+		ReadChunkHeader(m_File, m_Info.m_Header.m_Version, &ChunkType, &ChunkSize, &ChunkTick) != CHUNKHEADER_SUCCESS ||
+		ChunkType != (CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_KEYFRAME) ||
+		ChunkTick != m_vKeyFrames.back().m_Tick ||
+		io_seek(m_File, DataStart, IOSEEK_START) != 0)
+	{
+		return Fail();
+	}
+
+	m_Info.m_Info.m_FirstTick = FirstTick;
+	m_Info.m_Info.m_LastTick = LastTick;
+	m_Info.m_KeyFrameIndex = true;
+	return true;
+}
+
+void CDemoPlayer::CDecodedTick::Clear()
+{
+	m_vChunks.clear();
+	m_vData.clear();
+	m_End = END_TICK;
+	m_NextTick = -1;
+	m_pError = "";
+}
+
+void CDemoPlayer::CDecodedTick::AddChunk(int Type, const void *pData, int Size)
+{
+	// keep the data of every chunk aligned for snapshots
+	const size_t Offset = m_vData.size();
+	m_vData.resize(Offset + (Size + sizeof(int32_t) - 1) / sizeof(int32_t));
+	mem_copy(m_vData.data() + Offset, pData, Size);
+	m_vChunks.push_back({Type, Offset, Size});
+}
+
+void CDemoPlayer::CDecoder::DecodeTick(CDecodedTick *pTick)
+{
+	pTick->Clear();
 
 	bool GotSnapshot = false;
 	while(true)
 	{
 		int ChunkType, ChunkSize;
-		const EReadChunkHeaderResult Result = ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick);
+		const EReadChunkHeaderResult Result = ReadChunkHeader(m_File, m_Version, &ChunkType, &ChunkSize, &m_Tick);
 		if(Result == CHUNKHEADER_EOF)
 		{
-			if(m_Info.m_PreviousTick == -1)
-			{
-				Stop("Empty demo");
-			}
-			else
-			{
-				Pause();
-				// Stop rendering when reaching end of file
-#if defined(CONF_VIDEORECORDER)
-				if(m_UseVideo && IVideo::Current())
-					Stop();
-#endif
-			}
+			pTick->m_End = CDecodedTick::END_EOF;
 			break;
 		}
 		else if(Result == CHUNKHEADER_ERROR)
 		{
-			Stop("Error reading chunk header");
+			pTick->m_End = CDecodedTick::END_ERROR;
+			pTick->m_pError = "Error reading chunk header";
 			break;
 		}
 
@@ -708,21 +921,24 @@ void CDemoPlayer::DoTick()
 		{
 			if(io_read(m_File, m_aCompressedSnapshotData, ChunkSize) != (unsigned)ChunkSize)
 			{
-				Stop("Error reading chunk data");
+				pTick->m_End = CDecodedTick::END_ERROR;
+				pTick->m_pError = "Error reading chunk data";
 				break;
 			}
 
 			DataSize = CNetBase::Decompress(m_aCompressedSnapshotData, ChunkSize, m_aDecompressedSnapshotData, sizeof(m_aDecompressedSnapshotData));
 			if(DataSize < 0)
 			{
-				Stop("Error during network decompression");
+				pTick->m_End = CDecodedTick::END_ERROR;
+				pTick->m_pError = "Error during network decompression";
 				break;
 			}
 
 			DataSize = CVariableInt::Decompress(m_aDecompressedSnapshotData, DataSize, m_aChunkData, sizeof(m_aChunkData));
 			if(DataSize < 0)
 			{
-				Stop("Error during intpack decompression");
+				pTick->m_End = CDecodedTick::END_ERROR;
+				pTick->m_pError = "Error during intpack decompression";
 				break;
 			}
 		}
@@ -733,7 +949,7 @@ void CDemoPlayer::DoTick()
 			// TODO: this needs alignment for `m_aChunkData` of 4,
 			// but this is not guaranteed. This is assumed above,
 			// too, anyway, in `CVariableInt::Decompress`.
-			DataSize = SnapshotDelta()->UnpackDelta(*m_LastSnapshotData.AsSnapshot(), m_Snapshot, rust::Slice<const int32_t>((const int *)m_aChunkData, DataSize / sizeof(int32_t)));
+			DataSize = m_pSnapshotDelta->UnpackDelta(*m_LastSnapshotData.AsSnapshot(), m_Snapshot, rust::Slice<const int32_t>((const int *)m_aChunkData, DataSize / sizeof(int32_t)));
 
 			if(DataSize < 0)
 			{
@@ -755,8 +971,7 @@ void CDemoPlayer::DoTick()
 			}
 			else
 			{
-				if(m_pListener)
-					m_pListener->OnDemoPlayerSnapshot(m_Snapshot.AsSnapshot(), DataSize);
+				pTick->AddChunk(CHUNKTYPE_SNAPSHOT, m_Snapshot.AsSnapshot(), DataSize);
 
 				m_LastSnapshotDataSize = DataSize;
 				mem_copy(&m_LastSnapshotData, &m_Snapshot, DataSize);
@@ -782,34 +997,216 @@ void CDemoPlayer::DoTick()
 
 				m_LastSnapshotDataSize = DataSize;
 				mem_copy(&m_LastSnapshotData, m_aChunkData, DataSize);
-				if(m_pListener)
-					m_pListener->OnDemoPlayerSnapshot(m_aChunkData, DataSize);
+				pTick->AddChunk(CHUNKTYPE_SNAPSHOT, m_aChunkData, DataSize);
 			}
 		}
 		else
 		{
 			// if there were no snapshots in this tick, replay the last one
-			if(!GotSnapshot && m_pListener && m_LastSnapshotDataSize != -1)
+			if(!GotSnapshot && m_LastSnapshotDataSize != -1)
 			{
 				GotSnapshot = true;
-				m_pListener->OnDemoPlayerSnapshot(&m_LastSnapshotData, m_LastSnapshotDataSize);
+				pTick->AddChunk(CHUNKTYPE_SNAPSHOT, &m_LastSnapshotData, m_LastSnapshotDataSize);
 			}
 
 			// check the remaining types
 			if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
 			{
-				m_Info.m_NextTick = ChunkTick;
+				pTick->m_End = CDecodedTick::END_TICK;
+				pTick->m_NextTick = m_Tick;
 				break;
 			}
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
 			{
-				if(m_pListener)
-					m_pListener->OnDemoPlayerMessage(m_aChunkData, DataSize);
+				pTick->AddChunk(CHUNKTYPE_MESSAGE, m_aChunkData, DataSize);
 			}
 		}
 	}
 }
 
+CDemoPlayer::CReadAhead::CReadAhead(CSnapshotDelta *pSnapshotDelta) :
+	m_pSnapshotDelta(pSnapshotDelta->Clone())
+{
+	m_Decoder.m_pSnapshotDelta = &*m_pSnapshotDelta;
+}
+
+void CDemoPlayer::CReadAhead::ThreadFunc(void *pUser)
+{
+	static_cast<CReadAhead *>(pUser)->Run();
+}
+
+void CDemoPlayer::CReadAhead::Run()
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	while(true)
+	{
+		m_Cond.wait(Lock, [this]() {
+			return m_Shutdown || m_Seek || (!m_AtEnd && m_WriteIndex - m_ReadIndex < NUM_TICKS);
+		});
+		if(m_Shutdown)
+			break;
+
+		const unsigned Generation = m_Generation;
+		const bool Seek = m_Seek;
+		const int64_t SeekFilepos = m_SeekFilepos;
+		m_Seek = false;
+		m_AtEnd = false;
+		CDecodedTick *pTick = &m_aTicks[m_WriteIndex % NUM_TICKS];
+
+		// the slot after the ready ticks is only touched by this thread
+		Lock.unlock();
+		if(Seek && io_seek(m_Decoder.m_File, SeekFilepos, IOSEEK_START) != 0)
+		{
+			pTick->Clear();
+			pTick->m_End = CDecodedTick::END_ERROR;
+			pTick->m_pError = "Error seeking keyframe position";
+		}
+		else
+		{
+			if(Seek)
+				m_Decoder.m_Tick = -1;
+			m_Decoder.DecodeTick(pTick);
+		}
+		Lock.lock();
+
+		if(Generation != m_Generation)
+			continue;
+		m_WriteIndex++;
+		m_AtEnd = pTick->m_End != CDecodedTick::END_TICK;
+		m_Cond.notify_all();
+	}
+}
+
+void CDemoPlayer::StartReadAhead(IStorage *pStorage, const char *pFilename, int StorageType, int64_t DataStart)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	if(!File)
+		return;
+
+	m_pReadAhead = std::make_unique<CReadAhead>(SnapshotDelta());
+	CDecoder &Decoder = m_pReadAhead->m_Decoder;
+	Decoder.m_pConsole = m_pConsole;
+	Decoder.m_File = File;
+	Decoder.m_Version = m_Info.m_Header.m_Version;
+	Decoder.m_Tick = -1;
+	Decoder.m_LastSnapshotDataSize = -1;
+	m_pReadAhead->m_Seek = true;
+	m_pReadAhead->m_SeekFilepos = DataStart;
+	m_pReadAhead->m_pThread = thread_init(CReadAhead::ThreadFunc, m_pReadAhead.get(), "demo read ahead");
+}
+
+void CDemoPlayer::StopReadAhead()
+{
+	if(!m_pReadAhead)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_pReadAhead->m_Mutex);
+		m_pReadAhead->m_Shutdown = true;
+	}
+	m_pReadAhead->m_Cond.notify_all();
+	thread_wait(m_pReadAhead->m_pThread);
+	io_close(m_pReadAhead->m_Decoder.m_File);
+	m_pReadAhead = nullptr;
+}
+
+bool CDemoPlayer::SeekChunks(int64_t Filepos)
+{
+	if(m_pReadAhead)
+	{
+		// drop the ticks decoded so far and restart decoding in the background
+		{
+			std::lock_guard<std::mutex> Lock(m_pReadAhead->m_Mutex);
+			m_pReadAhead->m_Generation++;
+			m_pReadAhead->m_ReadIndex = m_pReadAhead->m_WriteIndex;
+			m_pReadAhead->m_Seek = true;
+			m_pReadAhead->m_SeekFilepos = Filepos;
+			m_pReadAhead->m_AtEnd = false;
+		}
+		m_pReadAhead->m_Cond.notify_all();
+		return true;
+	}
+
+	if(io_seek(m_File, Filepos, IOSEEK_START) != 0)
+		return false;
+	m_Decoder.m_Tick = -1;
+	return true;
+}
+
+void CDemoPlayer::DoTick()
+{
+	// update ticks
+	m_Info.m_PreviousTick = m_Info.m_Info.m_CurrentTick;
+	m_Info.m_Info.m_CurrentTick = m_Info.m_NextTick;
+
+	UpdateTimes();
+
+	if(!m_pReadAhead)
+	{
+		m_Decoder.m_Tick = m_Info.m_Info.m_CurrentTick;
+		m_Decoder.DecodeTick(&m_DecodedTick);
+		PlayTick(&m_DecodedTick);
+		return;
+	}
+
+	CReadAhead *pReadAhead = m_pReadAhead.get();
+	{
+		std::unique_lock<std::mutex> Lock(pReadAhead->m_Mutex);
+		if(pReadAhead->m_ReadIndex == pReadAhead->m_WriteIndex && pReadAhead->m_AtEnd)
+		{
+			// try to read further, the file might have grown since
+			pReadAhead->m_AtEnd = false;
+			pReadAhead->m_Cond.notify_all();
+		}
+		pReadAhead->m_Cond.wait(Lock, [pReadAhead]() { return pReadAhead->m_ReadIndex != pReadAhead->m_WriteIndex; });
+		// take the tick out of the ring before playing it, the listener may
+		// seek or stop playback which hands the ring slots back to the thread
+		std::swap(m_DecodedTick, pReadAhead->m_aTicks[pReadAhead->m_ReadIndex % CReadAhead::NUM_TICKS]);
+		pReadAhead->m_ReadIndex++;
+	}
+	pReadAhead->m_Cond.notify_all();
+
+	PlayTick(&m_DecodedTick);
+}
+
+void CDemoPlayer::PlayTick(CDecodedTick *pTick)
+{
+	for(const CDecodedTick::CChunk &Chunk : pTick->m_vChunks)
+	{
+		if(!m_pListener)
+			break;
+		if(Chunk.m_Type == CHUNKTYPE_SNAPSHOT)
+			m_pListener->OnDemoPlayerSnapshot(pTick->ChunkData(Chunk), Chunk.m_Size);
+		else
+			m_pListener->OnDemoPlayerMessage(pTick->ChunkData(Chunk), Chunk.m_Size);
+	}
+
+	if(pTick->m_End == CDecodedTick::END_TICK)
+	{
+		m_Info.m_NextTick = pTick->m_NextTick;
+	}
+	else if(pTick->m_End == CDecodedTick::END_EOF)
+	{
+		if(m_Info.m_PreviousTick == -1)
+		{
+			Stop("Empty demo");
+		}
+		else
+		{
+			Pause();
+			// Stop rendering when reaching end of file
+#if defined(CONF_VIDEORECORDER)
+			if(m_UseVideo && IVideo::Current())
+				Stop();
+#endif
+		}
+	}
+	else
+	{
+		Stop(pTick->m_pError);
+	}
+}
+
 void CDemoPlayer::Pause()
 {
 	m_Info.m_Info.m_Paused = true;
@@ -852,7 +1249,6 @@ int CDemoPlayer::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilen
 	m_Info.m_PreviousTick = -1;
 	m_Info.m_Info.m_Speed = 1;
 	m_SpeedIndex = DEMO_SPEED_INDEX_DEFAULT;
-	m_LastSnapshotDataSize = -1;
 
 	if(!GetDemoInfo(pStorage, m_pConsole, pFilename, StorageType, &m_Info.m_Header, &m_Info.m_TimelineMarkers, &m_MapInfo, &m_File, m_aErrorMessage, sizeof(m_aErrorMessage)))
 	{
@@ -880,13 +1276,30 @@ int CDemoPlayer::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilen
 		}
 	}
 
-	// Scan the file for interesting points
-	if(ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
+	if(ReadKeyFrameIndex())
 	{
-		Stop("Error scanning demo file");
-		return -1;
+		// the index is only written when the recording is finished
+		m_Info.m_LiveStateUpdating = false;
+	}
+	else
+	{
+		// Scan the file for interesting points
+		if(ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
+		{
+			Stop("Error scanning demo file");
+			return -1;
+		}
+		m_Info.m_LiveStateUpdating = true;
 	}
-	m_Info.m_LiveStateUpdating = true;
+
+	m_Decoder.m_pConsole = m_pConsole;
+	m_Decoder.m_File = m_File;
+	m_Decoder.m_Version = m_Info.m_Header.m_Version;
+	m_Decoder.m_pSnapshotDelta = SnapshotDelta();
+	m_Decoder.m_Tick = -1;
+	m_Decoder.m_LastSnapshotDataSize = -1;
+	if(m_ReadAhead)
+		StartReadAhead(pStorage, pFilename, StorageType, m_MapOffset + m_MapInfo.m_Size);
 
 	// reset slice markers
 	g_Config.m_ClDemoSliceBegin = -1;
@@ -1090,7 +1503,7 @@ bool CDemoPlayer::SetPos(int WantedTick)
 		m_Info.m_Info.m_CurrentTick < m_vKeyFrames[KeyFrame].m_Tick || // we are before the wanted KeyFrame OR
 		(KeyFrame != m_vKeyFrames.size() - 1 && m_Info.m_Info.m_CurrentTick >= m_vKeyFrames[KeyFrame + 1].m_Tick)) // we are after the wanted KeyFrame
 	{
-		if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+		if(!SeekChunks(m_vKeyFrames[KeyFrame].m_Filepos))
 		{
 			Stop("Error seeking keyframe position");
 			return false;
@@ -1274,6 +1687,8 @@ void CDemoPlayer::Stop(const char *pErrorMessage)
 	if(!m_File)
 		return;
 
+	StopReadAhead();
+
 	if(m_pConsole)
 	{
 		char aBuf[256];
@@ -10,7 +10,10 @@
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
 
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
@@ -19,6 +22,18 @@ struct CSnapshotDelta;
 class IConsole;
 class IStorage;
 
+class CDemoKeyFrame
+{
+public:
+	int64_t m_Filepos;
+	int m_Tick;
+
+	CDemoKeyFrame(int64_t Filepos, int Tick) :
+		m_Filepos(Filepos), m_Tick(Tick)
+	{
+	}
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	IConsole *m_pConsole;
@@ -29,6 +44,8 @@ class CDemoRecorder : public IDemoRecorder
 	int m_LastTickMarker;
 	int m_LastKeyFrame;
 	int m_FirstTick;
+	int64_t m_DataStart;
+	std::vector<CDemoKeyFrame> m_vKeyFrames;
 
 	CSnapshotBuffer m_LastSnapshotData;
 	CSnapshotDelta *m_pSnapshotDelta;
@@ -43,6 +60,7 @@ class CDemoRecorder : public IDemoRecorder
 
 	void WriteTickMarker(int Tick, bool Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void WriteKeyFrameIndex();
 
 public:
 	CDemoRecorder(CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
@@ -97,6 +115,9 @@ public:
 		bool m_LiveStateUpdating;
 		int m_LiveStateFailedCount;
 		int m_LiveStateUnchangedCount;
+
+		// keyframes were read from the index instead of scanning the file
+		bool m_KeyFrameIndex;
 	};
 
 private:
@@ -105,39 +126,16 @@ private:
 	TUpdateIntraTimesFunc m_UpdateIntraTimesFunc;
 
 	// Playback
-	class CKeyFrame
-	{
-	public:
-		int64_t m_Filepos;
-		int m_Tick;
-
-		CKeyFrame(int64_t Filepos, int Tick) :
-			m_Filepos(Filepos), m_Tick(Tick)
-		{
-		}
-	};
-
 	IConsole *m_pConsole;
 	IOHANDLE m_File;
 	int64_t m_MapOffset;
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	char m_aErrorMessage[256];
-	std::vector<CKeyFrame> m_vKeyFrames;
+	std::vector<CDemoKeyFrame> m_vKeyFrames;
 	CMapInfo m_MapInfo;
 	int m_SpeedIndex;
 
 	CPlaybackInfo m_Info;
-	unsigned char m_aCompressedSnapshotData[CSnapshot::MAX_SIZE];
-	unsigned char m_aDecompressedSnapshotData[CSnapshot::MAX_SIZE];
-
-	// Depending on the chunk header
-	// this is either a full CSnapshot or a CSnapshotDelta.
-	unsigned char m_aChunkData[CSnapshot::MAX_SIZE];
-	// Storage for the full snapshot
-	// where the delta gets unpacked into.
-	CSnapshotBuffer m_Snapshot;
-	CSnapshotBuffer m_LastSnapshotData;
-	int m_LastSnapshotDataSize;
 	CSnapshotDelta *m_pSnapshotDelta;
 	CSnapshotDelta *m_pSnapshotDeltaSixup;
 
@@ -152,8 +150,103 @@ private:
 		CHUNKHEADER_ERROR,
 		CHUNKHEADER_EOF,
 	};
-	EReadChunkHeaderResult ReadChunkHeader(int *pType, int *pSize, int *pTick);
+	static EReadChunkHeaderResult ReadChunkHeader(IOHANDLE File, int Version, int *pType, int *pSize, int *pTick);
+
+	// The listener calls of one tick, up to the tickmarker of the next tick
+	class CDecodedTick
+	{
+	public:
+		enum EEnd
+		{
+			END_TICK,
+			END_EOF,
+			END_ERROR,
+		};
+
+		class CChunk
+		{
+		public:
+			int m_Type;
+			size_t m_Offset;
+			int m_Size;
+		};
+
+		std::vector<CChunk> m_vChunks;
+		std::vector<int32_t> m_vData;
+		EEnd m_End;
+		int m_NextTick;
+		const char *m_pError;
+
+		void Clear();
+		void AddChunk(int Type, const void *pData, int Size);
+		void *ChunkData(const CChunk &Chunk) { return m_vData.data() + Chunk.m_Offset; }
+	};
+
+	// Reads and unpacks the chunks of a demo file tick by tick
+	class CDecoder
+	{
+	public:
+		IConsole *m_pConsole;
+		IOHANDLE m_File;
+		int m_Version;
+		CSnapshotDelta *m_pSnapshotDelta;
+		int m_Tick;
+
+		unsigned char m_aCompressedSnapshotData[CSnapshot::MAX_SIZE];
+		unsigned char m_aDecompressedSnapshotData[CSnapshot::MAX_SIZE];
+
+		// Depending on the chunk header
+		// this is either a full CSnapshot or a CSnapshotDelta.
+		unsigned char m_aChunkData[CSnapshot::MAX_SIZE];
+		// Storage for the full snapshot
+		// where the delta gets unpacked into.
+		CSnapshotBuffer m_Snapshot;
+		CSnapshotBuffer m_LastSnapshotData;
+		int m_LastSnapshotDataSize;
+
+		void DecodeTick(CDecodedTick *pTick);
+	};
+
+	// Decodes the upcoming ticks on a separate thread, with its own file
+	// handle and snapshot delta
+	class CReadAhead
+	{
+	public:
+		static constexpr unsigned NUM_TICKS = 128;
+
+		CDecoder m_Decoder;
+		rust::Box<CSnapshotDelta> m_pSnapshotDelta;
+		CDecodedTick m_aTicks[NUM_TICKS];
+		void *m_pThread = nullptr;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Cond;
+		// ticks in [m_ReadIndex, m_WriteIndex) are ready
+		unsigned m_ReadIndex = 0;
+		unsigned m_WriteIndex = 0;
+		// incremented on every seek, ticks of older generations are dropped
+		unsigned m_Generation = 0;
+		bool m_Seek = false;
+		int64_t m_SeekFilepos = 0;
+		// the last decoded tick ended the file, wait for the player to retry
+		bool m_AtEnd = false;
+		bool m_Shutdown = false;
+
+		explicit CReadAhead(CSnapshotDelta *pSnapshotDelta);
+		static void ThreadFunc(void *pUser);
+		void Run();
+	};
+
+	CDecoder m_Decoder;
+	CDecodedTick m_DecodedTick;
+	bool m_ReadAhead;
+	std::unique_ptr<CReadAhead> m_pReadAhead;
+
+	void StartReadAhead(IStorage *pStorage, const char *pFilename, int StorageType, int64_t DataStart);
+	void StopReadAhead();
+	bool SeekChunks(int64_t Filepos);
 	void DoTick();
+	void PlayTick(CDecodedTick *pTick);
 	enum class EScanFileResult
 	{
 		SUCCESS,
@@ -161,6 +254,7 @@ private:
 		ERROR_UNRECOVERABLE,
 	};
 	EScanFileResult ScanFile();
+	bool ReadKeyFrameIndex();
 	void UpdateTimes();
 
 	int64_t Time();
@@ -175,6 +269,8 @@ public:
 	~CDemoPlayer() override;
 
 	void SetListener(IListener *pListener);
+	// decode upcoming ticks on a separate thread, must be set before `Load`
+	void SetReadAhead(bool ReadAhead);
 
 	int Load(IStorage *pStorage, IConsole *pConsole, const char *pFilename, int StorageType);
 	unsigned char *GetMapData(IStorage *pStorage);
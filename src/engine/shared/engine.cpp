@@ -108,6 +108,11 @@ public:
 		m_JobPool.Add(std::move(pJob));
 	}
 
+	CJobPool *JobPool() override
+	{
+		return &m_JobPool;
+	}
+
 	void ShutdownJobs() override
 	{
 		m_JobPool.Shutdown();
@@ -127,6 +127,42 @@ void CHuffman::Init(const unsigned *pFrequencies)
 		if(k == HUFFMAN_LUTBITS)
 			m_apDecodeLut[i] = pNode;
 	}
+
+	BuildMultiDecodeLut();
+}
+
+void CHuffman::BuildMultiDecodeLut()
+{
+	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
+	for(unsigned i = 0; i < HUFFMAN_MULTI_LUTSIZE; i++)
+	{
+		CMultiEntry &Entry = m_aMultiDecodeLut[i];
+		mem_zero(&Entry, sizeof(Entry));
+
+		unsigned Used = 0;
+		while(Entry.m_NumSymbols < HUFFMAN_MULTI_MAX_SYMBOLS)
+		{
+			// walk the tree until a symbol or the end of the lookup bits
+			const CNode *pNode = m_pStartNode;
+			unsigned Depth = 0;
+			while(!pNode->m_NumBits && Used + Depth < HUFFMAN_MULTI_LUTBITS)
+			{
+				pNode = &m_aNodes[pNode->m_aLeaves[(i >> (Used + Depth)) & 1]];
+				Depth++;
+			}
+			if(!pNode->m_NumBits)
+				break;
+
+			Used += Depth;
+			if(pNode == pEof)
+			{
+				Entry.m_Eof = true;
+				break;
+			}
+			Entry.m_aSymbols[Entry.m_NumSymbols++] = pNode->m_Symbol;
+		}
+		Entry.m_NumBits = Used;
+	}
 }
 
 //***************************************************************
@@ -218,6 +254,42 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 
 	while(true)
 	{
+		// decode as many symbols as the multi symbol table knows at once. only
+		// done with enough input bits left, the end of the input is handled
+		// bit-exact by the single symbol path below
+		if(Bitcount < HUFFMAN_MULTI_LUTBITS)
+		{
+			while(Bitcount < 24 && pSrc != pSrcEnd)
+			{
+				Bits |= (*pSrc++) << Bitcount;
+				Bitcount += 8;
+			}
+		}
+		if(Bitcount >= HUFFMAN_MULTI_LUTBITS)
+		{
+			const CMultiEntry &Entry = m_aMultiDecodeLut[Bits & HUFFMAN_MULTI_LUTMASK];
+			if(Entry.m_NumBits)
+			{
+				if(pDstEnd - pDst < Entry.m_NumSymbols)
+					return -1;
+				if(pDstEnd - pDst >= HUFFMAN_MULTI_MAX_SYMBOLS)
+				{
+					// copying the whole entry is faster than a variable size copy
+					mem_copy(pDst, Entry.m_aSymbols, HUFFMAN_MULTI_MAX_SYMBOLS);
+				}
+				else
+				{
+					mem_copy(pDst, Entry.m_aSymbols, Entry.m_NumSymbols);
+				}
+				pDst += Entry.m_NumSymbols;
+				Bits >>= Entry.m_NumBits;
+				Bitcount -= Entry.m_NumBits;
+				if(Entry.m_Eof)
+					break;
+				continue;
+			}
+		}
+
 		// {A} try to load a node now, this will reduce dependency at location {D}
 		const CNode *pNode = nullptr;
 		if(Bitcount >= HUFFMAN_LUTBITS)
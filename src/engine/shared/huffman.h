@@ -14,7 +14,12 @@ class CHuffman
 
 		HUFFMAN_LUTBITS = 10,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+
+		HUFFMAN_MULTI_LUTBITS = 12,
+		HUFFMAN_MULTI_LUTSIZE = (1 << HUFFMAN_MULTI_LUTBITS),
+		HUFFMAN_MULTI_LUTMASK = (HUFFMAN_MULTI_LUTSIZE - 1),
+		HUFFMAN_MULTI_MAX_SYMBOLS = 5,
 	};
 
 	struct CNode
@@ -30,15 +35,30 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	// all symbols whose codes fit completely into the lookup bits, so
+	// that runs of short codes (like the zeros in snapshot deltas) are
+	// decoded with a single lookup
+	struct CMultiEntry
+	{
+		unsigned char m_aSymbols[HUFFMAN_MULTI_MAX_SYMBOLS];
+		unsigned char m_NumSymbols;
+		// including the EOF symbol
+		unsigned char m_NumBits;
+		// whether the symbols are followed by the EOF symbol
+		bool m_Eof;
+	};
+
 	static const unsigned ms_aFreqTable[HUFFMAN_MAX_SYMBOLS];
 
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
 	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CMultiEntry m_aMultiDecodeLut[HUFFMAN_MULTI_LUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
 
 	void Setbits_r(CNode *pNode, int Bits, unsigned Depth);
 	void ConstructTree(const unsigned *pFrequencies);
+	void BuildMultiDecodeLut();
 
 public:
 	/*
@@ -49,6 +49,7 @@ bool IJob::IsAbortable() const
 
 CJobPool::CJobPool()
 {
+	m_NumThreads = 0;
 	m_Shutdown = true;
 }
 
@@ -148,6 +149,7 @@ void CJobPool::Init(int NumThreads)
 		str_format(aName, sizeof(aName), "CJobPool W%d", i);
 		m_vpThreads.push_back(thread_init(WorkerThread, this, aName));
 	}
+	m_NumThreads = NumThreads;
 }
 
 void CJobPool::Shutdown()
@@ -207,6 +209,7 @@ void CJobPool::Shutdown()
 	}
 
 	m_vpThreads.clear();
+	m_NumThreads = 0;
 	sphore_destroy(&m_Semaphore);
 }
 
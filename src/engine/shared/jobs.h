@@ -127,6 +127,8 @@ public:
 class CJobPool
 {
 	std::vector<void *> m_vpThreads;
+	// size of `m_vpThreads`, which may be read from any thread
+	std::atomic<int> m_NumThreads;
 	std::atomic<bool> m_Shutdown;
 
 	CLock m_Lock;
@@ -161,6 +163,13 @@ public:
 	 */
 	void Shutdown() REQUIRES(!m_Lock) REQUIRES(!m_LockRunning);
 
+	/**
+	 * Returns the number of worker threads.
+	 *
+	 * @return Number of worker threads, `0` if the job pool is not running.
+	 */
+	int NumThreads() const { return m_NumThreads; }
+
 	/**
 	 * Adds a job to the queue of the job pool.
 	 *
@@ -10,10 +10,12 @@
 #include <base/types.h>
 
 #include <array>
+#include <chrono>
 #include <optional>
 
 class CHuffman;
 class CNetBan;
+class CNetRecvThread;
 class CPacker;
 
 /*
@@ -449,6 +451,7 @@ class CNetServer
 
 	CPacketChunkUnpacker m_PacketChunkUnpacker;
 	CNetPacketConstruct m_RecvBuffer;
+	CNetRecvThread *m_pRecvThread = nullptr;
 
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
@@ -464,6 +467,8 @@ class CNetServer
 	void SendMsgs(NETADDR &Addr, const CPacker **ppMsgs, int Num);
 
 public:
+	~CNetServer();
+
 	int SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
 	int SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_NEWCLIENT_NOAUTH pfnNewClientNoAuth, NETFUNC_CLIENTREJOIN pfnClientRejoin, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
 
@@ -476,6 +481,14 @@ public:
 	int Send(CNetChunk *pChunk);
 	void Update();
 
+	// outgoing packets are queued while batching is enabled, until FlushSends is called
+	void SetSendBatching(bool Enabled);
+	void FlushSends();
+	// receive and unpack packets on a background thread
+	void SetRecvThread(bool Enabled);
+	// waits for incoming packets, returns whether there are any
+	bool Wait(std::chrono::nanoseconds Timeout);
+
 	//
 	void Drop(int ClientId, const char *pReason);
 
@@ -632,6 +645,7 @@ class CNetBase
 public:
 	static void OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv);
 	static void CloseLog();
+	static bool IsLoggingReceived() { return ms_DataLogRecv != nullptr; }
 	static void Init();
 	static int Compress(const void *pData, int DataSize, void *pOutput, int OutputSize);
 	static int Decompress(const void *pData, int DataSize, void *pOutput, int OutputSize);
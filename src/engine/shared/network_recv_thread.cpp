@@ -0,0 +1,122 @@
+#include "network_recv_thread.h"
+
+#include <base/dbg.h>
+#include <base/mem.h>
+#include <base/thread.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+CNetRecvThread::~CNetRecvThread()
+{
+	Stop();
+}
+
+void CNetRecvThread::Start(NETSOCKET Socket)
+{
+	dbg_assert(!Running(), "network receive thread already running");
+	if(!m_pPackets)
+		m_pPackets = std::make_unique<CPacket[]>(CAPACITY);
+	m_Socket = Socket;
+	m_Shutdown.store(false);
+	m_pThread = thread_init(ThreadFunc, this, "net recv");
+}
+
+void CNetRecvThread::Stop()
+{
+	// packets that are already queued stay available
+	if(!Running())
+		return;
+	m_Shutdown.store(true);
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+}
+
+const CNetRecvThread::CPacket *CNetRecvThread::Receive()
+{
+	const unsigned Read = m_ReadIndex.load(std::memory_order_relaxed);
+	if(Read == m_WriteIndex.load(std::memory_order_acquire))
+		return nullptr;
+
+	// the slot is reused by the receive thread once the read index moves on
+	m_Received = m_pPackets[Read % CAPACITY];
+	m_ReadIndex.store(Read + 1, std::memory_order_release);
+	return &m_Received;
+}
+
+bool CNetRecvThread::Empty() const
+{
+	return m_ReadIndex.load(std::memory_order_relaxed) == m_WriteIndex.load(std::memory_order_acquire);
+}
+
+bool CNetRecvThread::Wait(std::chrono::nanoseconds Timeout)
+{
+	std::unique_lock<std::mutex> Lock(m_WaitMutex);
+	return m_WaitCond.wait_for(Lock, Timeout, [this]() { return !Empty(); });
+}
+
+void CNetRecvThread::Notify()
+{
+	// taking the lock orders the new write index before a waiting consumer checks it
+	{
+		std::lock_guard<std::mutex> Lock(m_WaitMutex);
+	}
+	m_WaitCond.notify_one();
+}
+
+void CNetRecvThread::ThreadFunc(void *pUser)
+{
+	static_cast<CNetRecvThread *>(pUser)->Run();
+}
+
+void CNetRecvThread::Run()
+{
+	while(!m_Shutdown.load())
+	{
+		// wake up regularly to notice the shutdown
+		if(!net_socket_read_wait(m_Socket, 100ms))
+			continue;
+
+		bool Received = false;
+		while(!m_Shutdown.load())
+		{
+			const unsigned Write = m_WriteIndex.load(std::memory_order_relaxed);
+			if(Write - m_ReadIndex.load(std::memory_order_acquire) == CAPACITY)
+			{
+				// the game thread is behind, leave the packets in the socket buffer
+				if(Received)
+					Notify();
+				Received = false;
+				std::this_thread::sleep_for(1ms);
+				continue;
+			}
+
+			CPacket &Packet = m_pPackets[Write % CAPACITY];
+			unsigned char *pData;
+			const int Bytes = net_udp_recv(m_Socket, &Packet.m_Addr, &pData);
+			if(Bytes <= 0)
+				break;
+
+			// oversized packets are rejected by the consumer based on the size
+			Packet.m_Size = Bytes;
+			mem_copy(Packet.m_aData, pData, std::min(Bytes, (int)sizeof(Packet.m_aData)));
+
+			// the data log is not thread-safe, leave the unpacking to the consumer then
+			Packet.m_Decoded = !CNetBase::IsLoggingReceived();
+			if(Packet.m_Decoded)
+			{
+				Packet.m_Sixup = false;
+				Packet.m_Token = NET_SECURITY_TOKEN_UNKNOWN;
+				Packet.m_ResponseToken = NET_SECURITY_TOKEN_UNKNOWN;
+				Packet.m_Result = CNetBase::UnpackPacket(Packet.m_aData, Packet.m_Size, &Packet.m_Packet, Packet.m_Sixup, &Packet.m_Token, &Packet.m_ResponseToken);
+			}
+
+			m_WriteIndex.store(Write + 1, std::memory_order_release);
+			Received = true;
+		}
+		if(Received)
+			Notify();
+	}
+}
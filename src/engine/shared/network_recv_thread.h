@@ -0,0 +1,90 @@
+#ifndef ENGINE_SHARED_NETWORK_RECV_THREAD_H
+#define ENGINE_SHARED_NETWORK_RECV_THREAD_H
+
+#include "network.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+/**
+ * Receives the packets of a UDP socket on a background thread and hands
+ * them to the game thread through a single-producer single-consumer ring.
+ *
+ * The packets are already unpacked (header, tokens and Huffman
+ * decompression) as if they came from a connection without sixup. The
+ * consumer only has to unpack them again if the sender turns out to be a
+ * connected sixup client, everything that depends on the connection state
+ * (bans, acks, chunk sequences) stays on the game thread.
+ */
+class CNetRecvThread
+{
+public:
+	class CPacket
+	{
+	public:
+		NETADDR m_Addr;
+		int m_Size;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+
+		// result of CNetBase::UnpackPacket with Sixup initially false,
+		// not filled if m_Decoded is false
+		bool m_Decoded;
+		int m_Result;
+		bool m_Sixup;
+		SECURITY_TOKEN m_Token;
+		// NET_SECURITY_TOKEN_UNKNOWN if the packet didn't contain one
+		SECURITY_TOKEN m_ResponseToken;
+		CNetPacketConstruct m_Packet;
+	};
+
+	enum
+	{
+		CAPACITY = 1024,
+	};
+
+	~CNetRecvThread();
+
+	void Start(NETSOCKET Socket);
+	void Stop();
+	bool Running() const { return m_pThread != nullptr; }
+
+	/**
+	 * Takes the oldest received packet out of the queue.
+	 *
+	 * @return `nullptr` if there is none, otherwise the packet that stays
+	 * valid until the next call.
+	 */
+	const CPacket *Receive();
+	bool Empty() const;
+
+	/**
+	 * Waits until a packet is available.
+	 *
+	 * @return `false` if the timeout passed without any packet.
+	 */
+	bool Wait(std::chrono::nanoseconds Timeout);
+
+private:
+	NETSOCKET m_Socket = nullptr;
+	void *m_pThread = nullptr;
+	std::atomic<bool> m_Shutdown{false};
+
+	std::unique_ptr<CPacket[]> m_pPackets;
+	// only ever increase, the difference is the number of queued packets
+	std::atomic<unsigned> m_ReadIndex{0};
+	std::atomic<unsigned> m_WriteIndex{0};
+	// copy of the last received packet, owned by the consumer
+	CPacket m_Received;
+
+	std::mutex m_WaitMutex;
+	std::condition_variable m_WaitCond;
+
+	void Notify();
+	void Run();
+	static void ThreadFunc(void *pUser);
+};
+
+#endif
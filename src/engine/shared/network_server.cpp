@@ -3,6 +3,7 @@
 #include "config.h"
 #include "netban.h"
 #include "network.h"
+#include "network_recv_thread.h"
 
 #include <base/dbg.h>
 #include <base/hash_ctxt.h>
@@ -87,16 +88,58 @@ int CNetServer::SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_NEWCLIENT_N
 	return 0;
 }
 
+CNetServer::~CNetServer()
+{
+	delete m_pRecvThread;
+}
+
 void CNetServer::Close()
 {
 	if(!m_Socket)
 	{
 		return;
 	}
+	delete m_pRecvThread;
+	m_pRecvThread = nullptr;
 	net_udp_close(m_Socket);
 	m_Socket = nullptr;
 }
 
+void CNetServer::SetSendBatching(bool Enabled)
+{
+	net_udp_set_batching(m_Socket, Enabled);
+}
+
+void CNetServer::FlushSends()
+{
+	net_udp_flush(m_Socket);
+}
+
+void CNetServer::SetRecvThread(bool Enabled)
+{
+	if(Enabled)
+	{
+		if(!m_pRecvThread)
+			m_pRecvThread = new CNetRecvThread();
+		if(!m_pRecvThread->Running())
+			m_pRecvThread->Start(m_Socket);
+	}
+	else if(m_pRecvThread)
+	{
+		// the queued packets are still handed out by Recv
+		m_pRecvThread->Stop();
+	}
+}
+
+bool CNetServer::Wait(std::chrono::nanoseconds Timeout)
+{
+	if(m_pRecvThread && !m_pRecvThread->Empty())
+		return true;
+	if(m_pRecvThread && m_pRecvThread->Running())
+		return m_pRecvThread->Wait(Timeout);
+	return net_socket_read_wait(m_Socket, Timeout);
+}
+
 void CNetServer::Drop(int ClientId, const char *pReason)
 {
 	// TODO: insert lots of checks here
@@ -597,7 +640,21 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		// TODO: empty the recvinfo
 		NETADDR Addr;
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		int Bytes;
+		const CNetRecvThread::CPacket *pReceived = nullptr;
+		if(m_pRecvThread && (m_pRecvThread->Running() || !m_pRecvThread->Empty()))
+		{
+			pReceived = m_pRecvThread->Receive();
+			if(!pReceived)
+				break;
+			Addr = pReceived->m_Addr;
+			Bytes = pReceived->m_Size;
+			pData = const_cast<unsigned char *>(pReceived->m_aData);
+		}
+		else
+		{
+			Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		}
 
 		// no more packets for now
 		if(Bytes <= 0)
@@ -623,7 +680,22 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		SECURITY_TOKEN Token;
 		int Slot = (*Flags & NET_PACKETFLAG_CONNLESS) == 0 ? GetClientSlot(Addr) : -1;
 		bool Sixup = Slot != -1 && m_aSlots[Slot].m_Connection.m_Sixup;
-		if(CNetBase::UnpackPacket(pData, Bytes, &m_RecvBuffer, Sixup, &Token, pResponseToken) == 0)
+		int Result;
+		if(pReceived && pReceived->m_Decoded && !Sixup)
+		{
+			// already unpacked by the receive thread
+			Result = pReceived->m_Result;
+			Sixup = pReceived->m_Sixup;
+			Token = pReceived->m_Token;
+			if(pReceived->m_ResponseToken != NET_SECURITY_TOKEN_UNKNOWN)
+				*pResponseToken = pReceived->m_ResponseToken;
+			m_RecvBuffer = pReceived->m_Packet;
+		}
+		else
+		{
+			Result = CNetBase::UnpackPacket(pData, Bytes, &m_RecvBuffer, Sixup, &Token, pResponseToken);
+		}
+		if(Result == 0)
 		{
 			if(m_RecvBuffer.m_Flags & NET_PACKETFLAG_CONNLESS)
 			{
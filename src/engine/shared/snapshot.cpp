@@ -177,23 +177,52 @@ std::unique_ptr<CSnapshotBuffer> CSnapshotBuffer_New()
 
 // CSnapshotStorage
 
+CSnapshotStorage::CSnapshotStorage()
+{
+	m_pFree = nullptr;
+	Init();
+}
+
+CSnapshotStorage::~CSnapshotStorage()
+{
+	PurgeAll();
+}
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	for(auto &pHolder : m_apTickIndex)
+		pHolder = nullptr;
 }
 
-void CSnapshotStorage::PurgeAll()
+void CSnapshotStorage::FreeHolders(CHolder *pHolder)
 {
-	while(m_pFirst)
+	while(pHolder)
 	{
-		CHolder *pNext = m_pFirst->m_pNext;
-		free(m_pFirst->m_pSnap);
-		free(m_pFirst->m_pAltSnap);
-		free(m_pFirst);
-		m_pFirst = pNext;
+		CHolder *pNext = pHolder->m_pNext;
+		free(pHolder->m_pData);
+		free(pHolder);
+		pHolder = pNext;
 	}
-	m_pLast = nullptr;
+}
+
+void CSnapshotStorage::PurgeAll()
+{
+	FreeHolders(m_pFirst);
+	FreeHolders(m_pFree);
+	m_pFree = nullptr;
+	Init();
+}
+
+void CSnapshotStorage::Recycle(CHolder *pHolder)
+{
+	CHolder *&pIndexed = m_apTickIndex[TickIndex(pHolder->m_Tick)];
+	if(pIndexed == pHolder)
+		pIndexed = nullptr;
+	pHolder->m_pPrev = nullptr;
+	pHolder->m_pNext = m_pFree;
+	m_pFree = pHolder;
 }
 
 void CSnapshotStorage::PurgeUntil(int Tick)
@@ -205,9 +234,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 		CHolder *pNext = pHolder->m_pNext;
 		if(pHolder->m_Tick >= Tick)
 			return; // no more to remove
-		free(pHolder->m_pSnap);
-		free(pHolder->m_pAltSnap);
-		free(pHolder);
+		Recycle(pHolder);
 
 		// did we come to the end of the list?
 		if(!pNext)
@@ -228,17 +255,37 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	dbg_assert(DataSize <= (size_t)CSnapshot::MAX_SIZE, "Snapshot data size invalid");
 	dbg_assert(AltDataSize <= (size_t)CSnapshot::MAX_SIZE, "Alt snapshot data size invalid");
 
-	CHolder *pHolder = static_cast<CHolder *>(malloc(sizeof(CHolder)));
+	CHolder *pHolder = m_pFree;
+	if(pHolder)
+	{
+		m_pFree = pHolder->m_pNext;
+	}
+	else
+	{
+		pHolder = static_cast<CHolder *>(malloc(sizeof(CHolder)));
+		pHolder->m_pData = nullptr;
+		pHolder->m_DataCapacity = 0;
+	}
 	pHolder->m_Tick = Tick;
 	pHolder->m_Tagtime = Tagtime;
 
-	pHolder->m_pSnap = static_cast<CSnapshot *>(malloc(DataSize));
+	// keep the alternative snapshot int aligned behind the snapshot
+	const size_t AltOffset = (DataSize + sizeof(int32_t) - 1) / sizeof(int32_t) * sizeof(int32_t);
+	const size_t Needed = AltOffset + AltDataSize;
+	if(pHolder->m_DataCapacity < Needed)
+	{
+		free(pHolder->m_pData);
+		pHolder->m_pData = malloc(Needed);
+		pHolder->m_DataCapacity = Needed;
+	}
+
+	pHolder->m_pSnap = static_cast<CSnapshot *>(pHolder->m_pData);
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
 	pHolder->m_SnapSize = DataSize;
 
 	if(AltDataSize) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = static_cast<CSnapshot *>(malloc(AltDataSize));
+		pHolder->m_pAltSnap = reinterpret_cast<CSnapshot *>(static_cast<char *>(pHolder->m_pData) + AltOffset);
 		mem_copy(pHolder->m_pAltSnap, pAltData, AltDataSize);
 		pHolder->m_AltSnapSize = AltDataSize;
 	}
@@ -256,27 +303,30 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	else
 		m_pFirst = pHolder;
 	m_pLast = pHolder;
+
+	m_apTickIndex[TickIndex(Tick)] = pHolder;
 }
 
 int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const
 {
-	CHolder *pHolder = m_pFirst;
-
-	while(pHolder)
+	CHolder *pHolder = m_apTickIndex[TickIndex(Tick)];
+	if((!pHolder || pHolder->m_Tick != Tick) && m_pFirst && m_pLast->m_Tick - m_pFirst->m_Tick >= TICK_INDEX_SIZE)
 	{
-		if(pHolder->m_Tick == Tick)
-		{
-			if(pTagtime)
-				*pTagtime = pHolder->m_Tagtime;
-			if(ppData)
-				*ppData = pHolder->m_pSnap;
-			if(ppAltData)
-				*ppAltData = pHolder->m_pAltSnap;
-			return pHolder->m_SnapSize;
-		}
-
-		pHolder = pHolder->m_pNext;
+		// the index slot might have been taken by a newer tick, only
+		// possible if the storage spans more than TICK_INDEX_SIZE ticks
+		pHolder = m_pFirst;
+		while(pHolder && pHolder->m_Tick != Tick)
+			pHolder = pHolder->m_pNext;
 	}
 
-	return -1;
+	if(!pHolder || pHolder->m_Tick != Tick)
+		return -1;
+
+	if(pTagtime)
+		*pTagtime = pHolder->m_Tagtime;
+	if(ppData)
+		*ppData = pHolder->m_pSnap;
+	if(ppAltData)
+		*ppAltData = pHolder->m_pAltSnap;
+	return pHolder->m_SnapSize;
 }
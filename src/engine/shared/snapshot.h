@@ -102,18 +102,37 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		// backing memory of m_pSnap and m_pAltSnap, kept when the holder is recycled
+		void *m_pData;
+		size_t m_DataCapacity;
+	};
+
+	enum
+	{
+		TICK_INDEX_SIZE = 256,
 	};
 
 	CHolder *m_pFirst;
 	CHolder *m_pLast;
 
-	CSnapshotStorage() { Init(); }
-	~CSnapshotStorage() { PurgeAll(); }
+	CSnapshotStorage();
+	~CSnapshotStorage();
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData);
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
+
+private:
+	// purged holders, reused by `Add` so the tick loop doesn't allocate
+	CHolder *m_pFree;
+	// holders by tick modulo TICK_INDEX_SIZE, for constant time lookups
+	CHolder *m_apTickIndex[TICK_INDEX_SIZE];
+
+	static int TickIndex(int Tick) { return (unsigned)Tick % TICK_INDEX_SIZE; }
+	void Recycle(CHolder *pHolder);
+	void FreeHolders(CHolder *pHolder);
 };
 
 #include <engine/shared/snapshot/builder.h> // NOLINT(misc-header-include-cycle)
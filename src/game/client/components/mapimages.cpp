@@ -3,7 +3,10 @@
 #include "mapimages.h"
 
 #include <base/log.h>
+#include <base/thread.h>
 
+#include <engine/engine.h>
+#include <engine/gfx/image_manipulation.h>
 #include <engine/graphics.h>
 #include <engine/map.h>
 #include <engine/storage.h>
@@ -16,9 +19,39 @@
 #include <game/localization.h>
 #include <game/mapitems.h>
 
+CMapImages::CMapImageLoadJob::CMapImageLoadJob(IGraphics *pGraphics, const char *pPath, int Flags) :
+	m_pGraphics(pGraphics),
+	m_Flags(Flags)
+{
+	str_copy(m_aPath, pPath);
+	Abortable(true);
+}
+
+CMapImages::CMapImageLoadJob::~CMapImageLoadJob()
+{
+	m_Image.Free();
+}
+
+void CMapImages::CMapImageLoadJob::Run()
+{
+	if(!m_pGraphics->LoadPng(m_Image, m_aPath, IStorage::TYPE_ALL))
+	{
+		return;
+	}
+	if(State() == IJob::STATE_ABORTED)
+	{
+		return;
+	}
+	// convert here so the texture data can be moved to the graphics thread
+	ConvertToRgba(m_Image);
+	m_Success = true;
+}
+
 CMapImages::CMapImages()
 {
 	m_Count = 0;
+	m_NumLoading = 0;
+	m_ShowLoadWarning = false;
 	std::fill(std::begin(m_aEntitiesIsLoaded), std::end(m_aEntitiesIsLoaded), false);
 	m_SpeedupArrowIsLoaded = false;
 
@@ -42,13 +75,68 @@ void CMapImages::OnInit()
 	Console()->Chain("cl_text_entities_size", ConchainClTextEntitiesSize, this);
 }
 
+void CMapImages::OnUpdate()
+{
+	UpdateLoading(false);
+}
+
 void CMapImages::Unload()
 {
 	// unload all textures
 	for(int i = 0; i < m_Count; i++)
 	{
+		if(m_apLoadJobs[i])
+		{
+			m_apLoadJobs[i]->Abort();
+			m_apLoadJobs[i] = nullptr;
+			m_aTextures[i].Invalidate();
+			continue;
+		}
 		Graphics()->UnloadTexture(&m_aTextures[i]);
 	}
+	m_NumLoading = 0;
+	m_ShowLoadWarning = false;
+}
+
+void CMapImages::UpdateLoading(bool Wait)
+{
+	for(int i = 0; i < m_Count && m_NumLoading > 0; i++)
+	{
+		const std::shared_ptr<CMapImageLoadJob> pJob = m_apLoadJobs[i];
+		if(!pJob)
+		{
+			continue;
+		}
+		while(Wait && !pJob->Done())
+		{
+			thread_yield();
+		}
+		if(!pJob->Done())
+		{
+			continue;
+		}
+
+		IGraphics::CTextureHandle Texture;
+		if(pJob->State() == IJob::STATE_DONE && pJob->m_Success)
+		{
+			Texture = Graphics()->LoadTextureRawMove(pJob->m_Image, pJob->Flags(), pJob->Path());
+		}
+		m_aTextures[i] = Texture.IsValid() ? Texture : Graphics()->NullTexture();
+		m_ShowLoadWarning = m_ShowLoadWarning || m_aTextures[i].IsNullTexture();
+		m_apLoadJobs[i] = nullptr;
+		m_NumLoading--;
+	}
+	UpdateLoadWarning();
+}
+
+void CMapImages::UpdateLoadWarning()
+{
+	// only warn once all images of the map have been loaded
+	if(m_NumLoading == 0 && m_ShowLoadWarning)
+	{
+		Client()->AddWarning(SWarning(Localize("Some map images could not be loaded. Check the local console for details.")));
+		m_ShowLoadWarning = false;
+	}
 }
 
 void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
@@ -95,7 +183,18 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 		}
 	}
 
-	// load new textures
+	if(!m_PlaceholderTexture.IsValid())
+	{
+		// transparent, so layers are not drawn until their image finished loading
+		CImageInfo Placeholder;
+		Placeholder.m_Width = 16;
+		Placeholder.m_Height = 16;
+		Placeholder.m_Format = CImageInfo::FORMAT_RGBA;
+		Placeholder.m_pData = static_cast<uint8_t *>(calloc(Placeholder.DataSize(), 1));
+		m_PlaceholderTexture = Graphics()->LoadTextureRawMove(Placeholder, Graphics()->TextureLoadFlags(), "map image placeholder");
+	}
+
+	// load new textures, external images are decoded by jobs and uploaded in OnUpdate
 	bool ShowWarning = false;
 	for(int i = 0; i < m_Count; i++)
 	{
@@ -142,7 +241,10 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 					!str_comp(pName, "easter");
 			}
 			str_format(aPath, sizeof(aPath), "mapres/%s%s.png", pName, Translated ? "_0.7" : "");
-			m_aTextures[i] = Graphics()->LoadTexture(aPath, IStorage::TYPE_ALL, LoadFlag);
+			m_apLoadJobs[i] = std::make_shared<CMapImageLoadJob>(Graphics(), aPath, LoadFlag);
+			Engine()->AddJob(m_apLoadJobs[i]);
+			m_aTextures[i] = m_PlaceholderTexture;
+			m_NumLoading++;
 		}
 		else
 		{
@@ -169,10 +271,8 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 		pMap->UnloadData(pImg->m_ImageName);
 		ShowWarning = ShowWarning || m_aTextures[i].IsNullTexture();
 	}
-	if(ShowWarning)
-	{
-		Client()->AddWarning(SWarning(Localize("Some map images could not be loaded. Check the local console for details.")));
-	}
+	m_ShowLoadWarning = ShowWarning;
+	UpdateLoadWarning();
 }
 
 void CMapImages::OnMapLoad()
@@ -182,7 +282,9 @@ void CMapImages::OnMapLoad()
 
 void CMapImages::LoadBackground(class CLayers *pLayers, class IMap *pMap)
 {
+	// background map images are not updated as a component, but still decoded in parallel
 	OnMapLoadImpl(pLayers, pMap);
+	UpdateLoading(true);
 }
 
 static EMapImageModType GetEntitiesModType(const CGameInfo &GameInfo)
@@ -5,11 +5,15 @@
 
 #include <engine/console.h>
 #include <engine/graphics.h>
+#include <engine/image.h>
+#include <engine/shared/jobs.h>
 
 #include <game/client/component.h>
 #include <game/map/render_interfaces.h>
 #include <game/mapitems.h>
 
+#include <memory>
+
 enum EMapImageModType
 {
 	MAP_IMAGE_MOD_TYPE_DDNET = 0,
@@ -38,9 +42,41 @@ class CMapImages : public CComponent, public IMapImages
 	friend class CBackground;
 	friend class CMenuBackground;
 
+	/**
+	 * Loads the PNG of an external map image and converts it to RGBA in a worker thread.
+	 */
+	class CMapImageLoadJob : public IJob
+	{
+	public:
+		CMapImageLoadJob(IGraphics *pGraphics, const char *pPath, int Flags);
+		~CMapImageLoadJob() override;
+
+		CImageInfo m_Image;
+		bool m_Success = false;
+
+		const char *Path() const { return m_aPath; }
+		int Flags() const { return m_Flags; }
+
+	protected:
+		void Run() override;
+
+	private:
+		IGraphics *m_pGraphics;
+		char m_aPath[IO_MAX_PATH_LENGTH];
+		int m_Flags;
+	};
+
 	IGraphics::CTextureHandle m_aTextures[MAX_MAPIMAGES];
 	int m_Count;
 
+	/**
+	 * External images which are still loading, their texture is the placeholder until then.
+	 */
+	std::shared_ptr<CMapImageLoadJob> m_apLoadJobs[MAX_MAPIMAGES];
+	int m_NumLoading;
+	bool m_ShowLoadWarning;
+	IGraphics::CTextureHandle m_PlaceholderTexture;
+
 	char m_aEntitiesPath[IO_MAX_PATH_LENGTH];
 
 public:
@@ -53,6 +89,7 @@ public:
 	void OnMapLoadImpl(class CLayers *pLayers, class IMap *pMap);
 	void OnMapLoad() override;
 	void OnInit() override;
+	void OnUpdate() override;
 	void Unload();
 	void LoadBackground(class CLayers *pLayers, class IMap *pMap);
 
@@ -79,6 +116,9 @@ private:
 	IGraphics::CTextureHandle m_OverlayCenterTexture;
 	int m_TextureScale;
 
+	void UpdateLoading(bool Wait);
+	void UpdateLoadWarning();
+
 	static void ConchainClTextEntitiesSize(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	void InitOverlayTextures();
 	IGraphics::CTextureHandle UploadEntityLayerText(int TextureSize, int MaxWidth, int YOffset);
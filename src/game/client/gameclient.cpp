@@ -688,6 +688,7 @@ void CGameClient::OnReset()
 	m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
 	m_PredictedWorld.CopyWorld(&m_GameWorld);
 	m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
+	m_PredictionHistory.Invalidate();
 
 	m_vSnapEntities.clear();
 
@@ -1281,6 +1282,8 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 	{
 		CNetMsg_Sv_PreInput *pMsg = (CNetMsg_Sv_PreInput *)pRawMsg;
 		m_aClients[pMsg->m_Owner].m_aPreInputs[pMsg->m_IntendedTick % 200] = *pMsg;
+		// the input might belong to an already predicted tick
+		m_PredictionHistory.Invalidate();
 	}
 	else if(MsgId == NETMSGTYPE_SV_SAVECODE)
 	{
@@ -2489,7 +2492,13 @@ void CGameClient::OnNewSnapshot()
 	UpdateLocalTuning();
 	m_IsDummySwapping = 0;
 	if(Client()->State() != IClient::STATE_DEMOPLAYBACK)
+	{
 		UpdatePrediction();
+		// only predict from the new snapshot if it differs from what was predicted for its tick
+		m_PredictionHistory.OnSnapshot(&m_GameWorld, Client()->GameTick(g_Config.m_ClDummy), [this](int Type, CEntity *pEnt) { return IsPredictedEntity(Type, pEnt); });
+	}
+	else
+		m_PredictionHistory.Invalidate();
 }
 
 std::function<bool(int, int, int, int)> CGameClient::GetScoreComparator(bool TimeScore, bool ReceivedMillisecondFinishTimes, bool Race7)
@@ -2601,11 +2610,15 @@ void CGameClient::OnPredict()
 
 	// we can't predict without our own id or own character
 	if(m_Snap.m_LocalClientId == -1 || !m_Snap.m_aCharacters[m_Snap.m_LocalClientId].m_Active)
+	{
+		m_PredictionHistory.Invalidate();
 		return;
+	}
 
 	// don't predict anything if we are paused
 	if(m_Snap.m_pGameInfoObj && m_Snap.m_pGameInfoObj->m_GameStateFlags & GAMESTATEFLAG_PAUSED)
 	{
+		m_PredictionHistory.Invalidate();
 		if(m_Snap.m_pLocalCharacter)
 		{
 			m_PredictedChar.Read(m_Snap.m_pLocalCharacter);
@@ -2625,24 +2638,38 @@ void CGameClient::OnPredict()
 
 	// init
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
+	int PredictionTick = Client()->GetPredictionTick();
 
-	// PredictedEvents are only handled in predicted world, so update them here
-	m_GameWorld.m_PredictedEvents = m_PredictedWorld.m_PredictedEvents;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
-
-	// don't predict inactive players, or entities from other teams
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
-			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
-				pChar->Destroy();
+	// the inputs of already predicted ticks are final, so the last prediction can be
+	// continued from its last tick as long as the snapshots since then confirmed it
+	CPredictionHistory::CSettings Settings;
+	Settings.m_Dummy = Dummy;
+	Settings.m_PredictDummy = PredictDummy();
+	// cl_predict_freeze 2 depends on the last predicted tick
+	if(g_Config.m_ClPredictFreeze == 2)
+		m_PredictionHistory.Invalidate();
+	const bool ContinuePrediction = m_PredictionHistory.CanContinue(&m_GameWorld, &m_PredictedWorld, Client()->GameTick(g_Config.m_ClDummy), PredictionTick, Client()->PredGameTick(g_Config.m_ClDummy), Settings);
 
-	CProjectile *pProjNext = nullptr;
-	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
+	if(!ContinuePrediction)
 	{
-		pProjNext = (CProjectile *)pProj->TypeNext();
-		if(IsOtherTeam(pProj->GetOwner()))
+		// PredictedEvents are only handled in predicted world, so update them here
+		m_GameWorld.m_PredictedEvents = m_PredictedWorld.m_PredictedEvents;
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
+
+		// don't predict inactive players, or entities from other teams
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
+				if(!IsPredictedEntity(CGameWorld::ENTTYPE_CHARACTER, pChar))
+					pChar->Destroy();
+
+		CEntity *pProjNext = nullptr;
+		for(CEntity *pProj = m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
 		{
-			pProj->Destroy();
+			pProjNext = pProj->TypeNext();
+			if(!IsPredictedEntity(CGameWorld::ENTTYPE_PROJECTILE, pProj))
+			{
+				pProj->Destroy();
+			}
 		}
 	}
 
@@ -2653,9 +2680,9 @@ void CGameClient::OnPredict()
 	if(PredictDummy())
 		pDummyChar = m_PredictedWorld.GetCharacterById(m_aLocalIds[!g_Config.m_ClDummy]);
 
-	int PredictionTick = Client()->GetPredictionTick();
 	// predict
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
+	const int FirstTick = ContinuePrediction ? m_PredictedWorld.GameTick() + 1 : Client()->GameTick(g_Config.m_ClDummy) + 1;
+	for(int Tick = FirstTick; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
 	{
 		// fetch the previous characters
 		if(Tick == PredictionTick)
@@ -2701,6 +2728,7 @@ void CGameClient::OnPredict()
 		ApplyPreInputs(Tick, false, m_PredictedWorld);
 
 		m_PredictedWorld.Tick();
+		m_PredictionHistory.OnPredictedTick(&m_PredictedWorld);
 
 		// fetch the current characters
 		if(Tick == PredictionTick)
@@ -3419,9 +3447,16 @@ void CGameClient::UpdateLocalTuning()
 {
 	m_GameWorld.m_WorldConfig.m_UseTuneZones = m_GameInfo.m_PredictDDRaceTiles;
 
+	// the ticks that were predicted with another tuning can't be continued
+	const auto SetTuning = [&](int TuneZone) {
+		if(mem_comp(&m_GameWorld.TuningList()[TuneZone], &m_aTuning[g_Config.m_ClDummy], sizeof(CTuningParams)) != 0)
+			m_PredictionHistory.Invalidate();
+		m_GameWorld.TuningList()[TuneZone] = m_aTuning[g_Config.m_ClDummy];
+	};
+
 	// always update default tune zone, even without character
 	if(!m_GameWorld.m_WorldConfig.m_UseTuneZones)
-		m_GameWorld.TuningList()[0] = m_aTuning[g_Config.m_ClDummy];
+		SetTuning(0);
 
 	if(!m_Snap.m_pLocalCharacter && !m_Snap.m_pSpectatorInfo)
 		return;
@@ -3458,8 +3493,7 @@ void CGameClient::UpdateLocalTuning()
 		{
 			if(m_aReceivedTuning[g_Config.m_ClDummy])
 			{
-				TuningList()[m_aExpectingTuningForZone[g_Config.m_ClDummy]] = m_aTuning[g_Config.m_ClDummy];
-				m_GameWorld.TuningList()[m_aExpectingTuningForZone[g_Config.m_ClDummy]] = m_aTuning[g_Config.m_ClDummy];
+				SetTuning(m_aExpectingTuningForZone[g_Config.m_ClDummy]);
 				m_aReceivedTuning[g_Config.m_ClDummy] = false;
 				m_aExpectingTuningForZone[g_Config.m_ClDummy] = -1;
 			}
@@ -3486,7 +3520,7 @@ void CGameClient::UpdateLocalTuning()
 		{
 			// if we have processed what we need, and the tuning is still wrong due to out of order message
 			// fix our tuning by using the current one
-			m_GameWorld.TuningList()[TuneZone] = m_aTuning[g_Config.m_ClDummy];
+			SetTuning(TuneZone);
 			m_aExpectingTuningSince[g_Config.m_ClDummy] = 0;
 			m_aReceivedTuning[g_Config.m_ClDummy] = false;
 		}
@@ -3624,6 +3658,15 @@ void CGameClient::UpdatePrediction()
 	m_GameWorld.NetObjEnd();
 }
 
+bool CGameClient::IsPredictedEntity(int Type, CEntity *pEnt) const
+{
+	if(Type == CGameWorld::ENTTYPE_CHARACTER)
+		return (m_Snap.m_aCharacters[pEnt->GetId()].m_Active || pEnt->m_SnapTicks <= 10) && !IsOtherTeam(pEnt->GetId());
+	if(Type == CGameWorld::ENTTYPE_PROJECTILE)
+		return !IsOtherTeam(((CProjectile *)pEnt)->GetOwner());
+	return true;
+}
+
 void CGameClient::UpdateSpectatorCursor()
 {
 	int CursorOwnerId = m_Snap.m_LocalClientId;
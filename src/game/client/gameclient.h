@@ -18,6 +18,7 @@
 #include <generated/protocolglue.h>
 
 #include <game/client/prediction/gameworld.h>
+#include <game/client/prediction/history.h>
 #include <game/client/race.h>
 #include <game/collision.h>
 #include <game/gamecore.h>
@@ -265,6 +266,8 @@ private:
 	// only used in OnPredict
 	vec2 m_aLastPos[MAX_CLIENTS];
 	bool m_aLastActive[MAX_CLIENTS];
+	// the ticks of the last prediction, to continue it instead of predicting from the snapshot again
+	CPredictionHistory m_PredictionHistory;
 
 	// only used in OnNewSnapshot
 	bool m_GameOver = false;
@@ -914,6 +917,7 @@ private:
 
 	void UpdateLocalTuning();
 	void UpdatePrediction();
+	bool IsPredictedEntity(int Type, CEntity *pEnt) const;
 	void UpdateSpectatorCursor();
 	void UpdateRenderedCharacters();
 	void HandlePredictedEvents(int Tick);
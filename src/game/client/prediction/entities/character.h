@@ -23,6 +23,7 @@ enum
 class CCharacter : public CEntity
 {
 	friend class CGameWorld;
+	friend class CPredictionHistory;
 
 public:
 	~CCharacter() override;
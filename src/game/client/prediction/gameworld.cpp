@@ -32,6 +32,11 @@ CGameWorld::CGameWorld()
 		pFirstEntityType = nullptr;
 	for(auto &pCharacter : m_apCharacters)
 		pCharacter = nullptr;
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		m_aFirstOrder[i] = 0;
+		m_aLastOrder[i] = 0;
+	}
 	m_pCollision = nullptr;
 	m_GameTick = 0;
 	m_pParent = nullptr;
@@ -41,6 +46,11 @@ CGameWorld::CGameWorld()
 CGameWorld::~CGameWorld()
 {
 	Clear();
+	for(auto &vpRecycledEntities : m_avpRecycledEntities)
+	{
+		for(CEntity *pEnt : vpRecycledEntities)
+			delete pEnt;
+	}
 	if(m_pChild && m_pChild->m_pParent == this)
 	{
 		OnModified();
@@ -71,23 +81,68 @@ CEntity *CGameWorld::FindLast(int Type)
 	return pLast;
 }
 
+void CGameWorld::UpdateGridPosition(CEntity *pEnt)
+{
+	m_aGrids[pEnt->m_ObjType].Move(&pEnt->m_GridNode, pEnt->m_Pos, pEnt->m_ProximityRadius);
+}
+
+void CGameWorld::SyncGrid(int Type)
+{
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		UpdateGridPosition(pEnt);
+}
+
+void CGameWorld::UpdateTickingEntity()
+{
+	// reset by RemoveEntity if the entity was removed during its tick
+	if(m_pTickingEntity)
+		UpdateGridPosition(m_pTickingEntity);
+	m_pTickingEntity = nullptr;
+}
+
+template<class F>
+void CGameWorld::ForEachEntityNear(int Type, vec2 Min, vec2 Max, F &&Callback)
+{
+	// entity positions are also changed outside of the world tick, e.g. when
+	// reading them from snapshots
+	if(!m_Ticking)
+		SyncGrid(Type);
+
+	// the callbacks might run queries themselves
+	std::vector<const CSpatialGrid<CEntity>::CNode *> vpCandidates;
+	std::swap(vpCandidates, m_vpQueryCandidates);
+	vpCandidates.clear();
+	if(!m_aGrids[Type].Collect(Min, Max, vpCandidates))
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			vpCandidates.push_back(&pEnt->m_GridNode);
+	}
+
+	for(const auto *pNode : vpCandidates)
+	{
+		if(!Callback(pNode->m_pEntity))
+			break;
+	}
+	std::swap(vpCandidates, m_vpQueryCandidates);
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
-	{
+	ForEachEntityNear(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius), [&](CEntity *pEnt) {
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
 			if(ppEnts)
 				ppEnts[Num] = pEnt;
 			Num++;
 			if(Num == Max)
-				break;
+				return false;
 		}
-	}
+		return true;
+	});
 
 	return Num;
 }
@@ -123,6 +178,10 @@ void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 		pEnt->m_pNextTypeEntity = nullptr;
 	}
 
+	// copied entities carry the grid node of their source world, Insert overwrites it
+	const int64_t Order = Last ? --m_aLastOrder[pEnt->m_ObjType] : ++m_aFirstOrder[pEnt->m_ObjType];
+	m_aGrids[pEnt->m_ObjType].Insert(&pEnt->m_GridNode, pEnt, Order, pEnt->m_Pos, pEnt->m_ProximityRadius);
+
 	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
 	{
 		auto *pChar = (CCharacter *)pEnt;
@@ -138,6 +197,9 @@ void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
 {
+	if(m_pTickingEntity == pEnt)
+		m_pTickingEntity = nullptr;
+
 	// not in the list
 	if(!pEnt->m_pNextTypeEntity && !pEnt->m_pPrevTypeEntity && m_apFirstEntityTypes[pEnt->m_ObjType] != pEnt)
 		return;
@@ -157,6 +219,8 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
 
+	m_aGrids[pEnt->m_ObjType].Remove(&pEnt->m_GridNode);
+
 	if(pEnt->m_pParent)
 	{
 		if(m_IsValidCopy && m_pParent && m_pParent->m_pChild == this)
@@ -198,6 +262,10 @@ void CGameWorld::RemoveEntities()
 
 void CGameWorld::Tick()
 {
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		SyncGrid(i);
+	m_Ticking = true;
+
 	// update all objects
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 	{
@@ -209,7 +277,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickingEntity = pEnt;
 				((CCharacter *)pEnt)->PreTick();
+				UpdateTickingEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -218,7 +288,9 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTickingEntity = pEnt;
 			pEnt->Tick();
+			UpdateTickingEntity();
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
@@ -227,11 +299,15 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTickingEntity = pEnt;
 			pEnt->TickDeferred();
+			UpdateTickingEntity();
 			pEnt->m_SnapTicks++;
 			pEnt = m_pNextTraverseEntity;
 		}
 
+	m_Ticking = false;
+
 	RemoveEntities();
 
 	// update switch state
@@ -264,20 +340,23 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Type, vec2 &NewPos, const CEntity *pNotThis, int CollideWith, const CEntity *pThisOnly)
 {
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x) - Radius, minimum(Pos0.y, Pos1.y) - Radius);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x) + Radius, maximum(Pos0.y, Pos1.y) + Radius);
+	ForEachEntityNear(Type, Min, Max, [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return true;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return true;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return true;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -294,7 +373,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+		return true;
+	});
 
 	return pClosest;
 }
@@ -302,11 +382,11 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x) - Radius, minimum(Pos0.y, Pos1.y) - Radius);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x) + Radius, maximum(Pos0.y, Pos1.y) + Radius);
+	ForEachEntityNear(ENTTYPE_CHARACTER, Min, Max, [&](CEntity *pChr) {
 		if(pChr == pNotThis)
-			continue;
+			return true;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
@@ -314,10 +394,11 @@ std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1
 			float Len = distance(pChr->m_Pos, IntersectPos);
 			if(Len < pChr->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pChr);
 			}
 		}
-	}
+		return true;
+	});
 	return vpCharacters;
 }
 
@@ -626,6 +707,41 @@ void CGameWorld::NetObjEnd()
 	}
 }
 
+void CGameWorld::RecycleEntities()
+{
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		// only the types copied by CopyWorld can be reused
+		const bool Recycle = Type == ENTTYPE_PROJECTILE || Type == ENTTYPE_LASER || Type == ENTTYPE_DRAGGER ||
+				     Type == ENTTYPE_CHARACTER || Type == ENTTYPE_PICKUP || Type == ENTTYPE_PLASMA;
+		while(CEntity *pEnt = m_apFirstEntityTypes[Type])
+		{
+			if(!Recycle)
+			{
+				delete pEnt; // NOLINT(clang-analyzer-cplusplus.NewDelete)
+				continue;
+			}
+			RemoveEntity(pEnt);
+			// detach it so its destructor doesn't touch this world anymore
+			pEnt->m_pGameWorld = nullptr;
+			m_avpRecycledEntities[Type].push_back(pEnt);
+		}
+	}
+}
+
+template<class T>
+T *CGameWorld::CopyEntity(const T *pFrom, int Type)
+{
+	std::vector<CEntity *> &vpRecycledEntities = m_avpRecycledEntities[Type];
+	if(vpRecycledEntities.empty())
+		return new T(*pFrom);
+	// every entity of a type has the same class, assigning reuses its memory and containers
+	T *pCopy = static_cast<T *>(vpRecycledEntities.back());
+	vpRecycledEntities.pop_back();
+	*pCopy = *pFrom;
+	return pCopy;
+}
+
 void CGameWorld::CopyWorld(CGameWorld *pFrom)
 {
 	if(pFrom == this || !pFrom)
@@ -644,8 +760,8 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 	m_Teams = pFrom->m_Teams;
 	m_Core.m_vSwitchers = pFrom->m_Core.m_vSwitchers;
 	m_PredictedEvents = pFrom->m_PredictedEvents;
-	// delete the previous entities
-	Clear();
+	// keep the previous entities for reuse
+	RecycleEntities();
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		m_apCharacters[i] = nullptr;
@@ -658,17 +774,17 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 		{
 			CEntity *pCopy = nullptr;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = CopyEntity((CProjectile *)pEnt, Type);
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = CopyEntity((CLaser *)pEnt, Type);
 			else if(Type == ENTTYPE_DRAGGER)
-				pCopy = new CDragger(*((CDragger *)pEnt));
+				pCopy = CopyEntity((CDragger *)pEnt, Type);
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = CopyEntity((CCharacter *)pEnt, Type);
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = CopyEntity((CPickup *)pEnt, Type);
 			else if(Type == ENTTYPE_PLASMA)
-				pCopy = new CPlasma(*((CPlasma *)pEnt));
+				pCopy = CopyEntity((CPlasma *)pEnt, Type);
 			if(pCopy)
 			{
 				pCopy->m_pParent = pEnt;
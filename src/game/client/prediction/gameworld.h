@@ -4,8 +4,10 @@
 #define GAME_CLIENT_PREDICTION_GAMEWORLD_H
 
 #include <game/gamecore.h>
+#include <game/spatial_grid.h>
 #include <game/teamscore.h>
 
+#include <cstdint>
 #include <list>
 #include <vector>
 
@@ -142,9 +144,31 @@ public:
 private:
 	void RemoveEntities();
 
+	// entities of the previous copy, CopyWorld assigns to them instead of
+	// allocating new ones
+	std::vector<CEntity *> m_avpRecycledEntities[NUM_ENTTYPES];
+	void RecycleEntities();
+	template<class T>
+	T *CopyEntity(const T *pFrom, int Type);
+
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// entity positions by type, the lists above stay authoritative for the order
+	CSpatialGrid<CEntity> m_aGrids[NUM_ENTTYPES];
+	int64_t m_aFirstOrder[NUM_ENTTYPES];
+	int64_t m_aLastOrder[NUM_ENTTYPES];
+	std::vector<const CSpatialGrid<CEntity>::CNode *> m_vpQueryCandidates;
+	// entity whose tick is running, its grid position is updated afterwards
+	CEntity *m_pTickingEntity = nullptr;
+	bool m_Ticking = false;
+
+	void UpdateGridPosition(CEntity *pEnt);
+	void SyncGrid(int Type);
+	void UpdateTickingEntity();
+	template<class F>
+	void ForEachEntityNear(int Type, vec2 Min, vec2 Max, F &&Callback);
+
 	CCharacter *m_apCharacters[MAX_CLIENTS];
 
 	CCollision *m_pCollision;
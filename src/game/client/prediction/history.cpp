@@ -0,0 +1,180 @@
+#include "history.h"
+
+#include "entities/character.h"
+#include "entity.h"
+#include "gameworld.h"
+
+#include <base/mem.h>
+
+#include <algorithm>
+#include <iterator>
+
+bool CPredictionHistory::CEntityState::operator<(const CEntityState &Other) const
+{
+	if(m_Type != Other.m_Type)
+		return m_Type < Other.m_Type;
+	if(m_X != Other.m_X)
+		return m_X < Other.m_X;
+	return m_Y < Other.m_Y;
+}
+
+void CPredictionHistory::Invalidate()
+{
+	m_Dirty = true;
+}
+
+bool CPredictionHistory::OnSnapshot(CGameWorld *pGameWorld, int GameTick, const TPredictEntityFunc &PredictEntity)
+{
+	const CTickState &Predicted = m_aTicks[GameTick % NUM_TICKS];
+	if(m_Dirty || Predicted.m_Tick != GameTick || pGameWorld->GameTick() != GameTick)
+	{
+		m_Dirty = true;
+		return false;
+	}
+
+	Record(pGameWorld, &PredictEntity, &m_Snapshot);
+	if(!SameState(Predicted, m_Snapshot))
+	{
+		m_Dirty = true;
+		return false;
+	}
+
+	// the predicted world already contains this snapshot
+	m_GameTick = GameTick;
+	m_NumContinuedSnapshots++;
+	return true;
+}
+
+static bool SameConfig(const CGameWorld *pWorld, const CGameWorld *pOther)
+{
+	const auto &Config = pWorld->m_WorldConfig;
+	const auto &Other = pOther->m_WorldConfig;
+	return Config.m_IsDDRace == Other.m_IsDDRace &&
+	       Config.m_IsVanilla == Other.m_IsVanilla &&
+	       Config.m_IsFNG == Other.m_IsFNG &&
+	       Config.m_InfiniteAmmo == Other.m_InfiniteAmmo &&
+	       Config.m_PredictTiles == Other.m_PredictTiles &&
+	       Config.m_PredictFreeze == Other.m_PredictFreeze &&
+	       Config.m_PredictWeapons == Other.m_PredictWeapons &&
+	       Config.m_PredictDDRace == Other.m_PredictDDRace &&
+	       Config.m_IsSolo == Other.m_IsSolo &&
+	       Config.m_UseTuneZones == Other.m_UseTuneZones &&
+	       Config.m_BugDDRaceInput == Other.m_BugDDRaceInput &&
+	       Config.m_NoWeakHookAndBounce == Other.m_NoWeakHookAndBounce &&
+	       Config.m_PredictEvents == Other.m_PredictEvents;
+}
+
+bool CPredictionHistory::CanContinue(const CGameWorld *pGameWorld, const CGameWorld *pPredictedWorld, int GameTick, int PredictionTick, int PredGameTick, const CSettings &Settings)
+{
+	const bool SameBase = !m_Dirty && pGameWorld->m_pChild == pPredictedWorld && m_GameTick == GameTick && SameConfig(pGameWorld, pPredictedWorld);
+	const bool NewTicks = pPredictedWorld->GameTick() < PredictionTick && PredictionTick <= PredGameTick;
+	const bool Continue = SameBase && NewTicks && m_Settings == Settings;
+
+	m_Dirty = false;
+	m_GameTick = GameTick;
+	m_Settings = Settings;
+	if(!Continue)
+	{
+		// the recorded ticks belong to the old prediction
+		for(CTickState &Tick : m_aTicks)
+			Tick.m_Tick = -1;
+	}
+	return Continue;
+}
+
+void CPredictionHistory::OnPredictedTick(CGameWorld *pPredictedWorld)
+{
+	Record(pPredictedWorld, nullptr, &m_aTicks[pPredictedWorld->GameTick() % NUM_TICKS]);
+}
+
+void CPredictionHistory::Record(CGameWorld *pWorld, const TPredictEntityFunc *pPredictEntity, CTickState *pState)
+{
+	pState->m_Tick = pWorld->GameTick();
+	pState->m_vCharacters.clear();
+	pState->m_vEntities.clear();
+	pState->m_vSwitchers.clear();
+
+	std::vector<int> vTeams;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChar = pWorld->GetCharacterById(i);
+		if(!pChar || (pPredictEntity && !(*pPredictEntity)(CGameWorld::ENTTYPE_CHARACTER, pChar)))
+			continue;
+
+		// zeroed, so the states can be compared as a whole
+		CCharacterState &State = pState->m_vCharacters.emplace_back();
+		mem_zero(&State, sizeof(State));
+		const CCharacterCore &Core = pChar->m_Core;
+		State.m_Id = i;
+		Core.Write(&State.m_Core);
+		State.m_Input = pChar->m_Input;
+		State.m_ActiveWeapon = Core.m_ActiveWeapon;
+		for(int Weapon = 0; Weapon < NUM_WEAPONS; Weapon++)
+		{
+			State.m_aWeaponGot[Weapon] = Core.m_aWeapons[Weapon].m_Got;
+			State.m_aWeaponAmmo[Weapon] = Core.m_aWeapons[Weapon].m_Ammo;
+		}
+		State.m_FreezeTime = pChar->m_FreezeTime;
+		State.m_Jumps = Core.m_Jumps;
+		State.m_JumpedTotal = Core.m_JumpedTotal;
+		State.m_ReloadTimer = pChar->m_ReloadTimer;
+		State.m_AttackTick = pChar->m_AttackTick;
+		State.m_NinjaActivationTick = Core.m_Ninja.m_ActivationTick;
+		const bool aFlags[] = {
+			Core.m_DeepFrozen,
+			Core.m_LiveFrozen,
+			Core.m_Solo,
+			Core.m_Super,
+			Core.m_Jetpack,
+			Core.m_EndlessHook,
+			Core.m_EndlessJump,
+			Core.m_CollisionDisabled,
+			Core.m_HookHitDisabled,
+			Core.m_HammerHitDisabled,
+			Core.m_ShotgunHitDisabled,
+			Core.m_GrenadeHitDisabled,
+			Core.m_LaserHitDisabled,
+			Core.m_HasTelegunGun,
+			Core.m_HasTelegunGrenade,
+			Core.m_HasTelegunLaser,
+			pChar->m_NinjaJetpack,
+		};
+		for(int Flag = 0; Flag < (int)std::size(aFlags); Flag++)
+			State.m_Flags |= aFlags[Flag] << Flag;
+		State.m_Team = pChar->Team();
+		if(std::find(vTeams.begin(), vTeams.end(), State.m_Team) == vTeams.end())
+			vTeams.push_back(State.m_Team);
+	}
+
+	for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+	{
+		if(Type == CGameWorld::ENTTYPE_CHARACTER)
+			continue;
+		for(CEntity *pEnt = pWorld->FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+			if(!pPredictEntity || (*pPredictEntity)(Type, pEnt))
+				pState->m_vEntities.push_back({Type, round_to_int(pEnt->m_Pos.x), round_to_int(pEnt->m_Pos.y)});
+	}
+	// entities of the snapshot are in a different order than the predicted ones
+	std::sort(pState->m_vEntities.begin(), pState->m_vEntities.end());
+
+	// only the switchers of the predicted teams can change the prediction
+	std::sort(vTeams.begin(), vTeams.end());
+	for(const SSwitchers &Switcher : pWorld->m_Core.m_vSwitchers)
+		for(int Team : vTeams)
+		{
+			if(Team < 0 || Team >= NUM_DDRACE_TEAMS)
+				continue;
+			pState->m_vSwitchers.push_back(Switcher.m_aStatus[Team]);
+			pState->m_vSwitchers.push_back(Switcher.m_aEndTick[Team]);
+			pState->m_vSwitchers.push_back(Switcher.m_aType[Team]);
+		}
+}
+
+bool CPredictionHistory::SameState(const CTickState &State, const CTickState &Other)
+{
+	return State.m_Tick == Other.m_Tick &&
+	       State.m_vCharacters.size() == Other.m_vCharacters.size() &&
+	       (State.m_vCharacters.empty() || mem_comp(State.m_vCharacters.data(), Other.m_vCharacters.data(), State.m_vCharacters.size() * sizeof(CCharacterState)) == 0) &&
+	       State.m_vEntities == Other.m_vEntities &&
+	       State.m_vSwitchers == Other.m_vSwitchers;
+}
@@ -0,0 +1,108 @@
+#ifndef GAME_CLIENT_PREDICTION_HISTORY_H
+#define GAME_CLIENT_PREDICTION_HISTORY_H
+
+#include <engine/shared/protocol.h>
+
+#include <generated/protocol.h>
+
+#include <functional>
+#include <vector>
+
+class CEntity;
+class CGameWorld;
+
+// Decides whether the predicted world of the last prediction can be continued instead of
+// predicting again from the gameworld. For this the state of the predicted world is recorded
+// after every predicted tick, so a new snapshot can be compared with what was predicted for its
+// tick. Only if they differ, the prediction has to start again from the snapshot.
+class CPredictionHistory
+{
+public:
+	enum
+	{
+		// predicted ticks that are kept to compare snapshots with
+		NUM_TICKS = 2 * SERVER_TICK_SPEED,
+	};
+
+	// whether an entity of the gameworld is copied into the predicted world
+	typedef std::function<bool(int Type, CEntity *pEnt)> TPredictEntityFunc;
+
+	class CSettings
+	{
+	public:
+		bool m_Dummy = false;
+		bool m_PredictDummy = false;
+
+		bool operator==(const CSettings &Other) const = default;
+	};
+
+	// the next prediction starts from the gameworld again
+	void Invalidate();
+	// Called after the gameworld was updated with the snapshot of `GameTick`. The prediction
+	// is kept if it predicted the same state for this tick as the snapshot contains.
+	bool OnSnapshot(CGameWorld *pGameWorld, int GameTick, const TPredictEntityFunc &PredictEntity);
+	// Whether the predicted world can be predicted further from its last tick. The antiping tick
+	// `PredictionTick` is only fetched while predicting, so it must not be predicted yet.
+	// Otherwise the history is cleared and the predicted world has to be copied from the
+	// gameworld at `GameTick` again.
+	bool CanContinue(const CGameWorld *pGameWorld, const CGameWorld *pPredictedWorld, int GameTick, int PredictionTick, int PredGameTick, const CSettings &Settings);
+	// records the state of the predicted world after its current tick
+	void OnPredictedTick(CGameWorld *pPredictedWorld);
+
+	int NumContinuedSnapshots() const { return m_NumContinuedSnapshots; }
+
+private:
+	// the parts of a character that decide how it is predicted further
+	class CCharacterState
+	{
+	public:
+		int m_Id;
+		CNetObj_CharacterCore m_Core;
+		CNetObj_PlayerInput m_Input;
+		int m_ActiveWeapon;
+		int m_aWeaponGot[NUM_WEAPONS];
+		int m_aWeaponAmmo[NUM_WEAPONS];
+		int m_FreezeTime;
+		int m_Jumps;
+		int m_JumpedTotal;
+		int m_ReloadTimer;
+		int m_AttackTick;
+		int m_NinjaActivationTick;
+		int m_Flags;
+		int m_Team;
+	};
+
+	class CEntityState
+	{
+	public:
+		int m_Type;
+		int m_X;
+		int m_Y;
+
+		bool operator<(const CEntityState &Other) const;
+		bool operator==(const CEntityState &Other) const = default;
+	};
+
+	class CTickState
+	{
+	public:
+		int m_Tick = -1;
+		std::vector<CCharacterState> m_vCharacters;
+		std::vector<CEntityState> m_vEntities;
+		std::vector<int> m_vSwitchers;
+	};
+
+	static void Record(CGameWorld *pWorld, const TPredictEntityFunc *pPredictEntity, CTickState *pState);
+	static bool SameState(const CTickState &State, const CTickState &Other);
+
+	CTickState m_aTicks[NUM_TICKS];
+	// scratch space for the state of a snapshot
+	CTickState m_Snapshot;
+
+	bool m_Dirty = true;
+	int m_GameTick = -1;
+	CSettings m_Settings;
+	int m_NumContinuedSnapshots = 0;
+};
+
+#endif
@@ -15,6 +15,7 @@
 #include <game/mapitems.h>
 
 #include <cmath>
+#include <limits>
 
 vec2 ClampVel(int MoveRestriction, vec2 Vel)
 {
@@ -326,16 +327,77 @@ int CCollision::GetTile(int x, int y) const
 	return 0;
 }
 
-// TODO: rewrite this smarter!
+namespace {
+// Produces the same samples along a line as the per-pixel collision loops
+// always did. Since every sample within a tile gives the same result for the
+// tile based checks, tiles that don't stop the line are skipped as a whole by
+// jumping to the first sample that lands in another tile.
+class CLineSampler
+{
+	vec2 m_Pos0;
+	vec2 m_Pos1;
+	float m_Divisor;
+	int m_Width;
+	int m_Height;
+
+	ivec2 TileAt(int i) const
+	{
+		const vec2 Pos = Sample(i);
+		return ivec2(std::clamp(round_to_int(Pos.x) / 32, 0, m_Width - 1), std::clamp(round_to_int(Pos.y) / 32, 0, m_Height - 1));
+	}
+
+	// line parameter at which a coordinate stops rounding into the given tile
+	static double LeaveParam(float Start, float Delta, int Tile, int NumTiles)
+	{
+		if(Delta > 0 && Tile < NumTiles - 1)
+			return ((Tile + 1) * 32 - 0.5 - Start) / Delta;
+		if(Delta < 0 && Tile > 0)
+			return (Tile * 32 - 0.5 - Start) / Delta;
+		return std::numeric_limits<double>::infinity();
+	}
+
+public:
+	int m_NumSamples;
+
+	CLineSampler(vec2 Pos0, vec2 Pos1, float Divisor, int NumSamples, int Width, int Height) :
+		m_Pos0(Pos0), m_Pos1(Pos1), m_Divisor(Divisor), m_Width(Width), m_Height(Height), m_NumSamples(NumSamples)
+	{
+	}
+
+	vec2 Sample(int i) const { return mix(m_Pos0, m_Pos1, i / m_Divisor); }
+
+	int NextTile(int i) const
+	{
+		if(m_Width <= 0 || m_Height <= 0)
+			return i + 1;
+
+		// estimate where the line leaves the tile, the samples around the
+		// estimate then decide, so that float rounding can't skip any of them
+		const ivec2 Tile = TileAt(i);
+		const double Estimate = minimum(LeaveParam(m_Pos0.x, m_Pos1.x - m_Pos0.x, Tile.x, m_Width), LeaveParam(m_Pos0.y, m_Pos1.y - m_Pos0.y, Tile.y, m_Height)) * m_Divisor;
+		int Next = m_NumSamples;
+		if(Estimate < m_NumSamples)
+			Next = Estimate > i + 1 ? (int)std::ceil(Estimate) : i + 1;
+
+		// the tile coordinates are monotonic along the line
+		while(Next > i + 1 && TileAt(Next - 1) != Tile)
+			Next--;
+		while(Next < m_NumSamples && TileAt(Next) == Tile)
+			Next++;
+		return Next;
+	}
+};
+}
+
 int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
+	const CLineSampler Sampler(Pos0, Pos1, End, End + 1, m_Width, m_Height);
 	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -349,7 +411,9 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 			return GetCollisionAt(ix, iy);
 		}
 
-		Last = Pos;
+		const int Next = Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -365,10 +429,10 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 	vec2 Last = Pos0;
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
-	for(int i = 0; i <= End; i++)
+	const CLineSampler Sampler(Pos0, Pos1, End, End + 1, m_Width, m_Height);
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -391,7 +455,8 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 		}
 
 		int Hit = 0;
-		if(CheckPoint(ix, iy))
+		bool Solid = CheckPoint(ix, iy);
+		if(Solid)
 		{
 			if(!IsThrough(ix, iy, dx, dy, Pos0, Pos1))
 				Hit = GetCollisionAt(ix, iy);
@@ -409,7 +474,11 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 			return Hit;
 		}
 
-		Last = Pos;
+		// the through check also looks at a neighbouring pixel, so solid
+		// tiles the hook passes through are still stepped sample by sample
+		const int Next = Solid ? i + 1 : Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -422,11 +491,11 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
+	const CLineSampler Sampler(Pos0, Pos1, End, End + 1, m_Width, m_Height);
 	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -457,7 +526,9 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			return GetCollisionAt(ix, iy);
 		}
 
-		Last = Pos;
+		const int Next = Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1149,10 +1220,10 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSampler Sampler(Pos0, Pos1, Distance, DistanceRounded, m_Width, m_Height);
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, m_Width - 1);
 		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, m_Height - 1);
 		if(GetIndex(Nx, Ny) == TILE_SOLID || GetIndex(Nx, Ny) == TILE_NOHOOK || GetIndex(Nx, Ny) == TILE_NOLASER || GetFrontIndex(Nx, Ny) == TILE_NOLASER)
@@ -1166,7 +1237,9 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 			else
 				return GetCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
+		const int Next = Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1181,10 +1254,10 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSampler Sampler(Pos0, Pos1, Distance, DistanceRounded, m_Width, m_Height);
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || IsFrontNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
 		{
 			if(pOutCollision)
@@ -1196,7 +1269,9 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			else
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
+		const int Next = Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1211,10 +1286,10 @@ int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pO
 	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSampler Sampler(Pos0, Pos1, Distance, DistanceRounded, m_Width, m_Height);
+	for(int i = 0; i < Sampler.m_NumSamples;)
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Sampler.Sample(i);
 		if(IsSolid(round_to_int(Pos.x), round_to_int(Pos.y)) || (!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y))))
 		{
 			if(pOutCollision)
@@ -1228,7 +1303,9 @@ int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pO
 			else
 				return GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y));
 		}
-		Last = Pos;
+		const int Next = Sampler.NextTile(i);
+		Last = Next == i + 1 ? Pos : Sampler.Sample(Next - 1);
+		i = Next;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
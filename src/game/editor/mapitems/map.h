@@ -38,6 +38,7 @@ class IEditorEnvelopeReference;
 class CDataFileWriterFinishJob : public IJob
 {
 	IStorage *m_pStorage;
+	CJobPool *m_pJobPool;
 	char m_aRealFilename[IO_MAX_PATH_LENGTH];
 	char m_aTempFilename[IO_MAX_PATH_LENGTH];
 	char m_aErrorMessage[2 * IO_MAX_PATH_LENGTH + 128];
@@ -46,7 +47,7 @@ class CDataFileWriterFinishJob : public IJob
 	void Run() override;
 
 public:
-	CDataFileWriterFinishJob(IStorage *pStorage, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer);
+	CDataFileWriterFinishJob(IStorage *pStorage, CJobPool *pJobPool, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer);
 	const char *RealFilename() const { return m_aRealFilename; }
 	const char *ErrorMessage() const { return m_aErrorMessage; }
 };
@@ -9,6 +9,9 @@ const int LAYER_DEFAULT_TILESET = -1;
 
 void CMapRenderer::Clear()
 {
+	// the tile layers are recorded on jobs
+	if(!m_vpRenderLayers.empty())
+		Graphics()->MergeCommandLists();
 	for(auto &pLayer : m_vpRenderLayers)
 		pLayer->Unload();
 	m_vpRenderLayers.clear();
@@ -205,13 +205,18 @@ void CRenderLayer::RenderLoading() const
 }
 
 bool CRenderLayer::IsVisibleInClipRegion(const std::optional<CClipRegion> &ClipRegion) const
+{
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+	return IsVisibleInClipRegion(ClipRegion, ScreenX0, ScreenY0, ScreenX1, ScreenY1);
+}
+
+bool CRenderLayer::IsVisibleInClipRegion(const std::optional<CClipRegion> &ClipRegion, float ScreenX0, float ScreenY0, float ScreenX1, float ScreenY1)
 {
 	// always show unclipped regions
 	if(!ClipRegion.has_value())
 		return true;
 
-	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 	float Left = ClipRegion->m_X;
 	float Top = ClipRegion->m_Y;
 	float Right = ClipRegion->m_X + ClipRegion->m_Width;
@@ -291,21 +296,21 @@ CRenderLayerTile::CRenderLayerTile(int GroupId, int LayerId, int Flags, CMapItem
 	m_pTiles = nullptr;
 }
 
-void CRenderLayerTile::RenderTileLayer(const ColorRGBA &Color, const CRenderLayerParams &Params, CTileLayerVisuals *pTileLayerVisuals)
+void CRenderLayerTile::RenderTileLayer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params, CTileLayerVisuals *pTileLayerVisuals)
 {
 	CTileLayerVisuals &Visuals = pTileLayerVisuals ? *pTileLayerVisuals : m_VisualTiles.value();
 	if(Visuals.m_BufferContainerIndex == -1)
 		return; // no visuals were created
 
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+	pCommandList->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 
 	int ScreenRectY0 = std::floor(ScreenY0 / 32);
 	int ScreenRectX0 = std::floor(ScreenX0 / 32);
 	int ScreenRectY1 = std::ceil(ScreenY1 / 32);
 	int ScreenRectX1 = std::ceil(ScreenX1 / 32);
 
-	if(IsVisibleInClipRegion(m_LayerClip))
+	if(IsVisibleInClipRegion(m_LayerClip, ScreenX0, ScreenY0, ScreenX1, ScreenY1))
 	{
 		// create the indice buffers we want to draw -- reuse them
 		std::vector<char *> vpIndexOffsets;
@@ -338,18 +343,18 @@ void CRenderLayerTile::RenderTileLayer(const ColorRGBA &Color, const CRenderLaye
 			int DrawCount = vpIndexOffsets.size();
 			if(DrawCount != 0)
 			{
-				Graphics()->RenderTileLayer(Visuals.m_BufferContainerIndex, Color, vpIndexOffsets.data(), vDrawCounts.data(), DrawCount);
+				pCommandList->RenderTileLayer(Visuals.m_BufferContainerIndex, Color, vpIndexOffsets.data(), vDrawCounts.data(), DrawCount);
 			}
 		}
 	}
 
 	if(Params.m_RenderTileBorder && (ScreenRectX1 > (int)Visuals.m_Width || ScreenRectY1 > (int)Visuals.m_Height || ScreenRectX0 < 0 || ScreenRectY0 < 0))
 	{
-		RenderTileBorder(Color, ScreenRectX0, ScreenRectY0, ScreenRectX1, ScreenRectY1, &Visuals);
+		RenderTileBorder(pCommandList, Color, ScreenRectX0, ScreenRectY0, ScreenRectX1, ScreenRectY1, &Visuals);
 	}
 }
 
-void CRenderLayerTile::RenderTileBorder(const ColorRGBA &Color, int BorderX0, int BorderY0, int BorderX1, int BorderY1, CTileLayerVisuals *pTileLayerVisuals)
+void CRenderLayerTile::RenderTileBorder(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, int BorderX0, int BorderY0, int BorderX1, int BorderY1, CTileLayerVisuals *pTileLayerVisuals)
 {
 	CTileLayerVisuals &Visuals = *pTileLayerVisuals;
 
@@ -361,7 +366,7 @@ void CRenderLayerTile::RenderTileBorder(const ColorRGBA &Color, int BorderX0, in
 	// corners
 	auto DrawCorner = [&](vec2 Offset, vec2 Scale, CTileLayerVisuals::CTileVisual &Visual) {
 		Offset *= 32.0f;
-		Graphics()->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, (offset_ptr_size)Visual.IndexBufferByteOffset(), Offset, Scale, 1);
+		pCommandList->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, (offset_ptr_size)Visual.IndexBufferByteOffset(), Offset, Scale, 1);
 	};
 
 	if(BorderX0 < 0)
@@ -406,7 +411,7 @@ void CRenderLayerTile::RenderTileBorder(const ColorRGBA &Color, int BorderX0, in
 		unsigned int DrawNum = ((EndVisual.IndexBufferByteOffset() - StartVisual.IndexBufferByteOffset()) / (sizeof(unsigned int) * 6)) + (EndVisual.DoDraw() ? 1lu : 0lu);
 		offset_ptr_size pOffset = (offset_ptr_size)StartVisual.IndexBufferByteOffset();
 		Offset *= 32.0f;
-		Graphics()->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, pOffset, Offset, Scale, DrawNum);
+		pCommandList->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, pOffset, Offset, Scale, DrawNum);
 	};
 
 	if(Y0 < (int)Visuals.m_Height && Y1 > 0)
@@ -450,14 +455,14 @@ void CRenderLayerTile::RenderTileBorder(const ColorRGBA &Color, int BorderX0, in
 	}
 }
 
-void CRenderLayerTile::RenderKillTileBorder(const ColorRGBA &Color)
+void CRenderLayerTile::RenderKillTileBorder(IGraphicsCommandList *pCommandList, const ColorRGBA &Color)
 {
 	CTileLayerVisuals &Visuals = m_VisualTiles.value();
 	if(Visuals.m_BufferContainerIndex == -1)
 		return; // no visuals were created
 
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+	pCommandList->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 
 	int BorderY0 = std::floor(ScreenY0 / 32);
 	int BorderX0 = std::floor(ScreenX0 / 32);
@@ -477,7 +482,7 @@ void CRenderLayerTile::RenderKillTileBorder(const ColorRGBA &Color)
 	auto DrawKillBorder = [&](vec2 Offset, vec2 Scale) {
 		offset_ptr_size pOffset = (offset_ptr_size)Visuals.m_BorderKillTile.IndexBufferByteOffset();
 		Offset *= 32.0f;
-		Graphics()->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, pOffset, Offset, Scale, 1);
+		pCommandList->RenderBorderTiles(Visuals.m_BufferContainerIndex, Color, pOffset, Offset, Scale, 1);
 	};
 
 	// Draw left kill tile border
@@ -528,7 +533,10 @@ void CRenderLayerTile::Render(const CRenderLayerParams &Params)
 	ColorRGBA Color = GetRenderColor(Params);
 	if(Graphics()->IsTileBufferingEnabled() && Params.m_TileAndQuadBuffering)
 	{
-		RenderTileLayerWithTileBuffer(Color, Params);
+		// envelopes and textures are evaluated here, only the visible tiles are collected on a job
+		Graphics()->RecordCommandList([this, Color, Params](IGraphicsCommandList *pCommandList) {
+			RenderTileLayerWithTileBuffer(pCommandList, Color, Params);
+		});
 	}
 	else
 	{
@@ -560,9 +568,9 @@ bool CRenderLayerTile::DoRender(const CRenderLayerParams &Params)
 	return true;
 }
 
-void CRenderLayerTile::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
+void CRenderLayerTile::RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params)
 {
-	RenderTileLayer(Color, Params);
+	RenderTileLayer(pCommandList, Color, Params);
 }
 
 void CRenderLayerTile::RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
@@ -575,13 +583,17 @@ void CRenderLayerTile::RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const
 
 void CRenderLayerTile::Init()
 {
-	if(m_pLayerTilemap->m_Image >= 0 && m_pLayerTilemap->m_Image < m_pMapImages->Num())
-		m_TextureHandle = m_pMapImages->Get(m_pLayerTilemap->m_Image);
-	else
-		m_TextureHandle.Invalidate();
 	UploadTileData(m_VisualTiles, 0, false);
 }
 
+IGraphics::CTextureHandle CRenderLayerTile::GetTexture() const
+{
+	// not stored, the map image changes from a placeholder to the texture when it finished loading
+	if(m_pLayerTilemap->m_Image >= 0 && m_pLayerTilemap->m_Image < m_pMapImages->Num())
+		return m_pMapImages->Get(m_pLayerTilemap->m_Image);
+	return IGraphics::CTextureHandle();
+}
+
 void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer)
 {
 	if(!Graphics()->IsTileBufferingEnabled())
@@ -1030,11 +1042,6 @@ void CRenderLayerQuads::OnInit(IGraphics *pGraphics, ITextRender *pTextRender, C
 
 void CRenderLayerQuads::Init()
 {
-	if(m_pLayerQuads->m_Image >= 0 && m_pLayerQuads->m_Image < m_pMapImages->Num())
-		m_TextureHandle = m_pMapImages->Get(m_pLayerQuads->m_Image);
-	else
-		m_TextureHandle.Invalidate();
-
 	if(!Graphics()->IsQuadBufferingEnabled())
 	{
 		// create clip region for unbuffered backends
@@ -1322,6 +1329,13 @@ bool CRenderLayerQuads::CalculateQuadClipping(const CQuadCluster &QuadCluster, f
 	return true;
 }
 
+IGraphics::CTextureHandle CRenderLayerQuads::GetTexture() const
+{
+	if(m_pLayerQuads->m_Image >= 0 && m_pLayerQuads->m_Image < m_pMapImages->Num())
+		return m_pMapImages->Get(m_pLayerQuads->m_Image);
+	return IGraphics::CTextureHandle();
+}
+
 void CRenderLayerQuads::CalculateClipping(CQuadCluster &QuadCluster)
 {
 	float aQuadOffsetMin[2];
@@ -1436,11 +1450,11 @@ void CRenderLayerEntityGame::Init()
 	UploadTileData(m_VisualTiles, 0, false, true);
 }
 
-void CRenderLayerEntityGame::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
+void CRenderLayerEntityGame::RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params)
 {
 	if(Params.m_RenderTileBorder)
-		RenderKillTileBorder(Color.Multiply(GetDeathBorderColor()));
-	RenderTileLayer(Color, Params);
+		RenderKillTileBorder(pCommandList, Color.Multiply(GetDeathBorderColor()));
+	RenderTileLayer(pCommandList, Color, Params);
 }
 
 void CRenderLayerEntityGame::RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
@@ -1509,13 +1523,13 @@ void CRenderLayerEntityTele::Unload()
 	}
 }
 
-void CRenderLayerEntityTele::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
+void CRenderLayerEntityTele::RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params)
 {
-	RenderTileLayer(Color, Params);
+	RenderTileLayer(pCommandList, Color, Params);
 	if(Params.m_RenderText)
 	{
-		Graphics()->TextureSet(m_pMapImages->GetOverlayCenter());
-		RenderTileLayer(Color, Params, &m_VisualTeleNumbers.value());
+		pCommandList->TextureSet(m_pMapImages->GetOverlayCenter());
+		RenderTileLayer(pCommandList, Color, Params, &m_VisualTeleNumbers.value());
 	}
 }
 
@@ -1599,20 +1613,19 @@ void CRenderLayerEntitySpeedup::GetTileData(unsigned char *pIndex, unsigned char
 		*pIndex = MaxSpeed;
 }
 
-void CRenderLayerEntitySpeedup::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
+void CRenderLayerEntitySpeedup::RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params)
 {
-	// draw arrow -- clamp to the edge of the arrow image
-	Graphics()->WrapClamp();
-	UseTexture(GetTexture());
-	RenderTileLayer(Color, Params);
-	Graphics()->WrapNormal();
+	// draw arrow -- clamp to the edge of the arrow image, the list starts with its texture
+	pCommandList->WrapClamp();
+	RenderTileLayer(pCommandList, Color, Params);
+	pCommandList->WrapNormal();
 
 	if(Params.m_RenderText)
 	{
-		Graphics()->TextureSet(m_pMapImages->GetOverlayBottom());
-		RenderTileLayer(Color, Params, &m_VisualForce.value());
-		Graphics()->TextureSet(m_pMapImages->GetOverlayTop());
-		RenderTileLayer(Color, Params, &m_VisualMaxSpeed.value());
+		pCommandList->TextureSet(m_pMapImages->GetOverlayBottom());
+		RenderTileLayer(pCommandList, Color, Params, &m_VisualForce.value());
+		pCommandList->TextureSet(m_pMapImages->GetOverlayTop());
+		RenderTileLayer(pCommandList, Color, Params, &m_VisualMaxSpeed.value());
 	}
 }
 
@@ -1680,15 +1693,15 @@ void CRenderLayerEntitySwitch::GetTileData(unsigned char *pIndex, unsigned char
 		*pIndex = m_pSwitchTiles[y * m_pLayerTilemap->m_Width + x].m_Delay;
 }
 
-void CRenderLayerEntitySwitch::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
+void CRenderLayerEntitySwitch::RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params)
 {
-	RenderTileLayer(Color, Params);
+	RenderTileLayer(pCommandList, Color, Params);
 	if(Params.m_RenderText)
 	{
-		Graphics()->TextureSet(m_pMapImages->GetOverlayTop());
-		RenderTileLayer(Color, Params, &m_VisualSwitchNumberTop.value());
-		Graphics()->TextureSet(m_pMapImages->GetOverlayBottom());
-		RenderTileLayer(Color, Params, &m_VisualSwitchNumberBottom.value());
+		pCommandList->TextureSet(m_pMapImages->GetOverlayTop());
+		RenderTileLayer(pCommandList, Color, Params, &m_VisualSwitchNumberTop.value());
+		pCommandList->TextureSet(m_pMapImages->GetOverlayBottom());
+		RenderTileLayer(pCommandList, Color, Params, &m_VisualSwitchNumberBottom.value());
 	}
 }
 
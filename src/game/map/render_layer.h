@@ -75,6 +75,7 @@ public:
 	virtual void Unload() = 0;
 
 	bool IsVisibleInClipRegion(const std::optional<CClipRegion> &ClipRegion) const;
+	static bool IsVisibleInClipRegion(const std::optional<CClipRegion> &ClipRegion, float ScreenX0, float ScreenY0, float ScreenX1, float ScreenY1);
 	int GetGroup() const { return m_GroupId; }
 
 protected:
@@ -133,12 +134,9 @@ protected:
 	virtual ColorRGBA GetRenderColor(const CRenderLayerParams &Params) const;
 	virtual void InitTileData();
 	virtual void GetTileData(unsigned char *pIndex, unsigned char *pFlags, int *pAngleRotate, unsigned int x, unsigned int y, int CurOverlay) const;
-	IGraphics::CTextureHandle GetTexture() const override { return m_TextureHandle; }
+	IGraphics::CTextureHandle GetTexture() const override;
 	CTile *m_pTiles;
 
-private:
-	IGraphics::CTextureHandle m_TextureHandle;
-
 protected:
 	class CTileLayerVisuals : public CRenderComponent
 	{
@@ -212,12 +210,13 @@ protected:
 
 	void UploadTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer = false);
 
-	virtual void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params);
+	// records on a job, the layer must not be unloaded before the graphics merged the command lists
+	virtual void RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params);
 	virtual void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params);
 
-	void RenderTileLayer(const ColorRGBA &Color, const CRenderLayerParams &Params, CTileLayerVisuals *pTileLayerVisuals = nullptr);
-	void RenderTileBorder(const ColorRGBA &Color, int BorderX0, int BorderY0, int BorderX1, int BorderY1, CTileLayerVisuals *pTileLayerVisuals);
-	void RenderKillTileBorder(const ColorRGBA &Color);
+	void RenderTileLayer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params, CTileLayerVisuals *pTileLayerVisuals = nullptr);
+	void RenderTileBorder(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, int BorderX0, int BorderY0, int BorderX1, int BorderY1, CTileLayerVisuals *pTileLayerVisuals);
+	void RenderKillTileBorder(IGraphicsCommandList *pCommandList, const ColorRGBA &Color);
 
 	std::optional<CRenderLayerTile::CTileLayerVisuals> m_VisualTiles;
 	CMapItemLayerTilemap *m_pLayerTilemap;
@@ -236,7 +235,7 @@ public:
 	void Unload() override;
 
 protected:
-	IGraphics::CTextureHandle GetTexture() const override { return m_TextureHandle; }
+	IGraphics::CTextureHandle GetTexture() const override;
 
 	class CQuadLayerVisuals : public CRenderComponent
 	{
@@ -274,9 +273,6 @@ protected:
 
 	std::vector<CQuadCluster> m_vQuadClusters;
 	CQuad *m_pQuads;
-
-private:
-	IGraphics::CTextureHandle m_TextureHandle;
 };
 
 class CRenderLayerEntityBase : public CRenderLayerTile
@@ -298,7 +294,7 @@ public:
 	void Init() override;
 
 protected:
-	void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
+	void RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 
 private:
@@ -322,7 +318,7 @@ public:
 	void Unload() override;
 
 protected:
-	void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
+	void RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void GetTileData(unsigned char *pIndex, unsigned char *pFlags, int *pAngleRotate, unsigned int x, unsigned int y, int CurOverlay) const override;
 
@@ -341,7 +337,7 @@ public:
 	void Unload() override;
 
 protected:
-	void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
+	void RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void GetTileData(unsigned char *pIndex, unsigned char *pFlags, int *pAngleRotate, unsigned int x, unsigned int y, int CurOverlay) const override;
 	IGraphics::CTextureHandle GetTexture() const override;
@@ -362,7 +358,7 @@ public:
 	void Unload() override;
 
 protected:
-	void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
+	void RenderTileLayerWithTileBuffer(IGraphicsCommandList *pCommandList, const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params) override;
 	void GetTileData(unsigned char *pIndex, unsigned char *pFlags, int *pAngleRotate, unsigned int x, unsigned int y, int CurOverlay) const override;
 	IGraphics::CTextureHandle GetTexture() const override;
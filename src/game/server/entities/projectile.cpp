@@ -419,6 +419,15 @@ void CProjectile::Snap(int SnappingClient)
 	}
 }
 
+bool CProjectile::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	// same position as the one Snap checks
+	const vec2 Pos = GetPos((Server()->Tick() - m_StartTick) / (float)Server()->TickSpeed());
+	*pMin = Pos;
+	*pMax = Pos;
+	return true;
+}
+
 void CProjectile::SwapClients(int Client1, int Client2)
 {
 	m_Owner = m_Owner == Client1 ? Client2 : (m_Owner == Client2 ? Client1 : m_Owner);
@@ -33,6 +33,7 @@ public:
 	void Tick() override;
 	void TickPaused() override;
 	void Snap(int SnappingClient) override;
+	bool GetSnapBounds(vec2 *pMin, vec2 *pMax) override;
 	void SwapClients(int Client1, int Client2) override;
 
 private:
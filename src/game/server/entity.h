@@ -25,6 +25,8 @@ private:
 	friend CGameWorld; // entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	CSpatialGrid<CEntity>::CNode m_GridNode;
+	CGameWorld::CSnapGrid::CNode m_SnapNode;
 
 	/* Identity */
 	CGameWorld *m_pGameWorld;
@@ -123,6 +125,23 @@ public: // TODO: Maybe make protected
 	*/
 	virtual void Snap(int SnappingClient) {}
 
+	/*
+		Function: GetSnapBounds
+			Called once per snapshot tick to find out which clients
+			can see the entity. Snap is only called for clients whose
+			view intersects the returned box, so it has to contain
+			every position Snap checks with NetworkClipped. Entities
+			that return false are snapped for every client.
+
+		Arguments:
+			pMin - Receives the top left corner of the box.
+			pMax - Receives the bottom right corner of the box.
+
+		Returns:
+			Whether the entity can be culled by its bounds.
+	*/
+	virtual bool GetSnapBounds(vec2 *pMin, vec2 *pMax) { return false; }
+
 	/*
 		Function: SwapClients
 			Called when two players have swapped their client ids.
@@ -26,6 +26,7 @@
 #include <engine/engine.h>
 #include <engine/map.h>
 #include <engine/server/server.h>
+#include <engine/shared/compressed_stream.h>
 #include <engine/shared/config.h>
 #include <engine/shared/datafile.h>
 #include <engine/shared/json.h>
@@ -4272,7 +4273,8 @@ void CGameContext::OnInit(const void *pPersistentData)
 		FormatUuid(m_GameUuid, aGameUuid, sizeof(aGameUuid));
 
 		char aFilename[IO_MAX_PATH_LENGTH];
-		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aGameUuid);
+		const int Compression = g_Config.m_SvTeeHistorianCompression;
+		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian%s", aGameUuid, Compression ? ".z" : "");
 
 		IOHANDLE THFile = Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 		if(!THFile)
@@ -4285,7 +4287,16 @@ void CGameContext::OnInit(const void *pPersistentData)
 		{
 			dbg_msg("teehistorian", "recording to '%s'", aFilename);
 		}
-		m_pTeeHistorianFile = aio_new(THFile);
+		if(Compression)
+		{
+			// compressed on the writing thread, the tick never waits for zlib
+			m_pTeeHistorianCompressor = std::make_unique<CCompressedStreamWriter>(Compression);
+			m_pTeeHistorianFile = aio_new_encoded(THFile, CCompressedStreamWriter::AioEncoder, m_pTeeHistorianCompressor.get());
+		}
+		else
+		{
+			m_pTeeHistorianFile = aio_new(THFile);
+		}
 
 		char aVersion[128];
 		if(GIT_SHORTREV_HASH)
@@ -4309,6 +4320,7 @@ void CGameContext::OnInit(const void *pPersistentData)
 		GameInfo.m_pConfig = &g_Config;
 		GameInfo.m_pTuning = GlobalTuning();
 		GameInfo.m_pUuids = &g_UuidManager;
+		GameInfo.m_Index = g_Config.m_SvTeeHistorianIndex;
 
 		GameInfo.m_pMapName = Map()->BaseName();
 		GameInfo.m_MapSize = Map()->Size();
@@ -4609,6 +4621,7 @@ void CGameContext::OnShutdown(void *pPersistentData)
 			Server()->SetErrorShutdown("teehistorian close error");
 		}
 		aio_free(m_pTeeHistorianFile);
+		m_pTeeHistorianCompressor = nullptr;
 	}
 
 	// Stop any demos being recorded.
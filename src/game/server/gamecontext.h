@@ -47,6 +47,7 @@
 */
 
 class CCharacter;
+class CCompressedStreamWriter;
 class IConfigManager;
 class CConfig;
 class CHeap;
@@ -129,6 +130,7 @@ class CGameContext : public IGameServer
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
 	ASYNCIO *m_pTeeHistorianFile;
+	std::unique_ptr<CCompressedStreamWriter> m_pTeeHistorianCompressor;
 	CUuid m_GameUuid;
 	CMapBugs m_MapBugs;
 	CPrng m_Prng;
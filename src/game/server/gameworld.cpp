@@ -7,12 +7,15 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include "gamecontroller.h"
+#include "player.h"
 
 #include <engine/shared/config.h>
 
 #include <game/collision.h>
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <utility>
 
 //////////////////////////////////////////////////
@@ -28,6 +31,8 @@ CGameWorld::CGameWorld()
 	m_ResetRequested = false;
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		pFirstEntityType = nullptr;
+	for(auto &InsertOrder : m_aInsertOrder)
+		InsertOrder = 0;
 }
 
 CGameWorld::~CGameWorld()
@@ -56,23 +61,68 @@ CEntity *CGameWorld::FindFirst(int Type)
 	return Type < 0 || Type >= NUM_ENTTYPES ? nullptr : m_apFirstEntityTypes[Type];
 }
 
+void CGameWorld::UpdateGridPosition(CEntity *pEnt)
+{
+	m_aGrids[pEnt->m_ObjType].Move(&pEnt->m_GridNode, pEnt->m_Pos, pEnt->m_ProximityRadius);
+}
+
+void CGameWorld::SyncGrid(int Type)
+{
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		UpdateGridPosition(pEnt);
+}
+
+void CGameWorld::UpdateTickingEntity()
+{
+	// reset by RemoveEntity if the entity was removed during its tick
+	if(m_pTickingEntity)
+		UpdateGridPosition(m_pTickingEntity);
+	m_pTickingEntity = nullptr;
+}
+
+template<class F>
+void CGameWorld::ForEachEntityNear(int Type, vec2 Min, vec2 Max, F &&Callback)
+{
+	// entity positions are also changed outside of the world tick, e.g. by
+	// commands or when loading a save
+	if(!m_Ticking)
+		SyncGrid(Type);
+
+	// the callbacks might run queries themselves
+	std::vector<const CSpatialGrid<CEntity>::CNode *> vpCandidates;
+	std::swap(vpCandidates, m_vpQueryCandidates);
+	vpCandidates.clear();
+	if(!m_aGrids[Type].Collect(Min, Max, vpCandidates))
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			vpCandidates.push_back(&pEnt->m_GridNode);
+	}
+
+	for(const auto *pNode : vpCandidates)
+	{
+		if(!Callback(pNode->m_pEntity))
+			break;
+	}
+	std::swap(vpCandidates, m_vpQueryCandidates);
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
-	{
+	ForEachEntityNear(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius), [&](CEntity *pEnt) {
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
 			if(ppEnts)
 				ppEnts[Num] = pEnt;
 			Num++;
 			if(Num == Max)
-				break;
+				return false;
 		}
-	}
+		return true;
+	});
 
 	return Num;
 }
@@ -90,10 +140,16 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = nullptr;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	m_aGrids[pEnt->m_ObjType].Insert(&pEnt->m_GridNode, pEnt, ++m_aInsertOrder[pEnt->m_ObjType], pEnt->m_Pos, pEnt->m_ProximityRadius);
+	m_SnapGridTick = -1;
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
 {
+	if(m_pTickingEntity == pEnt)
+		m_pTickingEntity = nullptr;
+
 	// not in the list
 	if(!pEnt->m_pNextTypeEntity && !pEnt->m_pPrevTypeEntity && m_apFirstEntityTypes[pEnt->m_ObjType] != pEnt)
 		return;
@@ -112,29 +168,85 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
+
+	m_aGrids[pEnt->m_ObjType].Remove(&pEnt->m_GridNode);
+	m_aSnapGrids[pEnt->m_ObjType].Remove(&pEnt->m_SnapNode);
+	m_SnapGridTick = -1;
 }
 
-//
-void CGameWorld::Snap(int SnappingClient)
+void CGameWorld::UpdateSnapGrids()
+{
+	// all clients are snapped in the same tick, only rebuild for the first one
+	if(m_SnapGridTick == Server()->Tick())
+		return;
+	m_SnapGridTick = Server()->Tick();
+
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		m_avpSnapUnbounded[Type].clear();
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			vec2 Min, Max;
+			// NetworkClipped never clips positions that are not finite
+			if(pEnt->GetSnapBounds(&Min, &Max) && std::isfinite(Min.x) && std::isfinite(Min.y) && std::isfinite(Max.x) && std::isfinite(Max.y))
+			{
+				const vec2 Center = (Min + Max) / 2.0f;
+				// a bit of slack against rounding of the center
+				const float Radius = maximum(Max.x - Min.x, Max.y - Min.y) / 2.0f + 1.0f;
+				if(pEnt->m_SnapNode.Inserted())
+					m_aSnapGrids[Type].Move(&pEnt->m_SnapNode, Center, Radius);
+				else
+					m_aSnapGrids[Type].Insert(&pEnt->m_SnapNode, pEnt, pEnt->m_GridNode.m_Order, Center, Radius);
+			}
+			else
+			{
+				m_aSnapGrids[Type].Remove(&pEnt->m_SnapNode);
+				pEnt->m_SnapNode.m_pEntity = pEnt;
+				pEnt->m_SnapNode.m_Order = pEnt->m_GridNode.m_Order;
+				m_avpSnapUnbounded[Type].push_back(&pEnt->m_SnapNode);
+			}
+		}
+	}
+}
+
+void CGameWorld::SnapType(int Type, int SnappingClient)
 {
-	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
+	const CPlayer *pPlayer = SnappingClient == SERVER_DEMO_CLIENT ? nullptr : GameServer()->m_apPlayers[SnappingClient];
+	if(pPlayer && !pPlayer->m_ShowAll && std::isfinite(pPlayer->m_ViewPos.x) && std::isfinite(pPlayer->m_ViewPos.y))
+	{
+		// the same box NetworkClipped checks against
+		m_vpSnapCandidates.clear();
+		if(m_aSnapGrids[Type].Collect(pPlayer->m_ViewPos - pPlayer->m_ShowDistance, pPlayer->m_ViewPos + pPlayer->m_ShowDistance, m_vpSnapCandidates))
+		{
+			m_vpSnapVisible.clear();
+			std::merge(m_vpSnapCandidates.begin(), m_vpSnapCandidates.end(), m_avpSnapUnbounded[Type].begin(), m_avpSnapUnbounded[Type].end(), std::back_inserter(m_vpSnapVisible), [](const CSnapGrid::CNode *pA, const CSnapGrid::CNode *pB) {
+				return pA->m_Order > pB->m_Order;
+			});
+			for(const auto *pNode : m_vpSnapVisible)
+				pNode->m_pEntity->Snap(SnappingClient);
+			return;
+		}
+	}
+
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt;)
 	{
 		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 		pEnt->Snap(SnappingClient);
 		pEnt = m_pNextTraverseEntity;
 	}
+}
 
+//
+void CGameWorld::Snap(int SnappingClient)
+{
+	UpdateSnapGrids();
+
+	SnapType(ENTTYPE_CHARACTER, SnappingClient);
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 	{
 		if(i == ENTTYPE_CHARACTER)
 			continue;
-
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
-		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
-			pEnt = m_pNextTraverseEntity;
-		}
+		SnapType(i, SnappingClient);
 	}
 }
 
@@ -205,6 +317,10 @@ void CGameWorld::Tick()
 	if(m_ResetRequested)
 		Reset();
 
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		SyncGrid(i);
+	m_Ticking = true;
+
 	if(!m_Paused)
 	{
 		// update all objects
@@ -218,7 +334,9 @@ void CGameWorld::Tick()
 				for(; pEnt;)
 				{
 					m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+					m_pTickingEntity = pEnt;
 					((CCharacter *)pEnt)->PreTick();
+					UpdateTickingEntity();
 					pEnt = m_pNextTraverseEntity;
 				}
 			}
@@ -227,7 +345,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickingEntity = pEnt;
 				pEnt->Tick();
+				UpdateTickingEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -236,7 +356,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickingEntity = pEnt;
 				pEnt->TickDeferred();
+				UpdateTickingEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 	}
@@ -247,11 +369,15 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickingEntity = pEnt;
 				pEnt->TickPaused();
+				UpdateTickingEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 	}
 
+	m_Ticking = false;
+
 	RemoveEntities();
 
 	// find the characters' strong/weak id
@@ -297,20 +423,23 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Type, vec2 &NewPos, const CEntity *pNotThis, int CollideWith, const CEntity *pThisOnly)
 {
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x) - Radius, minimum(Pos0.y, Pos1.y) - Radius);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x) + Radius, maximum(Pos0.y, Pos1.y) + Radius);
+	ForEachEntityNear(Type, Min, Max, [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return true;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return true;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return true;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -327,7 +456,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+		return true;
+	});
 
 	return pClosest;
 }
@@ -338,11 +468,9 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 	float ClosestRange = Radius * 2;
 	CCharacter *pClosest = nullptr;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
-	{
+	ForEachEntityNear(ENTTYPE_CHARACTER, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius), [&](CEntity *p) {
 		if(p == pNotThis)
-			continue;
+			return true;
 
 		float Len = distance(Pos, p->m_Pos);
 		if(Len < p->m_ProximityRadius + Radius)
@@ -350,10 +478,11 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 			if(Len < ClosestRange)
 			{
 				ClosestRange = Len;
-				pClosest = p;
+				pClosest = (CCharacter *)p;
 			}
 		}
-	}
+		return true;
+	});
 
 	return pClosest;
 }
@@ -361,11 +490,11 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x) - Radius, minimum(Pos0.y, Pos1.y) - Radius);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x) + Radius, maximum(Pos0.y, Pos1.y) + Radius);
+	ForEachEntityNear(ENTTYPE_CHARACTER, Min, Max, [&](CEntity *pChr) {
 		if(pChr == pNotThis)
-			continue;
+			return true;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
@@ -373,10 +502,11 @@ std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1
 			float Len = distance(pChr->m_Pos, IntersectPos);
 			if(Len < pChr->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pChr);
 			}
 		}
-	}
+		return true;
+	});
 	return vpCharacters;
 }
 
@@ -6,7 +6,9 @@
 #include "save.h"
 
 #include <game/gamecore.h>
+#include <game/spatial_grid.h>
 
+#include <cstdint>
 #include <vector>
 
 class CCollision;
@@ -31,6 +33,9 @@ public:
 		NUM_ENTTYPES
 	};
 
+	// coarse cells, the boxes checked in Snap span the whole view of a client
+	typedef CSpatialGrid<CEntity, 1024> CSnapGrid;
+
 private:
 	void Reset();
 	void RemoveEntities();
@@ -38,6 +43,31 @@ private:
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// entity positions by type, the lists above stay authoritative for the order
+	CSpatialGrid<CEntity> m_aGrids[NUM_ENTTYPES];
+	int64_t m_aInsertOrder[NUM_ENTTYPES];
+	std::vector<const CSpatialGrid<CEntity>::CNode *> m_vpQueryCandidates;
+	// entity whose tick is running, its grid position is updated afterwards
+	CEntity *m_pTickingEntity = nullptr;
+	bool m_Ticking = false;
+
+	void UpdateGridPosition(CEntity *pEnt);
+	void SyncGrid(int Type);
+	void UpdateTickingEntity();
+	template<class F>
+	void ForEachEntityNear(int Type, vec2 Min, vec2 Max, F &&Callback);
+
+	// snap bounds of the entities, rebuilt once per snapshot tick
+	CSnapGrid m_aSnapGrids[NUM_ENTTYPES];
+	// entities without snap bounds, in list order
+	std::vector<const CSnapGrid::CNode *> m_avpSnapUnbounded[NUM_ENTTYPES];
+	std::vector<const CSnapGrid::CNode *> m_vpSnapCandidates;
+	std::vector<const CSnapGrid::CNode *> m_vpSnapVisible;
+	int m_SnapGridTick = -1;
+
+	void UpdateSnapGrids();
+	void SnapType(int Type, int SnappingClient);
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -35,26 +35,83 @@ std::shared_ptr<CScorePlayerResult> CScore::NewSqlPlayerResult(int ClientId)
 	return pCurPlayer->m_ScoreQueryResult;
 }
 
-void CScore::ExecPlayerThread(
-	bool (*pFuncPtr)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
-	const char *pThreadName,
-	int ClientId,
-	const char *pName,
-	int Offset)
+std::unique_ptr<CSqlPlayerRequest> CScore::NewPlayerRequest(int ClientId, const char *pName, int Offset)
 {
 	auto pResult = NewSqlPlayerResult(ClientId);
 	if(pResult == nullptr)
-		return;
+		return nullptr;
 	auto Tmp = std::make_unique<CSqlPlayerRequest>(pResult);
 	str_copy(Tmp->m_aName, pName, sizeof(Tmp->m_aName));
 	str_copy(Tmp->m_aMap, GameServer()->Map()->BaseName(), sizeof(Tmp->m_aMap));
 	str_copy(Tmp->m_aServer, g_Config.m_SvSqlServerName, sizeof(Tmp->m_aServer));
 	str_copy(Tmp->m_aRequestingPlayer, Server()->ClientName(ClientId), sizeof(Tmp->m_aRequestingPlayer));
 	Tmp->m_Offset = Offset;
+	return Tmp;
+}
 
+void CScore::ExecPlayerThread(
+	bool (*pFuncPtr)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
+	const char *pThreadName,
+	int ClientId,
+	const char *pName,
+	int Offset)
+{
+	auto Tmp = NewPlayerRequest(ClientId, pName, Offset);
+	if(Tmp == nullptr)
+		return;
 	m_pPool->Execute(pFuncPtr, std::move(Tmp), pThreadName);
 }
 
+void CScore::ExecRankCache(
+	void (CRankCache::*pFuncPtr)(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const,
+	int ClientId,
+	const char *pName,
+	int Offset)
+{
+	auto Tmp = NewPlayerRequest(ClientId, pName, Offset);
+	if(Tmp == nullptr)
+		return;
+	// processed by the player on the next tick like a finished query
+	auto *pResult = static_cast<CScorePlayerResult *>(Tmp->m_pResult.get());
+	(m_RankCache.*pFuncPtr)(Tmp.get(), pResult);
+	pResult->m_Success = true;
+	pResult->m_Completed = true;
+}
+
+bool CScore::RankCacheReady()
+{
+	if(m_pRankCacheResult != nullptr && m_pRankCacheResult->m_Completed)
+	{
+		if(m_pRankCacheResult->m_Success)
+		{
+			// finishes saved in the meantime are already in the cache
+			// and might also be in the result, which doesn't matter
+			for(const CScoreRankCacheResult::CFinish &Finish : m_pRankCacheResult->m_vFinishes)
+				m_RankCache.AddFinish(Finish.m_aName, Finish.m_aServer, Finish.m_Time);
+			m_RankCacheLoaded = true;
+		}
+		m_pRankCacheResult = nullptr;
+	}
+	// the regional ranking depends on the server name
+	return g_Config.m_SvRankCache && m_RankCacheLoaded && str_comp(m_RankCache.Region(), g_Config.m_SvSqlServerName) == 0;
+}
+
+void CScore::LoadRankCache()
+{
+	if(m_pRankCacheResult)
+		return; // already in progress
+
+	m_RankCache.Reset(g_Config.m_SvSqlServerName);
+	m_RankCacheLoaded = false;
+	if(!g_Config.m_SvRankCache)
+		return;
+
+	m_pRankCacheResult = std::make_shared<CScoreRankCacheResult>();
+	auto Tmp = std::make_unique<CSqlRankCacheRequest>(m_pRankCacheResult);
+	str_copy(Tmp->m_aMap, GameServer()->Map()->BaseName(), sizeof(Tmp->m_aMap));
+	m_pPool->Execute(CScoreWorker::LoadRankCache, std::move(Tmp), "load rank cache");
+}
+
 bool CScore::RateLimitPlayer(int ClientId)
 {
 	CPlayer *pPlayer = GameServer()->m_apPlayers[ClientId];
@@ -139,6 +196,8 @@ void CScore::LoadMapInfo()
 	str_copy(Tmp->m_aName, GameServer()->Map()->BaseName(), sizeof(Tmp->m_aName));
 	Tmp->m_aRequestingPlayer[0] = '\0'; // no player, so no "your time" in result
 	m_pPool->Execute(CScoreWorker::MapInfo, std::move(Tmp), "load map info");
+
+	LoadRankCache();
 }
 
 void CScore::LoadPlayerData(int ClientId, const char *pName)
@@ -187,6 +246,7 @@ void CScore::SaveScore(int ClientId, int TimeTicks, const char *pTimestamp, cons
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
+	m_RankCache.AddFinish(Tmp->m_aName, g_Config.m_SvSqlServerName, Tmp->m_Time);
 	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
 }
 
@@ -220,7 +280,10 @@ void CScore::ShowRank(int ClientId, const char *pName)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientId, pName, 0);
+	if(RankCacheReady())
+		ExecRankCache(&CRankCache::ShowRank, ClientId, pName, 0);
+	else
+		ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientId, pName, 0);
 }
 
 void CScore::ShowTeamRank(int ClientId, const char *pName)
@@ -234,7 +297,10 @@ void CScore::ShowTop(int ClientId, int Offset)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientId, "", Offset);
+	if(RankCacheReady())
+		ExecRankCache(&CRankCache::ShowTop, ClientId, "", Offset);
+	else
+		ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientId, "", Offset);
 }
 
 void CScore::ShowTeamTop5(int ClientId, int Offset)
@@ -25,8 +25,24 @@ class CScore
 	CPrng m_Prng;
 	void GeneratePassphrase(char *pBuf, int BufSize);
 
+	// /rank and /top5 of the current map, loaded together with the map info
+	CRankCache m_RankCache;
+	std::shared_ptr<CScoreRankCacheResult> m_pRankCacheResult;
+	bool m_RankCacheLoaded = false;
+	// returns true if /rank and /top5 can be answered from m_RankCache
+	bool RankCacheReady();
+	void LoadRankCache();
+
 	// returns new SqlResult bound to the player, if no current Thread is active for this player
 	std::shared_ptr<CScorePlayerResult> NewSqlPlayerResult(int ClientId);
+	// returns nullptr if a request of the player is still in progress
+	std::unique_ptr<CSqlPlayerRequest> NewPlayerRequest(int ClientId, const char *pName, int Offset);
+	// answers a request without a database query
+	void ExecRankCache(
+		void (CRankCache::*pFuncPtr)(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const,
+		int ClientId,
+		const char *pName,
+		int Offset);
 	// Creates for player database requests
 	void ExecPlayerThread(
 		bool (*pFuncPtr)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
@@ -11,6 +11,7 @@
 #include <engine/server/sql_string_helpers.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <cmath>
 
 // "6b407e81-8b77-3e04-a207-8da17f37d000"
@@ -174,6 +175,36 @@ bool CScoreWorker::LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+bool CScoreWorker::LoadRankCache(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlRankCacheRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CScoreRankCacheResult *>(pGameData->m_pResult.get());
+
+	char aBuf[512];
+	// finishes without server aren't ranked by /rank and /top5 either
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, Server, MIN(Time) "
+		"FROM %s_race "
+		"WHERE Map = ? AND Server IS NOT NULL "
+		"GROUP BY Name, Server",
+		pSqlServer->GetPrefix());
+	if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	{
+		return false;
+	}
+	pSqlServer->BindString(1, pData->m_aMap);
+
+	bool End;
+	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
+	{
+		CScoreRankCacheResult::CFinish &Finish = pResult->m_vFinishes.emplace_back();
+		pSqlServer->GetString(1, Finish.m_aName, sizeof(Finish.m_aName));
+		pSqlServer->GetString(2, Finish.m_aServer, sizeof(Finish.m_aServer));
+		Finish.m_Time = pSqlServer->GetFloat(3);
+	}
+	return End;
+}
+
 // update stuff
 bool CScoreWorker::LoadPlayerData(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
@@ -822,6 +853,58 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
+// shared by CScoreWorker::ShowRank and CRankCache::ShowRank
+static void FormatRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult, int Rank, float Time, float PercentRank, const char *pRegionalRank)
+{
+	char aTime[32];
+	str_time_float(Time, ETimeFormat::HOURS_CENTISECS, aTime, sizeof(aTime));
+
+	if(g_Config.m_SvHideScore)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"Your time: %s", aTime);
+	}
+	else
+	{
+		pResult->m_MessageKind = CScorePlayerResult::ALL;
+		// CEIL and FLOOR are not supported in SQLite
+		int BetterThanPercent = std::floor(100.0f - 100.0f * PercentRank);
+
+		if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
+		{
+			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+				"%s - %s - better than %d%%",
+				pData->m_aName, aTime, BetterThanPercent);
+		}
+		else
+		{
+			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+				"%s - %s - better than %d%% - requested by %s",
+				pData->m_aName, aTime, BetterThanPercent, pData->m_aRequestingPlayer);
+		}
+
+		if(g_Config.m_SvRegionalRankings)
+		{
+			str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+				"Global rank %d - %s %s",
+				Rank, pData->m_aServer, pRegionalRank);
+		}
+		else
+		{
+			str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+				"Global rank %d", Rank);
+		}
+	}
+}
+
+// shared by CScoreWorker::ShowTop and CRankCache::ShowTop
+static void FormatTopLine(char *pMessage, int MessageSize, int Rank, const char *pName, float Time)
+{
+	char aTime[32];
+	str_time_float(Time, ETimeFormat::HOURS_CENTISECS, aTime, sizeof(aTime));
+	str_format(pMessage, MessageSize, "%d. %s Time: %s", Rank, pName, aTime);
+}
+
 bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -886,46 +969,7 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 
 	if(!End)
 	{
-		int Rank = pSqlServer->GetInt(1);
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, ETimeFormat::HOURS_CENTISECS, aBuf, sizeof(aBuf));
-
-		if(g_Config.m_SvHideScore)
-		{
-			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-				"Your time: %s", aBuf);
-		}
-		else
-		{
-			pResult->m_MessageKind = CScorePlayerResult::ALL;
-			// CEIL and FLOOR are not supported in SQLite
-			int BetterThanPercent = std::floor(100.0f - 100.0f * pSqlServer->GetFloat(3));
-
-			if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%%",
-					pData->m_aName, aBuf, BetterThanPercent);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%% - requested by %s",
-					pData->m_aName, aBuf, BetterThanPercent, pData->m_aRequestingPlayer);
-			}
-
-			if(g_Config.m_SvRegionalRankings)
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d - %s %s",
-					Rank, pData->m_aServer, aRegionalRank);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d", Rank);
-			}
-		}
+		FormatRank(pData, pResult, pSqlServer->GetInt(1), pSqlServer->GetFloat(2), pSqlServer->GetFloat(3), aRegionalRank);
 	}
 	else
 	{
@@ -1058,18 +1102,14 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
 	Line++;
 
-	char aTime[32];
 	bool End = false;
 
 	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, ETimeFormat::HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 
 		Line++;
 	}
@@ -1100,11 +1140,8 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, ETimeFormat::HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
@@ -1941,3 +1978,124 @@ bool CScoreWorker::GetSaves(IDbConnection *pSqlServer, const ISqlData *pGameData
 	}
 	return true;
 }
+
+CRankCache::CRankCache()
+{
+	Reset("");
+}
+
+void CRankCache::Reset(const char *pRegion)
+{
+	str_copy(m_aRegion, pRegion);
+	m_Global.Clear();
+	m_Regional.Clear();
+}
+
+void CRankCache::AddFinish(const char *pName, const char *pServer, float Time)
+{
+	// the time is stored with two decimals in the database
+	Time = (float)(std::round(Time * 100.0) / 100.0);
+	m_Global.Add(pName, Time);
+	// same as `Server LIKE %Region%`
+	if(str_find_nocase(pServer, m_aRegion))
+	{
+		m_Regional.Add(pName, Time);
+	}
+}
+
+void CRankCache::ShowRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const
+{
+	int Rank;
+	float Time;
+	float PercentRank;
+	char aRegionalRank[16];
+	if(m_Regional.Rank(pData->m_aName, &Rank, &Time, &PercentRank))
+	{
+		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", Rank);
+	}
+	else
+	{
+		str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
+	}
+
+	if(m_Global.Rank(pData->m_aName, &Rank, &Time, &PercentRank))
+	{
+		FormatRank(pData, pResult, Rank, Time, PercentRank, aRegionalRank);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s is not ranked", pData->m_aName);
+	}
+}
+
+void CRankCache::ShowTop(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const
+{
+	int Line = 0;
+	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+	Line++;
+	m_Global.Top(pData->m_Offset, 5, pResult->m_Data.m_aaMessages, &Line);
+
+	if(!g_Config.m_SvRegionalRankings)
+	{
+		str_copy(pResult->m_Data.m_aaMessages[Line], "-----------------------------------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+		return;
+	}
+
+	str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+		"------------ %s Top ------------", pData->m_aServer);
+	Line++;
+	m_Regional.Top(pData->m_Offset, 3, pResult->m_Data.m_aaMessages, &Line);
+}
+
+void CRankCache::CRanking::Clear()
+{
+	m_BestTimes.clear();
+	m_vSorted.clear();
+}
+
+void CRankCache::CRanking::Add(const char *pName, float Time)
+{
+	auto [It, Inserted] = m_BestTimes.emplace(pName, Time);
+	if(!Inserted)
+	{
+		if(It->second <= Time)
+		{
+			return;
+		}
+		m_vSorted.erase(std::lower_bound(m_vSorted.begin(), m_vSorted.end(), std::make_pair(It->second, It->first)));
+		It->second = Time;
+	}
+	auto Entry = std::make_pair(Time, It->first);
+	m_vSorted.insert(std::upper_bound(m_vSorted.begin(), m_vSorted.end(), Entry), std::move(Entry));
+}
+
+bool CRankCache::CRanking::Rank(const char *pName, int *pRank, float *pTime, float *pPercentRank) const
+{
+	auto It = m_BestTimes.find(pName);
+	if(It == m_BestTimes.end())
+	{
+		return false;
+	}
+	// players with the same time share the rank, like RANK() in SQL
+	*pRank = 1 + (std::lower_bound(m_vSorted.begin(), m_vSorted.end(), std::make_pair(It->second, std::string())) - m_vSorted.begin());
+	*pTime = It->second;
+	// PERCENT_RANK() in SQL
+	const int NumPlayers = m_vSorted.size();
+	*pPercentRank = NumPlayers > 1 ? (float)((double)(*pRank - 1) / (NumPlayers - 1)) : 0.0f;
+	return true;
+}
+
+void CRankCache::CRanking::Top(int Offset, int Num, char (*paMessages)[512], int *pLine) const
+{
+	// same as `ORDER BY Ranking ASC/DESC LIMIT Start, Num`
+	const int Start = maximum(absolute(Offset) - 1, 0);
+	const int NumPlayers = m_vSorted.size();
+	for(int i = Start; i < minimum(Start + Num, NumPlayers); i++)
+	{
+		const auto &[Time, Name] = m_vSorted[Offset >= 0 ? i : NumPlayers - 1 - i];
+		const int Rank = 1 + (std::lower_bound(m_vSorted.begin(), m_vSorted.end(), std::make_pair(Time, std::string())) - m_vSorted.begin());
+		FormatTopLine(paMessages[*pLine], sizeof(paMessages[*pLine]), Rank, Name.c_str(), Time);
+		(*pLine)++;
+	}
+}
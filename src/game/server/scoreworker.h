@@ -14,6 +14,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -82,6 +83,29 @@ struct CSqlLoadBestTimeRequest : ISqlData
 	char m_aMap[MAX_MAP_LENGTH];
 };
 
+struct CScoreRankCacheResult : ISqlResult
+{
+	struct CFinish
+	{
+		char m_aName[MAX_NAME_LENGTH];
+		char m_aServer[5];
+		float m_Time;
+	};
+	// best time of each player on each server
+	std::vector<CFinish> m_vFinishes;
+};
+
+struct CSqlRankCacheRequest : ISqlData
+{
+	CSqlRankCacheRequest(std::shared_ptr<CScoreRankCacheResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	// current map
+	char m_aMap[MAX_MAP_LENGTH];
+};
+
 struct CSqlPlayerRequest : ISqlData
 {
 	CSqlPlayerRequest(std::shared_ptr<CScorePlayerResult> pResult) :
@@ -289,9 +313,50 @@ struct CTeamrank
 	static bool GetSqlTop5Team(IDbConnection *pSqlServer, bool *pEnd, char *pError, int ErrorSize, char (*paMessages)[512], int *StartLine, int Count);
 };
 
+// Best times of all players on the current map, so /rank and /top5 can be
+// answered without a database query. The messages are the same as the ones
+// of CScoreWorker::ShowRank and CScoreWorker::ShowTop.
+class CRankCache
+{
+public:
+	CRankCache();
+
+	// finishes on servers containing pRegion are also ranked regionally
+	void Reset(const char *pRegion);
+	const char *Region() const { return m_aRegion; }
+	// only the best time of each player is kept, so adding a finish more than
+	// once has no effect
+	void AddFinish(const char *pName, const char *pServer, float Time);
+
+	void ShowRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const;
+	void ShowTop(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult) const;
+
+private:
+	class CRanking
+	{
+	public:
+		void Clear();
+		void Add(const char *pName, float Time);
+		// returns false if the player has no time
+		bool Rank(const char *pName, int *pRank, float *pTime, float *pPercentRank) const;
+		// formats Num lines starting at Offset like /top5 does
+		void Top(int Offset, int Num, char (*paMessages)[512], int *pLine) const;
+
+	private:
+		std::unordered_map<std::string, float> m_BestTimes;
+		// sorted by time, then by name
+		std::vector<std::pair<float, std::string>> m_vSorted;
+	};
+
+	char m_aRegion[5];
+	CRanking m_Global;
+	CRanking m_Regional;
+};
+
 struct CScoreWorker
 {
 	static bool LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+	static bool LoadRankCache(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
 	static bool RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool RandomUnfinishedMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
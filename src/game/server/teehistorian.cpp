@@ -1,5 +1,6 @@
 #include "teehistorian.h"
 
+#include <base/bytes.h>
 #include <base/dbg.h>
 #include <base/mem.h>
 #include <base/str.h>
@@ -25,7 +26,7 @@ private:
 };
 
 static const char TEEHISTORIAN_NAME[] = "teehistorian@ddnet.tw";
-static const CUuid TEEHISTORIAN_UUID = CalculateUuid(TEEHISTORIAN_NAME);
+const CUuid TEEHISTORIAN_UUID = CalculateUuid(TEEHISTORIAN_NAME);
 static const char TEEHISTORIAN_VERSION[] = "2";
 static const char TEEHISTORIAN_VERSION_MINOR[] = "20";
 
@@ -33,21 +34,7 @@ static const char TEEHISTORIAN_VERSION_MINOR[] = "20";
 #include <engine/shared/teehistorian_ex_chunks.h>
 #undef UUID
 
-enum
-{
-	TEEHISTORIAN_NONE,
-	TEEHISTORIAN_FINISH,
-	TEEHISTORIAN_TICK_SKIP,
-	TEEHISTORIAN_PLAYER_NEW,
-	TEEHISTORIAN_PLAYER_OLD,
-	TEEHISTORIAN_INPUT_DIFF,
-	TEEHISTORIAN_INPUT_NEW,
-	TEEHISTORIAN_MESSAGE,
-	TEEHISTORIAN_JOIN,
-	TEEHISTORIAN_DROP,
-	TEEHISTORIAN_CONSOLE_COMMAND,
-	TEEHISTORIAN_EX,
-};
+const unsigned char CTeeHistorianIndex::MAGIC[MAGIC_SIZE] = {'T', 'H', 'I', 'N', 'D', 'E', 'X', '1'};
 
 CTeeHistorian::CTeeHistorian()
 {
@@ -83,6 +70,17 @@ void CTeeHistorian::Reset(const CGameInfo *pGameInfo, WRITE_CALLBACK pfnWriteCal
 	m_pfnWriteCallback = pfnWriteCallback;
 	m_pWriteCallbackUserdata = pUser;
 
+	m_Index = pGameInfo->m_Index;
+	m_Written = 0;
+	m_NextCheckpointTick = 0;
+	m_CheckpointInterval = CTeeHistorianIndex::CHECKPOINT_INTERVAL;
+	m_vvCheckpoints.clear();
+	m_vClientRanges.clear();
+	for(auto &ClientRange : m_aClientRange)
+	{
+		ClientRange = -1;
+	}
+
 	WriteHeader(pGameInfo);
 
 	m_State = STATE_START;
@@ -253,6 +251,12 @@ void CTeeHistorian::BeginTick(int Tick)
 		dbg_msg("teehistorian", "tick %d", Tick);
 	}
 
+	if(m_Index && Tick >= m_NextCheckpointTick)
+	{
+		WriteCheckpoint();
+		m_NextCheckpointTick = Tick + m_CheckpointInterval;
+	}
+
 	m_State = STATE_BEFORE_PLAYERS;
 }
 
@@ -396,9 +400,122 @@ void CTeeHistorian::RecordTeamPractice(int Team, bool Practice)
 
 void CTeeHistorian::Write(const void *pData, int DataSize)
 {
+	m_Written += DataSize;
 	m_pfnWriteCallback(pData, DataSize, m_pWriteCallbackUserdata);
 }
 
+void CTeeHistorian::WriteCheckpoint()
+{
+	// everything a reader needs to continue decoding at the current offset
+	CTeehistorianPacker Buffer;
+	Buffer.Reset();
+	Buffer.AddInt(m_Tick);
+	Buffer.AddInt(m_Written >> 32);
+	Buffer.AddInt(m_Written & 0xffffffffu);
+	Buffer.AddInt(m_LastWrittenTick);
+	Buffer.AddInt(m_MaxClientId);
+
+	int NumPlayers = 0;
+	for(const auto &Player : m_aPrevPlayers)
+	{
+		if(Player.m_Alive || Player.m_UniqueClientId != 0 || Player.m_Team != 0)
+		{
+			NumPlayers++;
+		}
+	}
+	Buffer.AddInt(NumPlayers);
+	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+	{
+		const CTeehistorianPlayer &Player = m_aPrevPlayers[ClientId];
+		if(!Player.m_Alive && Player.m_UniqueClientId == 0 && Player.m_Team == 0)
+		{
+			continue;
+		}
+		const int Flags = (Player.m_Alive ? CTeeHistorianIndex::PLAYERFLAG_ALIVE : 0) | (Player.m_UniqueClientId != 0 ? CTeeHistorianIndex::PLAYERFLAG_INPUT : 0);
+		Buffer.AddInt(ClientId);
+		Buffer.AddInt(Flags);
+		Buffer.AddInt(Player.m_Team);
+		if(Player.m_Alive)
+		{
+			Buffer.AddInt(Player.m_X);
+			Buffer.AddInt(Player.m_Y);
+		}
+		if(Player.m_UniqueClientId != 0)
+		{
+			for(size_t i = 0; i < sizeof(Player.m_Input) / sizeof(int32_t); i++)
+			{
+				Buffer.AddInt(((const int *)&Player.m_Input)[i]);
+			}
+		}
+	}
+	m_vvCheckpoints.emplace_back(Buffer.Data(), Buffer.Data() + Buffer.Size());
+
+	// keep the index bounded on long running servers by dropping every
+	// other checkpoint and spacing the following ones further apart
+	if(m_vvCheckpoints.size() >= (size_t)CTeeHistorianIndex::MAX_CHECKPOINTS)
+	{
+		for(size_t i = 1; i < m_vvCheckpoints.size() / 2; i++)
+		{
+			m_vvCheckpoints[i] = std::move(m_vvCheckpoints[2 * i]);
+		}
+		m_vvCheckpoints.resize(m_vvCheckpoints.size() / 2);
+		m_CheckpointInterval *= 2;
+	}
+}
+
+void CTeeHistorian::WriteIndex()
+{
+	std::vector<unsigned char> vIndex;
+	CTeehistorianPacker Buffer;
+	Buffer.Reset();
+	Buffer.AddInt(CTeeHistorianIndex::VERSION);
+	Buffer.AddInt(m_vvCheckpoints.size());
+	vIndex.insert(vIndex.end(), Buffer.Data(), Buffer.Data() + Buffer.Size());
+	for(const auto &vCheckpoint : m_vvCheckpoints)
+	{
+		vIndex.insert(vIndex.end(), vCheckpoint.begin(), vCheckpoint.end());
+	}
+
+	Buffer.Reset();
+	Buffer.AddInt(m_vClientRanges.size());
+	vIndex.insert(vIndex.end(), Buffer.Data(), Buffer.Data() + Buffer.Size());
+	for(const auto &ClientRange : m_vClientRanges)
+	{
+		Buffer.Reset();
+		Buffer.AddInt(ClientRange.m_ClientId);
+		Buffer.AddInt(ClientRange.m_JoinTick);
+		Buffer.AddInt(ClientRange.m_DropTick);
+		vIndex.insert(vIndex.end(), Buffer.Data(), Buffer.Data() + Buffer.Size());
+	}
+
+	unsigned char aTrailer[CTeeHistorianIndex::TRAILER_SIZE];
+	uint_to_bytes_be(aTrailer, vIndex.size());
+	mem_copy(aTrailer + 4, CTeeHistorianIndex::MAGIC, sizeof(CTeeHistorianIndex::MAGIC));
+	vIndex.insert(vIndex.end(), aTrailer, aTrailer + sizeof(aTrailer));
+
+	if(m_Debug)
+	{
+		dbg_msg("teehistorian", "index checkpoints=%d client_ranges=%d size=%d", (int)m_vvCheckpoints.size(), (int)m_vClientRanges.size(), (int)vIndex.size());
+	}
+	Write(vIndex.data(), vIndex.size());
+}
+
+void CTeeHistorian::BeginClientRange(int ClientId)
+{
+	EndClientRange(ClientId);
+	m_aClientRange[ClientId] = m_vClientRanges.size();
+	m_vClientRanges.push_back({ClientId, m_Tick, -1});
+}
+
+void CTeeHistorian::EndClientRange(int ClientId)
+{
+	if(m_aClientRange[ClientId] != -1)
+	{
+		m_vClientRanges[m_aClientRange[ClientId]].m_DropTick = m_Tick;
+		m_aClientRange[ClientId] = -1;
+	}
+}
+
 void CTeeHistorian::EnsureTickWritten()
 {
 	if(!m_TickWritten)
@@ -550,6 +667,7 @@ void CTeeHistorian::RecordPlayerJoin(int ClientId, int Protocol)
 	}
 
 	Write(Buffer.Data(), Buffer.Size());
+	BeginClientRange(ClientId);
 }
 
 void CTeeHistorian::RecordPlayerRejoin(int ClientId)
@@ -566,6 +684,7 @@ void CTeeHistorian::RecordPlayerRejoin(int ClientId)
 	}
 
 	WriteExtra(UUID_TEEHISTORIAN_PLAYER_REJOIN, Buffer.Data(), Buffer.Size());
+	BeginClientRange(ClientId);
 }
 
 void CTeeHistorian::RecordPlayerReady(int ClientId)
@@ -600,6 +719,7 @@ void CTeeHistorian::RecordPlayerDrop(int ClientId, const char *pReason)
 	}
 
 	Write(Buffer.Data(), Buffer.Size());
+	EndClientRange(ClientId);
 }
 
 void CTeeHistorian::RecordPlayerName(int ClientId, const char *pName)
@@ -891,4 +1011,9 @@ void CTeeHistorian::Finish()
 	}
 
 	Write(Buffer.Data(), Buffer.Size());
+
+	if(m_Index)
+	{
+		WriteIndex();
+	}
 }
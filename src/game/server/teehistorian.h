@@ -8,12 +8,66 @@
 
 #include <generated/protocol.h>
 
+#include <cstdint>
 #include <ctime>
+#include <vector>
 
 class CConfig;
 class CTuningParams;
 class CUuidManager;
 
+enum
+{
+	TEEHISTORIAN_NONE,
+	TEEHISTORIAN_FINISH,
+	TEEHISTORIAN_TICK_SKIP,
+	TEEHISTORIAN_PLAYER_NEW,
+	TEEHISTORIAN_PLAYER_OLD,
+	TEEHISTORIAN_INPUT_DIFF,
+	TEEHISTORIAN_INPUT_NEW,
+	TEEHISTORIAN_MESSAGE,
+	TEEHISTORIAN_JOIN,
+	TEEHISTORIAN_DROP,
+	TEEHISTORIAN_CONSOLE_COMMAND,
+	TEEHISTORIAN_EX,
+};
+
+extern const CUuid TEEHISTORIAN_UUID;
+
+/**
+ * The index optionally appended after the FINISH record, see
+ * `CTeeHistorianReader`.
+ *
+ * It consists of checkpoints of the writer state at the start of a tick
+ * every `CHECKPOINT_INTERVAL` ticks, spaced twice as far apart whenever
+ * `MAX_CHECKPOINTS` is reached, and the tick ranges in which the clients were
+ * connected, all packed as variable ints, followed by the index size as
+ * 32 bit big endian int and `MAGIC`.
+ */
+class CTeeHistorianIndex
+{
+public:
+	enum
+	{
+		VERSION = 1,
+		CHECKPOINT_INTERVAL = SERVER_TICK_SPEED * 30,
+		MAX_CHECKPOINTS = 1024,
+		MAGIC_SIZE = 8,
+		TRAILER_SIZE = 4 + MAGIC_SIZE,
+		PLAYERFLAG_ALIVE = 1 << 0,
+		PLAYERFLAG_INPUT = 1 << 1,
+	};
+	static const unsigned char MAGIC[MAGIC_SIZE];
+
+	struct CClientRange
+	{
+		int m_ClientId;
+		int m_JoinTick;
+		// -1 if the client was still connected at the end
+		int m_DropTick;
+	};
+};
+
 class CTeeHistorian
 {
 public:
@@ -41,6 +95,9 @@ public:
 		CConfig *m_pConfig;
 		CTuningParams *m_pTuning;
 		CUuidManager *m_pUuids;
+
+		// append a `CTeeHistorianIndex` in `Finish`
+		bool m_Index;
 	};
 
 	enum
@@ -105,6 +162,10 @@ private:
 	void EnsureTickWritten();
 	void WriteTick();
 	void Write(const void *pData, int DataSize);
+	void WriteCheckpoint();
+	void WriteIndex();
+	void BeginClientRange(int ClientId);
+	void EndClientRange(int ClientId);
 
 	enum
 	{
@@ -148,6 +209,15 @@ private:
 	int m_MaxClientId;
 	CTeehistorianPlayer m_aPrevPlayers[MAX_CLIENTS];
 	CTeam m_aPrevTeams[MAX_CLIENTS];
+
+	bool m_Index;
+	uint64_t m_Written;
+	int m_NextCheckpointTick;
+	int m_CheckpointInterval;
+	std::vector<std::vector<unsigned char>> m_vvCheckpoints;
+	std::vector<CTeeHistorianIndex::CClientRange> m_vClientRanges;
+	// index into `m_vClientRanges` of the open range, -1 if none
+	int m_aClientRange[MAX_CLIENTS];
 };
 
 #endif // GAME_SERVER_TEEHISTORIAN_H
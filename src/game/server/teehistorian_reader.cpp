@@ -0,0 +1,449 @@
+#include "teehistorian_reader.h"
+
+#include <base/bytes.h>
+#include <base/io.h>
+#include <base/math.h>
+#include <base/mem.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/teehistorian_ex.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <algorithm>
+#include <cstring>
+
+enum
+{
+	READ_SIZE = 64 * 1024,
+	NUM_INPUT_INTS = sizeof(CNetObj_PlayerInput) / sizeof(int32_t),
+};
+
+CTeeHistorianReader::~CTeeHistorianReader()
+{
+	Close();
+}
+
+bool CTeeHistorianReader::Open(IOHANDLE File)
+{
+	Close();
+	m_File = File;
+
+	unsigned char aMagic[CCompressedStream::MAGIC_SIZE];
+	const unsigned MagicSize = io_read(m_File, aMagic, sizeof(aMagic));
+	m_Compressed = CCompressedStream::IsCompressed(aMagic, MagicSize);
+	if(m_Compressed)
+	{
+		io_seek(m_File, 0, IOSEEK_START);
+		if(!m_CompressedReader.Open(m_File) || !m_CompressedReader.ReadBlockTable())
+			return false;
+		m_StreamSize = m_CompressedReader.Size();
+	}
+	else
+	{
+		const int64_t Length = io_length(m_File);
+		if(Length < 0)
+			return false;
+		m_StreamSize = Length;
+	}
+	m_RecordsEnd = m_StreamSize;
+
+	return ReadHeader() && ReadIndex();
+}
+
+void CTeeHistorianReader::Close()
+{
+	if(m_File)
+	{
+		io_close(m_File);
+		m_File = nullptr;
+	}
+	m_CompressedReader = CCompressedStreamReader();
+	m_vBuffer.clear();
+	m_BufferPos = 0;
+	m_BufferOffset = 0;
+	m_HasIndex = false;
+	m_vCheckpoints.clear();
+	m_vClientRanges.clear();
+	m_Positioned = false;
+}
+
+bool CTeeHistorianReader::ReadHeader()
+{
+	if(!SeekStream(0) || Fill(sizeof(CUuid)) < sizeof(CUuid) || mem_comp(m_vBuffer.data(), &TEEHISTORIAN_UUID, sizeof(CUuid)) != 0)
+		return false;
+
+	// the JSON header is terminated by a null byte
+	size_t Pos = sizeof(CUuid);
+	if(!SkipString(&Pos))
+		return false;
+	m_HeaderEnd = Pos;
+	return true;
+}
+
+bool CTeeHistorianReader::ReadIndex()
+{
+	if(m_StreamSize < m_HeaderEnd + CTeeHistorianIndex::TRAILER_SIZE)
+		return true;
+
+	const uint64_t TrailerOffset = m_StreamSize - CTeeHistorianIndex::TRAILER_SIZE;
+	if(!SeekStream(TrailerOffset) || Fill(CTeeHistorianIndex::TRAILER_SIZE) < CTeeHistorianIndex::TRAILER_SIZE)
+		return false;
+	const unsigned char *pTrailer = &m_vBuffer[m_BufferPos];
+	if(mem_comp(pTrailer + 4, CTeeHistorianIndex::MAGIC, CTeeHistorianIndex::MAGIC_SIZE) != 0)
+		return true; // no index
+	const unsigned IndexSize = bytes_be_to_uint(pTrailer);
+	if(IndexSize > TrailerOffset - m_HeaderEnd)
+		return false;
+
+	const uint64_t IndexOffset = TrailerOffset - IndexSize;
+	if(!SeekStream(IndexOffset) || Fill(IndexSize) < IndexSize)
+		return false;
+
+	size_t Pos = 0;
+	int Version, NumCheckpoints;
+	if(!ReadInt(&Pos, &Version) || Version != CTeeHistorianIndex::VERSION || !ReadInt(&Pos, &NumCheckpoints) || NumCheckpoints < 0 || NumCheckpoints > CTeeHistorianIndex::MAX_CHECKPOINTS)
+		return false;
+	for(int i = 0; i < NumCheckpoints; i++)
+	{
+		CCheckpoint Checkpoint;
+		int OffsetHigh, OffsetLow, NumPlayers;
+		if(!ReadInt(&Pos, &Checkpoint.m_Tick) || !ReadInt(&Pos, &OffsetHigh) || !ReadInt(&Pos, &OffsetLow) ||
+			!ReadInt(&Pos, &Checkpoint.m_LastWrittenTick) || !ReadInt(&Pos, &Checkpoint.m_MaxClientId) || !ReadInt(&Pos, &NumPlayers) ||
+			NumPlayers < 0 || NumPlayers > MAX_CLIENTS)
+			return false;
+		Checkpoint.m_Offset = ((uint64_t)(unsigned)OffsetHigh << 32) | (unsigned)OffsetLow;
+		if(Checkpoint.m_Offset < m_HeaderEnd || Checkpoint.m_Offset > IndexOffset)
+			return false;
+		for(int p = 0; p < NumPlayers; p++)
+		{
+			int ClientId, Flags;
+			CPlayer IndexPlayer = {};
+			if(!ReadInt(&Pos, &ClientId) || ClientId < 0 || ClientId >= MAX_CLIENTS || !ReadInt(&Pos, &Flags) || !ReadInt(&Pos, &IndexPlayer.m_Team))
+				return false;
+			IndexPlayer.m_Alive = Flags & CTeeHistorianIndex::PLAYERFLAG_ALIVE;
+			if(IndexPlayer.m_Alive && (!ReadInt(&Pos, &IndexPlayer.m_X) || !ReadInt(&Pos, &IndexPlayer.m_Y)))
+				return false;
+			IndexPlayer.m_HaveInput = Flags & CTeeHistorianIndex::PLAYERFLAG_INPUT;
+			for(int j = 0; IndexPlayer.m_HaveInput && j < NUM_INPUT_INTS; j++)
+			{
+				if(!ReadInt(&Pos, &((int *)&IndexPlayer.m_Input)[j]))
+					return false;
+			}
+			Checkpoint.m_vPlayers.emplace_back(ClientId, IndexPlayer);
+		}
+		m_vCheckpoints.push_back(std::move(Checkpoint));
+	}
+
+	int NumClientRanges;
+	if(!ReadInt(&Pos, &NumClientRanges) || NumClientRanges < 0)
+		return false;
+	for(int i = 0; i < NumClientRanges; i++)
+	{
+		CTeeHistorianIndex::CClientRange ClientRange;
+		if(!ReadInt(&Pos, &ClientRange.m_ClientId) || !ReadInt(&Pos, &ClientRange.m_JoinTick) || !ReadInt(&Pos, &ClientRange.m_DropTick))
+			return false;
+		m_vClientRanges.push_back(ClientRange);
+	}
+	if(Pos != IndexSize)
+		return false;
+
+	m_HasIndex = true;
+	m_RecordsEnd = IndexOffset;
+	return true;
+}
+
+void CTeeHistorianReader::Restore(const CCheckpoint *pCheckpoint)
+{
+	for(auto &ResetPlayer : m_aPlayers)
+	{
+		ResetPlayer = {};
+	}
+	m_Finished = false;
+	if(pCheckpoint)
+	{
+		for(const auto &[ClientId, CheckpointPlayer] : pCheckpoint->m_vPlayers)
+		{
+			m_aPlayers[ClientId] = CheckpointPlayer;
+		}
+		m_LastWrittenTick = pCheckpoint->m_LastWrittenTick;
+		m_MaxClientId = pCheckpoint->m_MaxClientId;
+		m_Tick = pCheckpoint->m_Tick - 1;
+		m_Positioned = SeekStream(pCheckpoint->m_Offset);
+	}
+	else
+	{
+		// tick 0 is implicit at the start
+		m_LastWrittenTick = 0;
+		m_MaxClientId = MAX_CLIENTS;
+		m_Tick = 0;
+		m_Positioned = SeekStream(m_HeaderEnd);
+	}
+}
+
+bool CTeeHistorianReader::SeekTick(int Tick)
+{
+	if(!m_File)
+		return false;
+
+	auto It = std::upper_bound(m_vCheckpoints.begin(), m_vCheckpoints.end(), Tick, [](int Value, const CCheckpoint &Checkpoint) { return Value < Checkpoint.m_Tick; });
+	const CCheckpoint *pCheckpoint = It == m_vCheckpoints.begin() ? nullptr : &*(It - 1);
+	const int CheckpointTick = pCheckpoint ? pCheckpoint->m_Tick - 1 : 0;
+	if(!m_Positioned || Tick < m_Tick || CheckpointTick > m_Tick)
+	{
+		Restore(pCheckpoint);
+		if(!m_Positioned)
+			return false;
+	}
+
+	while(!m_Finished)
+	{
+		const int Result = ReadRecord(Tick);
+		if(Result == RECORD_ERROR)
+		{
+			m_Positioned = false;
+			return false;
+		}
+		if(Result == RECORD_NEXT_TICK)
+			break;
+		if(Result == RECORD_END)
+			m_Finished = true;
+	}
+	m_Tick = Tick;
+	return true;
+}
+
+int CTeeHistorianReader::ReadRecord(int TargetTick)
+{
+	if(m_BufferOffset + m_BufferPos >= m_RecordsEnd || Fill(1) == 0)
+		return RECORD_END;
+
+	size_t Pos = 0;
+	int Type;
+	if(!ReadInt(&Pos, &Type))
+		return RECORD_ERROR;
+
+	// player records in a tick are ordered by client id, a lower one
+	// starts the next tick implicitly
+	int ClientId = -1;
+	if(Type >= 0 || Type == -TEEHISTORIAN_PLAYER_NEW || Type == -TEEHISTORIAN_PLAYER_OLD)
+	{
+		ClientId = Type;
+		if(Type < 0 && !ReadInt(&Pos, &ClientId))
+			return RECORD_ERROR;
+		if(ClientId < 0 || ClientId >= MAX_CLIENTS)
+			return RECORD_ERROR;
+		const bool NextTick = ClientId <= m_MaxClientId;
+		if(NextTick && m_LastWrittenTick + 1 > TargetTick)
+			return RECORD_NEXT_TICK;
+		if(NextTick)
+			m_LastWrittenTick++;
+		m_MaxClientId = ClientId;
+	}
+
+	CPlayer *pPlayer = ClientId >= 0 ? &m_aPlayers[ClientId] : nullptr;
+	switch(Type)
+	{
+	case -TEEHISTORIAN_FINISH:
+		m_BufferPos += Pos;
+		return RECORD_END;
+	case -TEEHISTORIAN_TICK_SKIP:
+	{
+		int TickDelta;
+		if(!ReadInt(&Pos, &TickDelta) || TickDelta < 0)
+			return RECORD_ERROR;
+		if(m_LastWrittenTick + TickDelta + 1 > TargetTick)
+			return RECORD_NEXT_TICK;
+		m_LastWrittenTick += TickDelta + 1;
+		m_MaxClientId = -1;
+		break;
+	}
+	case -TEEHISTORIAN_PLAYER_NEW:
+		if(!ReadInt(&Pos, &pPlayer->m_X) || !ReadInt(&Pos, &pPlayer->m_Y))
+			return RECORD_ERROR;
+		pPlayer->m_Alive = true;
+		break;
+	case -TEEHISTORIAN_PLAYER_OLD:
+		pPlayer->m_Alive = false;
+		break;
+	case -TEEHISTORIAN_INPUT_NEW:
+	case -TEEHISTORIAN_INPUT_DIFF:
+	{
+		int InputClientId;
+		int aInput[NUM_INPUT_INTS];
+		if(!ReadInt(&Pos, &InputClientId) || InputClientId < 0 || InputClientId >= MAX_CLIENTS)
+			return RECORD_ERROR;
+		for(int &Value : aInput)
+		{
+			if(!ReadInt(&Pos, &Value))
+				return RECORD_ERROR;
+		}
+		CPlayer &InputPlayer = m_aPlayers[InputClientId];
+		int *pInput = (int *)&InputPlayer.m_Input;
+		for(int i = 0; i < NUM_INPUT_INTS; i++)
+		{
+			pInput[i] = Type == -TEEHISTORIAN_INPUT_NEW ? aInput[i] : (int)((unsigned)pInput[i] + (unsigned)aInput[i]);
+		}
+		InputPlayer.m_HaveInput = true;
+		break;
+	}
+	case -TEEHISTORIAN_MESSAGE:
+	{
+		int MsgClientId, MsgSize;
+		if(!ReadInt(&Pos, &MsgClientId) || !ReadInt(&Pos, &MsgSize) || MsgSize < 0 || !SkipRaw(&Pos, MsgSize))
+			return RECORD_ERROR;
+		break;
+	}
+	case -TEEHISTORIAN_JOIN:
+	{
+		int JoinClientId;
+		if(!ReadInt(&Pos, &JoinClientId))
+			return RECORD_ERROR;
+		break;
+	}
+	case -TEEHISTORIAN_DROP:
+	{
+		int DropClientId;
+		if(!ReadInt(&Pos, &DropClientId) || !SkipString(&Pos))
+			return RECORD_ERROR;
+		break;
+	}
+	case -TEEHISTORIAN_CONSOLE_COMMAND:
+	{
+		int CmdClientId, FlagMask, NumArgs;
+		if(!ReadInt(&Pos, &CmdClientId) || !ReadInt(&Pos, &FlagMask) || !SkipString(&Pos) || !ReadInt(&Pos, &NumArgs) || NumArgs < 0)
+			return RECORD_ERROR;
+		for(int i = 0; i < NumArgs; i++)
+		{
+			if(!SkipString(&Pos))
+				return RECORD_ERROR;
+		}
+		break;
+	}
+	case -TEEHISTORIAN_EX:
+	{
+		int DataSize;
+		if(Fill(Pos + sizeof(CUuid)) < Pos + sizeof(CUuid))
+			return RECORD_ERROR;
+		CUuid Uuid;
+		mem_copy(&Uuid, &m_vBuffer[m_BufferPos + Pos], sizeof(Uuid));
+		Pos += sizeof(Uuid);
+		if(!ReadInt(&Pos, &DataSize) || DataSize < 0)
+			return RECORD_ERROR;
+		size_t DataPos = Pos;
+		if(!SkipRaw(&Pos, DataSize))
+			return RECORD_ERROR;
+		if(g_UuidManager.LookupUuid(Uuid) == TEEHISTORIAN_PLAYER_TEAM)
+		{
+			int TeamClientId, Team;
+			if(!ReadInt(&DataPos, &TeamClientId) || !ReadInt(&DataPos, &Team) || DataPos > Pos || TeamClientId < 0 || TeamClientId >= MAX_CLIENTS)
+				return RECORD_ERROR;
+			m_aPlayers[TeamClientId].m_Team = Team;
+		}
+		break;
+	}
+	default:
+		if(Type >= 0)
+		{
+			int Dx, Dy;
+			if(!ReadInt(&Pos, &Dx) || !ReadInt(&Pos, &Dy))
+				return RECORD_ERROR;
+			pPlayer->m_X += Dx;
+			pPlayer->m_Y += Dy;
+			break;
+		}
+		return RECORD_ERROR;
+	}
+
+	m_BufferPos += Pos;
+	return RECORD_OK;
+}
+
+bool CTeeHistorianReader::SeekStream(uint64_t Offset)
+{
+	m_vBuffer.clear();
+	m_BufferPos = 0;
+	m_BufferOffset = Offset;
+	if(Offset > m_StreamSize)
+		return false;
+	if(!m_Compressed)
+		return io_seek(m_File, Offset, IOSEEK_START) == 0;
+
+	if(Offset == m_StreamSize)
+		return true;
+	uint64_t BlockOffset;
+	if(!m_CompressedReader.SeekBlock(Offset) || !m_CompressedReader.ReadBlock(m_vBuffer, &BlockOffset) || BlockOffset > Offset)
+		return false;
+	m_BufferOffset = BlockOffset;
+	m_BufferPos = Offset - BlockOffset;
+	return true;
+}
+
+size_t CTeeHistorianReader::Fill(size_t Size)
+{
+	while(m_vBuffer.size() - m_BufferPos < Size)
+	{
+		if(m_BufferPos > 0)
+		{
+			m_vBuffer.erase(m_vBuffer.begin(), m_vBuffer.begin() + m_BufferPos);
+			m_BufferOffset += m_BufferPos;
+			m_BufferPos = 0;
+		}
+		if(m_Compressed)
+		{
+			if(!m_CompressedReader.ReadBlock(m_vBlock))
+				break;
+			m_vBuffer.insert(m_vBuffer.end(), m_vBlock.begin(), m_vBlock.end());
+		}
+		else
+		{
+			const size_t OldSize = m_vBuffer.size();
+			const size_t ReadSize = maximum<size_t>(Size - OldSize, READ_SIZE);
+			m_vBuffer.resize(OldSize + ReadSize);
+			const unsigned Read = io_read(m_File, &m_vBuffer[OldSize], ReadSize);
+			m_vBuffer.resize(OldSize + Read);
+			if(Read == 0)
+				break;
+		}
+	}
+	return m_vBuffer.size() - m_BufferPos;
+}
+
+bool CTeeHistorianReader::ReadInt(size_t *pPos, int *pValue)
+{
+	const size_t Available = Fill(*pPos + CVariableInt::MAX_BYTES_PACKED);
+	if(Available <= *pPos)
+		return false;
+	const unsigned char *pStart = &m_vBuffer[m_BufferPos + *pPos];
+	const unsigned char *pEnd = CVariableInt::Unpack(pStart, pValue, Available - *pPos);
+	if(!pEnd)
+		return false;
+	*pPos += pEnd - pStart;
+	return true;
+}
+
+bool CTeeHistorianReader::SkipRaw(size_t *pPos, size_t Size)
+{
+	if(Fill(*pPos + Size) < *pPos + Size)
+		return false;
+	*pPos += Size;
+	return true;
+}
+
+bool CTeeHistorianReader::SkipString(size_t *pPos)
+{
+	size_t Searched = *pPos;
+	while(true)
+	{
+		const size_t Available = Fill(Searched + 1);
+		if(Available <= Searched)
+			return false;
+		const unsigned char *pStart = &m_vBuffer[m_BufferPos + Searched];
+		const unsigned char *pNull = (const unsigned char *)std::memchr(pStart, 0, Available - Searched);
+		if(pNull)
+		{
+			*pPos = Searched + (pNull - pStart) + 1;
+			return true;
+		}
+		Searched = Available;
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef GAME_SERVER_TEEHISTORIAN_READER_H
+#define GAME_SERVER_TEEHISTORIAN_READER_H
+
+#include "teehistorian.h"
+
+#include <engine/shared/compressed_stream.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Reads the player state of arbitrary ticks from a plain or compressed
+ * teehistorian file.
+ *
+ * If the file has a `CTeeHistorianIndex`, decoding starts at the closest
+ * checkpoint before the requested tick, otherwise at the start of the
+ * file. Only records that change the player state are interpreted, all
+ * others are skipped.
+ */
+class CTeeHistorianReader
+{
+public:
+	struct CPlayer
+	{
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+
+		bool m_HaveInput;
+		CNetObj_PlayerInput m_Input;
+
+		// DDNet team
+		int m_Team;
+	};
+
+	~CTeeHistorianReader();
+
+	/**
+	 * Takes ownership of the file.
+	 */
+	bool Open(IOHANDLE File);
+	void Close();
+
+	bool HasIndex() const { return m_HasIndex; }
+	int NumCheckpoints() const { return m_vCheckpoints.size(); }
+	const std::vector<CTeeHistorianIndex::CClientRange> &ClientRanges() const { return m_vClientRanges; }
+
+	/**
+	 * Decodes the file up to and including the given tick. Seeking forward
+	 * continues from the current position if there is no closer
+	 * checkpoint.
+	 *
+	 * @return `false` if the file is invalid. Ticks after the end of the
+	 * file keep the state of the last recorded tick.
+	 */
+	bool SeekTick(int Tick);
+
+	int Tick() const { return m_Tick; }
+	const CPlayer &Player(int ClientId) const { return m_aPlayers[ClientId]; }
+
+private:
+	struct CCheckpoint
+	{
+		int m_Tick;
+		uint64_t m_Offset;
+		int m_LastWrittenTick;
+		int m_MaxClientId;
+		std::vector<std::pair<int, CPlayer>> m_vPlayers;
+	};
+
+	enum
+	{
+		RECORD_OK,
+		RECORD_NEXT_TICK,
+		RECORD_END,
+		RECORD_ERROR,
+	};
+
+	bool ReadIndex();
+	bool ReadHeader();
+	void Restore(const CCheckpoint *pCheckpoint);
+	int ReadRecord(int TargetTick);
+
+	bool SeekStream(uint64_t Offset);
+	size_t Fill(size_t Size);
+	bool ReadInt(size_t *pPos, int *pValue);
+	bool SkipRaw(size_t *pPos, size_t Size);
+	bool SkipString(size_t *pPos);
+
+	IOHANDLE m_File = nullptr;
+	bool m_Compressed = false;
+	CCompressedStreamReader m_CompressedReader;
+	uint64_t m_StreamSize = 0;
+	// end of the teehistorian records, i.e. the start of the index
+	uint64_t m_RecordsEnd = 0;
+	uint64_t m_HeaderEnd = 0;
+
+	// data starting at `m_BufferOffset` in the stream, read from `m_BufferPos`
+	std::vector<unsigned char> m_vBuffer;
+	size_t m_BufferPos = 0;
+	uint64_t m_BufferOffset = 0;
+	std::vector<unsigned char> m_vBlock;
+
+	bool m_HasIndex = false;
+	std::vector<CCheckpoint> m_vCheckpoints;
+	std::vector<CTeeHistorianIndex::CClientRange> m_vClientRanges;
+
+	bool m_Positioned = false;
+	bool m_Finished = false;
+	int m_Tick = 0;
+	int m_LastWrittenTick = 0;
+	int m_MaxClientId = MAX_CLIENTS;
+	CPlayer m_aPlayers[MAX_CLIENTS];
+};
+
+#endif // GAME_SERVER_TEEHISTORIAN_READER_H
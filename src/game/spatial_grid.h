@@ -0,0 +1,213 @@
+#ifndef GAME_SPATIAL_GRID_H
+#define GAME_SPATIAL_GRID_H
+
+#include <base/vmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Spatial hash of entity positions, used by the game worlds to answer radius
+ * and line queries without walking every entity of a type.
+ *
+ * Entities embed a `CNode` and are linked into the bucket of the cell their
+ * position is in. The grid only narrows down the candidates, callers must still
+ * do their exact distance checks on everything returned by `Query`.
+ *
+ * Grids over large areas per entity (like the snap culling) should use a larger
+ * `CellSize` to keep the number of visited cells per query low.
+ */
+template<class TEntity, int CellSize = 256>
+class CSpatialGrid
+{
+public:
+	class CNode
+	{
+		friend class CSpatialGrid;
+
+		CNode *m_pPrev = nullptr;
+		CNode *m_pNext = nullptr;
+		int m_Bucket = -1;
+		float m_Radius = 0.0f;
+
+	public:
+		TEntity *m_pEntity = nullptr;
+		// position in the type list of the world, higher comes first
+		int64_t m_Order = 0;
+
+		bool Inserted() const { return m_Bucket >= 0; }
+	};
+
+	enum
+	{
+		CELL_SIZE = CellSize,
+		NUM_BUCKETS = 1024,
+		MAX_QUERY_CELLS = 64,
+	};
+
+private:
+	CNode *m_apBuckets[NUM_BUCKETS] = {};
+	int m_NumNodes = 0;
+	// largest radius of the inserted nodes and how many nodes have it
+	float m_MaxRadius = 0.0f;
+	int m_NumMaxRadius = 0;
+
+	static int Cell(float Coord)
+	{
+		// positions far outside of the map (or NaN) all end up in the border cells
+		const float Clamped = Coord > -1000000.0f ? (Coord < 1000000.0f ? Coord : 1000000.0f) : -1000000.0f;
+		return (int)std::floor(Clamped / (float)CELL_SIZE);
+	}
+
+	static int Bucket(int CellX, int CellY)
+	{
+		return ((unsigned)CellX * 73856093u ^ (unsigned)CellY * 19349663u) % NUM_BUCKETS;
+	}
+
+	void Link(CNode *pNode, int Bucket)
+	{
+		pNode->m_Bucket = Bucket;
+		pNode->m_pPrev = nullptr;
+		pNode->m_pNext = m_apBuckets[Bucket];
+		if(m_apBuckets[Bucket])
+			m_apBuckets[Bucket]->m_pPrev = pNode;
+		m_apBuckets[Bucket] = pNode;
+	}
+
+	void AddRadius(float Radius)
+	{
+		if(Radius > m_MaxRadius)
+		{
+			m_MaxRadius = Radius;
+			m_NumMaxRadius = 1;
+		}
+		else if(Radius == m_MaxRadius)
+		{
+			m_NumMaxRadius++;
+		}
+	}
+
+	void RemoveRadius(float Radius)
+	{
+		if(Radius != m_MaxRadius || --m_NumMaxRadius > 0)
+			return;
+
+		// the last node with the largest radius is gone, find the next largest
+		m_MaxRadius = 0.0f;
+		m_NumMaxRadius = 0;
+		for(const CNode *pBucket : m_apBuckets)
+			for(const CNode *pNode = pBucket; pNode; pNode = pNode->m_pNext)
+				AddRadius(pNode->m_Radius);
+	}
+
+	void Unlink(CNode *pNode)
+	{
+		if(pNode->m_pPrev)
+			pNode->m_pPrev->m_pNext = pNode->m_pNext;
+		else
+			m_apBuckets[pNode->m_Bucket] = pNode->m_pNext;
+		if(pNode->m_pNext)
+			pNode->m_pNext->m_pPrev = pNode->m_pPrev;
+		pNode->m_pPrev = nullptr;
+		pNode->m_pNext = nullptr;
+		pNode->m_Bucket = -1;
+	}
+
+public:
+	int Size() const { return m_NumNodes; }
+	float MaxRadius() const { return m_MaxRadius; }
+
+	void Insert(CNode *pNode, TEntity *pEntity, int64_t Order, vec2 Pos, float Radius)
+	{
+		pNode->m_pEntity = pEntity;
+		pNode->m_Order = Order;
+		pNode->m_Radius = Radius;
+		AddRadius(Radius);
+		Link(pNode, Bucket(Cell(Pos.x), Cell(Pos.y)));
+		m_NumNodes++;
+	}
+
+	void Remove(CNode *pNode)
+	{
+		if(!pNode->Inserted())
+			return;
+		Unlink(pNode);
+		m_NumNodes--;
+		RemoveRadius(pNode->m_Radius);
+	}
+
+	void Move(CNode *pNode, vec2 Pos, float Radius)
+	{
+		if(!pNode->Inserted())
+			return;
+		if(Radius != pNode->m_Radius)
+		{
+			const float OldRadius = pNode->m_Radius;
+			pNode->m_Radius = Radius;
+			AddRadius(Radius);
+			RemoveRadius(OldRadius);
+		}
+		const int NewBucket = Bucket(Cell(Pos.x), Cell(Pos.y));
+		if(NewBucket == pNode->m_Bucket)
+			return;
+		Unlink(pNode);
+		Link(pNode, NewBucket);
+	}
+
+	/**
+	 * Calls `Callback(const CNode *)` for every entity whose position might be
+	 * within the box, extended by the largest entity radius.
+	 *
+	 * @return `false` without calling `Callback` if the box covers more cells
+	 * than walking all entities would cost. The caller has to fall back to a
+	 * linear search then.
+	 */
+	template<class F>
+	bool Query(vec2 Min, vec2 Max, F &&Callback) const
+	{
+		const int MinX = Cell(Min.x - m_MaxRadius);
+		const int MinY = Cell(Min.y - m_MaxRadius);
+		const int MaxX = Cell(Max.x + m_MaxRadius);
+		const int MaxY = Cell(Max.y + m_MaxRadius);
+		const int64_t NumCells = (int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1);
+		if(NumCells > MAX_QUERY_CELLS || NumCells > m_NumNodes)
+			return false;
+
+		// different cells can hash to the same bucket, visit each one once
+		int aVisited[MAX_QUERY_CELLS];
+		int NumVisited = 0;
+		for(int y = MinY; y <= MaxY; y++)
+		{
+			for(int x = MinX; x <= MaxX; x++)
+			{
+				const int Index = Bucket(x, y);
+				if(std::find(aVisited, aVisited + NumVisited, Index) != aVisited + NumVisited)
+					continue;
+				aVisited[NumVisited++] = Index;
+				for(const CNode *pNode = m_apBuckets[Index]; pNode; pNode = pNode->m_pNext)
+					Callback(pNode);
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Like `Query`, but appends the nodes to `vpNodes` in the order of the
+	 * entity lists of the world, so that callers visit them in the same
+	 * order as a linear search would.
+	 */
+	bool Collect(vec2 Min, vec2 Max, std::vector<const CNode *> &vpNodes) const
+	{
+		const size_t Begin = vpNodes.size();
+		if(!Query(Min, Max, [&](const CNode *pNode) { vpNodes.push_back(pNode); }))
+			return false;
+		std::sort(vpNodes.begin() + Begin, vpNodes.end(), [](const CNode *pA, const CNode *pB) {
+			return pA->m_Order > pB->m_Order;
+		});
+		return true;
+	}
+};
+
+#endif
@@ -8,6 +8,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 static const int BUF_SIZE = 64 * 1024;
 
 class Async : public ::testing::Test
@@ -149,3 +153,56 @@ TEST_F(Async, Transaction)
 	}
 	Expect(aText);
 }
+
+class CSlowFlushEncoder
+{
+public:
+	std::atomic<bool> m_Flushing{false};
+	std::atomic<bool> m_ErrorRead{false};
+	bool m_ErrorReadDuringFlush = false;
+
+	static int Encode(void *pUser, IOHANDLE File, const void *pData, unsigned Size)
+	{
+		CSlowFlushEncoder *pEncoder = static_cast<CSlowFlushEncoder *>(pUser);
+		if(pData)
+			return io_write(File, pData, Size) != Size;
+
+		// the final flush waits for another thread to use the handle
+		pEncoder->m_Flushing = true;
+		const auto Start = std::chrono::steady_clock::now();
+		while(!pEncoder->m_ErrorRead && std::chrono::steady_clock::now() - Start < std::chrono::seconds(5))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		pEncoder->m_ErrorReadDuringFlush = pEncoder->m_ErrorRead;
+		return io_write(File, "!", 1) != 1;
+	}
+};
+
+TEST(AsyncEncoded, FlushDoesNotHoldLock)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	CSlowFlushEncoder Encoder;
+	ASYNCIO *pAio = aio_new_encoded(File, CSlowFlushEncoder::Encode, &Encoder);
+	aio_write(pAio, "abc", 3);
+	aio_close(pAio);
+
+	while(!Encoder.m_Flushing)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	EXPECT_EQ(aio_error(pAio), 0);
+	Encoder.m_ErrorRead = true;
+
+	aio_wait(pAio);
+	EXPECT_EQ(aio_error(pAio), 0);
+	aio_free(pAio);
+	EXPECT_TRUE(Encoder.m_ErrorReadDuringFlush);
+
+	char aBuf[16];
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	const unsigned Read = io_read(File, aBuf, sizeof(aBuf));
+	io_close(File);
+	EXPECT_EQ(Read, 4u);
+	EXPECT_EQ(mem_comp(aBuf, "abc!", 4), 0);
+	fs_remove(Info.m_aFilename);
+}
@@ -0,0 +1,309 @@
+#include "test.h"
+
+#include <base/math.h>
+#include <base/vmath.h>
+
+#include <engine/shared/config.h>
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+
+// The per-pixel implementations the tile traversal in CCollision replaced,
+// the results have to stay exactly the same.
+
+static int RefIntersectLine(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleHook(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	int dx = 0, dy = 0;
+	ThroughOffset(Pos0, Pos1, &dx, &dy);
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+
+		int Index = Collision.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportHook)
+			*pTeleNr = Collision.IsTeleport(Index);
+		else
+			*pTeleNr = Collision.IsTeleportHook(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINHOOK;
+		}
+
+		int Hit = 0;
+		if(Collision.CheckPoint(ix, iy))
+		{
+			if(!Collision.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+				Hit = Collision.GetCollisionAt(ix, iy);
+		}
+		else if(Collision.IsHookBlocker(ix, iy, Pos0, Pos1))
+		{
+			Hit = TILE_NOHOOK;
+		}
+		if(Hit)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Hit;
+		}
+
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleWeapon(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+
+		int Index = Collision.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportWeapons)
+			*pTeleNr = Collision.IsTeleport(Index);
+		else
+			*pTeleNr = Collision.IsTeleportWeapon(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINWEAPON;
+		}
+
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaser(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, Collision.GetWidth() - 1);
+		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, Collision.GetHeight() - 1);
+		if(Collision.GetIndex(Nx, Ny) == TILE_SOLID || Collision.GetIndex(Nx, Ny) == TILE_NOHOOK || Collision.GetIndex(Nx, Ny) == TILE_NOLASER || Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+				return Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+			else
+				return Collision.GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaserNoWalls(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = (float)i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		if(Collision.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || Collision.IsFrontNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Collision.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+				return Collision.GetCollisionAt(Pos.x, Pos.y);
+			else
+				return Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectAir(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = (float)i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		if(Collision.IsSolid(ix, iy) || (!Collision.GetTile(ix, iy) && !Collision.GetFrontTile(ix, iy)))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(!Collision.GetTile(ix, iy) && !Collision.GetFrontTile(ix, iy))
+				return -1;
+			else if(!Collision.GetTile(ix, iy))
+				return Collision.GetTile(ix, iy);
+			else
+				return Collision.GetFrontTile(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static float RandomFloat(CPrng &Prng, float Min, float Max)
+{
+	return Min + (Prng.RandomBits() / (float)0xffffffffu) * (Max - Min);
+}
+
+static void ExpectSameResult(int Result, vec2 Collision, vec2 BeforeCollision, int RefResult, vec2 RefCollision, vec2 RefBeforeCollision, vec2 Pos0, vec2 Pos1)
+{
+	// positions are compared exactly, the traversal must hit the same samples
+	EXPECT_EQ(Result, RefResult) << "from (" << Pos0.x << ", " << Pos0.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+	EXPECT_EQ(Collision, RefCollision) << "from (" << Pos0.x << ", " << Pos0.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+	EXPECT_EQ(BeforeCollision, RefBeforeCollision) << "from (" << Pos0.x << ", " << Pos0.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+}
+
+static void TestMap(IStorage *pStorage, const char *pMap)
+{
+	CMap Map;
+	ASSERT_TRUE(Map.Load(pStorage, pMap, IStorage::TYPE_ALL)) << pMap;
+	CLayers Layers;
+	Layers.Init(&Map, true);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+	Prng.Seed(aSeed);
+
+	const float Width = Collision.GetWidth() * 32.0f;
+	const float Height = Collision.GetHeight() * 32.0f;
+	for(int i = 0; i < 4000; i++)
+	{
+		// mostly short segments like hooks and lasers, some of them axis
+		// aligned or diagonal, and some starting or ending outside of the map
+		const vec2 Pos0 = vec2(RandomFloat(Prng, -64.0f, Width + 64.0f), RandomFloat(Prng, -64.0f, Height + 64.0f));
+		vec2 Pos1;
+		switch(Prng.RandomBits() % 4)
+		{
+		case 0: Pos1 = Pos0 + vec2(RandomFloat(Prng, -800.0f, 800.0f), 0.0f); break;
+		case 1: Pos1 = Pos0 + vec2(0.0f, RandomFloat(Prng, -800.0f, 800.0f)); break;
+		case 2: Pos1 = Pos0 + direction(RandomFloat(Prng, 0.0f, 2 * pi)) * RandomFloat(Prng, 0.0f, 800.0f); break;
+		default: Pos1 = vec2(RandomFloat(Prng, -64.0f, Width + 64.0f), RandomFloat(Prng, -64.0f, Height + 64.0f)); break;
+		}
+
+		vec2 Out, Before, RefOut, RefBefore;
+		int TeleNr = -1, RefTeleNr = -2;
+		int Result, RefResult;
+
+		Result = Collision.IntersectLine(Pos0, Pos1, &Out, &Before);
+		RefResult = RefIntersectLine(Collision, Pos0, Pos1, &RefOut, &RefBefore);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+
+		Result = Collision.IntersectLineTeleHook(Pos0, Pos1, &Out, &Before, &TeleNr);
+		RefResult = RefIntersectLineTeleHook(Collision, Pos0, Pos1, &RefOut, &RefBefore, &RefTeleNr);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+		EXPECT_EQ(TeleNr, RefTeleNr);
+
+		Result = Collision.IntersectLineTeleWeapon(Pos0, Pos1, &Out, &Before, &TeleNr);
+		RefResult = RefIntersectLineTeleWeapon(Collision, Pos0, Pos1, &RefOut, &RefBefore, &RefTeleNr);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+		EXPECT_EQ(TeleNr, RefTeleNr);
+
+		Result = Collision.IntersectNoLaser(Pos0, Pos1, &Out, &Before);
+		RefResult = RefIntersectNoLaser(Collision, Pos0, Pos1, &RefOut, &RefBefore);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+
+		Result = Collision.IntersectNoLaserNoWalls(Pos0, Pos1, &Out, &Before);
+		RefResult = RefIntersectNoLaserNoWalls(Collision, Pos0, Pos1, &RefOut, &RefBefore);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+
+		Result = Collision.IntersectAir(Pos0, Pos1, &Out, &Before);
+		RefResult = RefIntersectAir(Collision, Pos0, Pos1, &RefOut, &RefBefore);
+		ExpectSameResult(Result, Out, Before, RefResult, RefOut, RefBefore, Pos0, Pos1);
+
+		if(::testing::Test::HasFailure())
+			return;
+	}
+}
+
+TEST(Collision, IntersectLineMatchesPerPixel)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+
+	for(const char *pMap : {"maps/coverage.map", "maps/Tutorial.map", "maps/ctf1.map", "maps/Gold Mine.map", "maps/Sunny Side Up.map"})
+	{
+		TestMap(pStorage.get(), pMap);
+	}
+}
@@ -0,0 +1,210 @@
+
+#include <engine/client/graphics_command_list.h>
+#include <engine/client/graphics_threaded.h>
+#include <engine/shared/jobs.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static void AddCommands(CCommandBuffer *pBuffer, std::vector<int> vIds)
+{
+	for(int Id : vIds)
+	{
+		CCommandBuffer::SCommand_Clear Cmd;
+		Cmd.m_Color = {(float)Id, 0.0f, 0.0f, 1.0f};
+		Cmd.m_ForceClear = false;
+		ASSERT_TRUE(pBuffer->AddCommandUnsafe(Cmd));
+	}
+	pBuffer->AddRenderCalls(vIds.size());
+}
+
+// commands of command lists are identified by the number of tiles they draw
+static std::vector<int> CommandIds(const CCommandBuffer &Buffer)
+{
+	std::vector<int> vIds;
+	for(const CCommandBuffer::SCommand *pCmd = Buffer.Head(); pCmd != nullptr; pCmd = pCmd->m_pNext)
+	{
+		if(pCmd->m_Cmd == CCommandBuffer::CMD_RENDER_BORDER_TILE)
+			vIds.push_back(static_cast<const CCommandBuffer::SCommand_RenderBorderTile *>(pCmd)->m_DrawNum);
+		else
+			vIds.push_back((int)static_cast<const CCommandBuffer::SCommand_Clear *>(pCmd)->m_Color.r);
+	}
+	return vIds;
+}
+
+TEST(CommandBuffer, InsertCommands)
+{
+	CCommandBuffer Main(1024, 1024);
+	CCommandBuffer Head(1024, 1024);
+	CCommandBuffer Middle(1024, 1024);
+	CCommandBuffer Tail(1024, 1024);
+	AddCommands(&Main, {1, 2, 3});
+	AddCommands(&Head, {10, 11});
+	AddCommands(&Middle, {20});
+	AddCommands(&Tail, {30, 31});
+
+	CCommandBuffer::SCommand *pSecond = Main.Head()->m_pNext;
+	EXPECT_EQ(Main.InsertCommands(nullptr, Head), Head.Tail());
+	EXPECT_EQ(Main.InsertCommands(pSecond, Middle), Middle.Tail());
+	EXPECT_EQ(Main.InsertCommands(Main.Tail(), Tail), Tail.Tail());
+	EXPECT_EQ(CommandIds(Main), (std::vector<int>{10, 11, 1, 2, 20, 3, 30, 31}));
+	EXPECT_EQ(Main.Tail(), Tail.Tail());
+	EXPECT_EQ(Main.m_CommandCount, 8u);
+	EXPECT_EQ(Main.m_RenderCallCount, 8u);
+
+	// commands can still be added after the inserted ones
+	AddCommands(&Main, {4});
+	EXPECT_EQ(CommandIds(Main), (std::vector<int>{10, 11, 1, 2, 20, 3, 30, 31, 4}));
+}
+
+TEST(CommandBuffer, InsertCommandsChained)
+{
+	// command lists started at the same point keep their order
+	CCommandBuffer Main(1024, 1024);
+	CCommandBuffer First(1024, 1024);
+	CCommandBuffer Second(1024, 1024);
+	AddCommands(&Main, {1, 2});
+	AddCommands(&First, {10, 11});
+	AddCommands(&Second, {20});
+
+	CCommandBuffer::SCommand *pAfter = Main.Head();
+	pAfter = Main.InsertCommands(pAfter, First);
+	pAfter = Main.InsertCommands(pAfter, Second);
+	EXPECT_EQ(pAfter, Second.Tail());
+	EXPECT_EQ(CommandIds(Main), (std::vector<int>{1, 10, 11, 20, 2}));
+	EXPECT_EQ(Main.Tail()->m_pNext, nullptr);
+}
+
+TEST(CommandBuffer, InsertCommandsEmpty)
+{
+	CCommandBuffer Main(1024, 1024);
+	CCommandBuffer Other(1024, 1024);
+	CCommandBuffer Empty(1024, 1024);
+	AddCommands(&Other, {1, 2});
+
+	EXPECT_EQ(Main.InsertCommands(nullptr, Empty), nullptr);
+	EXPECT_EQ(Main.Head(), nullptr);
+
+	EXPECT_EQ(Main.InsertCommands(nullptr, Other), Other.Tail());
+	EXPECT_EQ(CommandIds(Main), (std::vector<int>{1, 2}));
+	EXPECT_EQ(Main.Tail(), Other.Tail());
+
+	CCommandBuffer::SCommand *pHead = Main.Head();
+	EXPECT_EQ(Main.InsertCommands(pHead, Empty), pHead);
+	EXPECT_EQ(Main.m_CommandCount, 2u);
+}
+
+class CommandLists : public ::testing::Test
+{
+protected:
+	CCommandBuffer m_aFrames[2] = {CCommandBuffer(1024 * 16, 1024), CCommandBuffer(1024 * 16, 1024)};
+	CCommandBuffer::SState m_State = {};
+	CGraphicsCommandLists m_Lists;
+	CJobPool m_Pool;
+
+	void SetUp() override
+	{
+		m_Pool.Init(4);
+	}
+
+	void TearDown() override
+	{
+		m_Pool.Shutdown();
+	}
+
+	// like a map layer: many draws, enough for more than one buffer of the list
+	static TRecordCommandListFunc RecordLayer(int Layer, std::vector<int> *pExpectedIds)
+	{
+		const int NumDraws = 1 + (Layer % 4) * 400;
+		for(int i = 0; i < NumDraws; i++)
+			pExpectedIds->push_back(Layer * 10000 + i);
+		return [Layer, NumDraws](IGraphicsCommandList *pCommandList) {
+			for(int i = 0; i < NumDraws; i++)
+				pCommandList->RenderBorderTiles(0, ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f), nullptr, vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), Layer * 10000 + i);
+		};
+	}
+
+	// interleaves commands of the frame with layers, returns the order of serial recording
+	std::vector<int> RecordFrame(bool Threaded)
+	{
+		std::vector<int> vExpectedIds;
+		for(int Layer = 1; Layer <= 16; Layer++)
+		{
+			AddCommands(&m_aFrames[0], {Layer});
+			vExpectedIds.push_back(Layer);
+			m_State.m_Texture = Layer;
+			std::shared_ptr<IJob> pJob = m_Lists.Add(&m_aFrames[0], m_State, 800, 600, RecordLayer(Layer, &vExpectedIds));
+			if(Threaded)
+				m_Pool.Add(std::move(pJob));
+		}
+		AddCommands(&m_aFrames[0], {100});
+		vExpectedIds.push_back(100);
+		return vExpectedIds;
+	}
+};
+
+TEST_F(CommandLists, MergedOrderMatchesSerialRecording)
+{
+	for(bool Threaded : {false, true})
+	{
+		m_aFrames[0].Reset();
+		const std::vector<int> vExpectedIds = RecordFrame(Threaded);
+		m_Lists.Merge(&m_aFrames[0], 0);
+		EXPECT_EQ(CommandIds(m_aFrames[0]), vExpectedIds) << (Threaded ? "threaded" : "serial");
+		// each list keeps the texture of the frame it was added at
+		for(const CCommandBuffer::SCommand *pCmd = m_aFrames[0].Head(); pCmd != nullptr; pCmd = pCmd->m_pNext)
+		{
+			if(pCmd->m_Cmd != CCommandBuffer::CMD_RENDER_BORDER_TILE)
+				continue;
+			const auto *pTiles = static_cast<const CCommandBuffer::SCommand_RenderBorderTile *>(pCmd);
+			EXPECT_EQ(pTiles->m_State.m_Texture, (int)pTiles->m_DrawNum / 10000);
+		}
+		m_Lists.OnKick(0);
+	}
+}
+
+TEST_F(CommandLists, StateOfFrame)
+{
+	m_State.m_Texture = 7;
+	m_State.m_ClipEnable = true;
+	std::shared_ptr<IJob> pJob = m_Lists.Add(&m_aFrames[0], m_State, 800, 600, [](IGraphicsCommandList *pCommandList) {
+		pCommandList->RenderBorderTiles(0, ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f), nullptr, vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), 1);
+		pCommandList->ClipDisable();
+		pCommandList->TextureClear();
+		pCommandList->RenderBorderTiles(0, ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f), nullptr, vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), 2);
+	});
+	m_Pool.Add(std::move(pJob));
+	// the list starts with the state it was added with
+	m_State.m_Texture = 8;
+	m_Lists.Merge(&m_aFrames[0], 0);
+
+	const auto *pFirst = static_cast<const CCommandBuffer::SCommand_RenderBorderTile *>(m_aFrames[0].Head());
+	const auto *pSecond = static_cast<const CCommandBuffer::SCommand_RenderBorderTile *>(pFirst->m_pNext);
+	EXPECT_EQ(pFirst->m_State.m_Texture, 7);
+	EXPECT_TRUE(pFirst->m_State.m_ClipEnable);
+	EXPECT_EQ(pSecond->m_State.m_Texture, -1);
+	EXPECT_FALSE(pSecond->m_State.m_ClipEnable);
+}
+
+TEST_F(CommandLists, KickInFrame)
+{
+	// the command buffer is full in the middle of the frame, the kick merges the lists first
+	AddCommands(&m_aFrames[0], {1});
+	m_Pool.Add(m_Lists.Add(&m_aFrames[0], m_State, 800, 600, [](IGraphicsCommandList *pCommandList) {
+		pCommandList->RenderBorderTiles(0, ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f), nullptr, vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), 10);
+	}));
+	AddCommands(&m_aFrames[0], {2});
+	m_Lists.Merge(&m_aFrames[0], 0);
+	m_Lists.OnKick(1);
+	EXPECT_EQ(CommandIds(m_aFrames[0]), (std::vector<int>{1, 10, 2}));
+
+	AddCommands(&m_aFrames[1], {3});
+	m_Pool.Add(m_Lists.Add(&m_aFrames[1], m_State, 800, 600, [](IGraphicsCommandList *pCommandList) {
+		pCommandList->RenderBorderTiles(0, ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f), nullptr, vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), 20);
+	}));
+	AddCommands(&m_aFrames[1], {4});
+	m_Lists.Merge(&m_aFrames[1], 1);
+	m_Lists.OnKick(0);
+	EXPECT_EQ(CommandIds(m_aFrames[1]), (std::vector<int>{3, 20, 4}));
+}
@@ -1,7 +1,15 @@
+#include <base/log.h>
+#include <base/mem.h>
+#include <base/time.h>
+
 #include <engine/shared/compression.h>
 
+#include <game/prng.h>
+
 #include <gtest/gtest.h>
 
+#include <vector>
+
 static const int DATA[] = {0, 1, -1, 32, 64, 256, -512, 12345, -123456, 1234567, 12345678, 123456789, 2147483647, (-2147483647 - 1)};
 static const int NUM = std::size(DATA);
 static const int SIZES[NUM] = {1, 1, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4, 5, 5};
@@ -82,3 +90,120 @@ TEST(CVariableInt, DecompressBufferTooSmall)
 	long CompressedSize = CVariableInt::Decompress(aCompressed, sizeof(aCompressed), aUncompressed, sizeof(aUncompressed));
 	ASSERT_EQ(CompressedSize, -1);
 }
+
+// Compress and Decompress only use Pack and Unpack for ints that don't fit
+// into a single byte, the result has to be the same as packing them all.
+static long RefCompress(const int *pSrc, int Num, unsigned char *pDst, int DstSize)
+{
+	unsigned char *pCharDst = pDst;
+	for(int i = 0; i < Num; i++)
+	{
+		pCharDst = CVariableInt::Pack(pCharDst, pSrc[i], pDst + DstSize - pCharDst);
+		if(!pCharDst)
+			return -1;
+	}
+	return pCharDst - pDst;
+}
+
+static long RefDecompress(const unsigned char *pSrc, int SrcSize, int *pDst, int DstSize)
+{
+	const unsigned char *pCharSrc = pSrc;
+	int Num = 0;
+	while(pCharSrc < pSrc + SrcSize)
+	{
+		if(Num >= DstSize / (int)sizeof(int))
+			return -1;
+		pCharSrc = CVariableInt::Unpack(pCharSrc, &pDst[Num], pSrc + SrcSize - pCharSrc);
+		if(!pCharSrc)
+			return -1;
+		Num++;
+	}
+	return Num * sizeof(int);
+}
+
+static int RandomInt(CPrng &Prng)
+{
+	// mostly single byte ints like in snapshot deltas
+	switch(Prng.RandomBits() % 8)
+	{
+	case 0: return (int)Prng.RandomBits();
+	case 1: return (int)(Prng.RandomBits() % 16384) - 8192;
+	default: return (int)(Prng.RandomBits() % 128) - 64;
+	}
+}
+
+TEST(CVariableInt, CompressDecompressFuzz)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x1337, 0xc0ffee};
+	Prng.Seed(aSeed);
+
+	int aInts[200];
+	unsigned char aCompressed[sizeof(aInts) / sizeof(int) * CVariableInt::MAX_BYTES_PACKED];
+	unsigned char aRefCompressed[sizeof(aCompressed)];
+	int aDecompressed[std::size(aInts)];
+	int aRefDecompressed[std::size(aInts)];
+	for(int i = 0; i < 20000; i++)
+	{
+		const int Num = Prng.RandomBits() % (std::size(aInts) + 1);
+		for(int j = 0; j < Num; j++)
+			aInts[j] = RandomInt(Prng);
+
+		// also too small output buffers
+		const int CompressedBufferSize = Prng.RandomBits() % 4 ? sizeof(aCompressed) : Prng.RandomBits() % (sizeof(aCompressed) + 1);
+		const long Size = CVariableInt::Compress(aInts, Num * sizeof(int), aCompressed, CompressedBufferSize);
+		const long RefSize = RefCompress(aInts, Num, aRefCompressed, CompressedBufferSize);
+		ASSERT_EQ(Size, RefSize);
+		if(Size < 0)
+			continue;
+		ASSERT_EQ(mem_comp(aCompressed, aRefCompressed, Size), 0);
+
+		// also invalid and truncated input
+		if(Size > 0 && Prng.RandomBits() % 4 == 0)
+			aCompressed[Prng.RandomBits() % Size] ^= 1 << (Prng.RandomBits() % 8);
+		const int InputSize = Prng.RandomBits() % 4 ? Size : Prng.RandomBits() % (Size + 1);
+		const int DecompressedBufferSize = (Prng.RandomBits() % 4 ? std::size(aDecompressed) : Prng.RandomBits() % (std::size(aDecompressed) + 1)) * sizeof(int);
+		mem_copy(aRefCompressed, aCompressed, Size);
+		const long DecompressedSize = CVariableInt::Decompress(aCompressed, InputSize, aDecompressed, DecompressedBufferSize);
+		ASSERT_EQ(DecompressedSize, RefDecompress(aRefCompressed, InputSize, aRefDecompressed, DecompressedBufferSize));
+		if(DecompressedSize > 0)
+		{
+			ASSERT_EQ(mem_comp(aDecompressed, aRefDecompressed, DecompressedSize), 0);
+		}
+	}
+}
+
+TEST(CVariableInt, BenchmarkCompressDecompress)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {0xfeed, 0xface};
+	Prng.Seed(aSeed);
+
+	std::vector<int> vInts(64 * 1024);
+	for(auto &Int : vInts)
+		Int = RandomInt(Prng);
+	std::vector<unsigned char> vCompressed(vInts.size() * CVariableInt::MAX_BYTES_PACKED);
+	std::vector<int> vDecompressed(vInts.size());
+
+	// run with --no-capture to see the result
+	const int Rounds = 20;
+	long Size = 0;
+	int64_t CompressDuration = 0;
+	int64_t DecompressDuration = 0;
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		int64_t Start = time_get_nanoseconds().count();
+		Size = CVariableInt::Compress(vInts.data(), vInts.size() * sizeof(int), vCompressed.data(), vCompressed.size());
+		CompressDuration += time_get_nanoseconds().count() - Start;
+		ASSERT_GT(Size, 0);
+
+		Start = time_get_nanoseconds().count();
+		const long DecompressedSize = CVariableInt::Decompress(vCompressed.data(), Size, vDecompressed.data(), vDecompressed.size() * sizeof(int));
+		DecompressDuration += time_get_nanoseconds().count() - Start;
+		ASSERT_EQ(DecompressedSize, (long)(vInts.size() * sizeof(int)));
+	}
+	EXPECT_EQ(vDecompressed, vInts);
+
+	const double Bytes = (double)vInts.size() * sizeof(int) * Rounds;
+	log_info("compression", "compress %.1f MB/s, decompress %.1f MB/s (unpacked ints)", Bytes / (CompressDuration / 1e9) / 1e6, Bytes / (DecompressDuration / 1e9) / 1e6);
+}
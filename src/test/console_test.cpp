@@ -0,0 +1,119 @@
+#include <base/str.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Console : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IConsole> m_pConsole = CreateConsole(CFGFLAG_SERVER);
+	std::vector<std::string> m_vCalls;
+
+	static void ConRecord(IConsole::IResult *pResult, void *pUserData)
+	{
+		Console *pSelf = static_cast<Console *>(pUserData);
+		pSelf->m_vCalls.emplace_back(pResult->NumArguments() > 0 ? pResult->GetString(0) : "");
+	}
+
+	static void ConRecordOther(IConsole::IResult *pResult, void *pUserData)
+	{
+		Console *pSelf = static_cast<Console *>(pUserData);
+		pSelf->m_vCalls.emplace_back("other");
+	}
+
+	static void ConChainRecord(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+	{
+		Console *pSelf = static_cast<Console *>(pUserData);
+		pSelf->m_vCalls.emplace_back("chain");
+		pfnCallback(pResult, pCallbackUserData);
+	}
+};
+
+TEST_F(Console, FindCaseInsensitive)
+{
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->ExecuteLine("test_command a", IConsole::CLIENT_ID_UNSPECIFIED);
+	m_pConsole->ExecuteLine("TEST_Command b", IConsole::CLIENT_ID_UNSPECIFIED);
+	m_pConsole->ExecuteLine("test_commands c", IConsole::CLIENT_ID_UNSPECIFIED);
+	m_pConsole->ExecuteLine("test_comman d", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST_F(Console, FindFlags)
+{
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_CLIENT, ConRecordOther, this, "");
+	m_pConsole->ExecuteLine("test_command a", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_TRUE(m_vCalls.empty());
+
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->ExecuteLine("test_command b", IConsole::CLIENT_ID_UNSPECIFIED);
+	m_pConsole->ExecuteLineFlag("test_command c", CFGFLAG_CLIENT, IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"b", "other"}));
+}
+
+TEST_F(Console, RegisterAgain)
+{
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecordOther, this, "");
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->ExecuteLine("test_command a", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"a"}));
+}
+
+TEST_F(Console, Chain)
+{
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->Chain("TEST_COMMAND", ConChainRecord, this);
+	m_pConsole->ExecuteLine("test_command a", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"chain", "a"}));
+}
+
+TEST_F(Console, TempCommands)
+{
+	m_pConsole->Register("test_command", "?r[text]", CFGFLAG_SERVER, ConRecord, this, "");
+	EXPECT_EQ(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, true), nullptr);
+
+	m_pConsole->RegisterTemp("test_command", "", CFGFLAG_SERVER, "");
+	m_pConsole->RegisterTemp("temp_command", "", CFGFLAG_SERVER, "");
+	ASSERT_NE(m_pConsole->GetCommandInfo("TEST_COMMAND", CFGFLAG_SERVER, true), nullptr);
+	ASSERT_NE(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_STREQ(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, true)->Params(), "");
+	EXPECT_STREQ(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, false)->Params(), "?r[text]");
+	EXPECT_EQ(m_pConsole->GetCommandInfo("temp_command", CFGFLAG_CLIENT, true), nullptr);
+
+	// the removed command is reused for the next temporary command
+	m_pConsole->DeregisterTemp("temp_command");
+	EXPECT_EQ(m_pConsole->GetCommandInfo("temp_command", CFGFLAG_SERVER, true), nullptr);
+	m_pConsole->RegisterTemp("other_command", "", CFGFLAG_SERVER, "");
+	EXPECT_EQ(m_pConsole->GetCommandInfo("temp_command", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(m_pConsole->GetCommandInfo("Other_Command", CFGFLAG_SERVER, true), nullptr);
+
+	m_pConsole->DeregisterTempAll();
+	EXPECT_EQ(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(m_pConsole->GetCommandInfo("other_command", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(m_pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, false), nullptr);
+
+	m_pConsole->ExecuteLine("test_command a", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"a"}));
+}
+
+TEST_F(Console, CommandList)
+{
+	m_pConsole->Register("test_b", "", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->Register("test_a", "", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->RegisterTemp("test_c", "", CFGFLAG_SERVER, "");
+	m_pConsole->DeregisterTemp("test_c");
+
+	std::vector<std::string> vNames;
+	for(const IConsole::ICommandInfo *pInfo = m_pConsole->FirstCommandInfo(IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SERVER); pInfo; pInfo = m_pConsole->NextCommandInfo(pInfo, IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SERVER))
+	{
+		if(str_startswith(pInfo->Name(), "test_"))
+			vNames.emplace_back(pInfo->Name());
+	}
+	EXPECT_EQ(vNames, (std::vector<std::string>{"test_a", "test_b"}));
+}
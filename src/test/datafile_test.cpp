@@ -1,6 +1,10 @@
 #include "test.h"
 
+#include <base/mem.h>
+#include <base/str.h>
+
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <game/mapitems_ex.h>
@@ -8,6 +12,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +117,53 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, ParallelCompressionIsDeterministic)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+	char aParallelFilename[IO_MAX_PATH_LENGTH];
+	str_format(aParallelFilename, sizeof(aParallelFilename), "%s.parallel", Info.m_aFilename);
+
+	std::vector<std::vector<int>> vvData;
+	for(int i = 0; i < 50; i++)
+	{
+		std::vector<int> &vData = vvData.emplace_back((i % 7 + 1) * 1000);
+		for(size_t j = 0; j < vData.size(); j++)
+			vData[j] = (j * (i + 1)) % 97;
+	}
+
+	CJobPool JobPool;
+	JobPool.Init(3);
+	SHA256_DIGEST aSha256[2];
+	for(int Parallel = 0; Parallel < 2; Parallel++)
+	{
+		const char *pFilename = Parallel ? aParallelFilename : Info.m_aFilename;
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), pFilename));
+		const int Item = 1;
+		Writer.AddItem(MAPITEMTYPE_TEST, 0, sizeof(Item), &Item);
+		for(const std::vector<int> &vData : vvData)
+			Writer.AddData(vData.size() * sizeof(int), vData.data(), vData.size() % 2 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT);
+		Writer.Finish(Parallel ? &JobPool : nullptr);
+
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), pFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(int i = 0; i < Reader.NumData(); i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)), 0);
+		}
+		aSha256[Parallel] = Reader.Sha256();
+	}
+	EXPECT_EQ(aSha256[0], aSha256[1]);
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aParallelFilename, IStorage::TYPE_SAVE);
+	}
+}
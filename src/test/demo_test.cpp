@@ -0,0 +1,185 @@
+#include "test.h"
+
+#include <base/io.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+class DemoKeyFrameIndex : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	std::unique_ptr<IStorage> m_pStorage;
+	rust::Box<CSnapshotDelta> m_pDelta = CSnapshotDelta_New();
+	const char *m_pFilename = "test.demo";
+
+	// snapshots further apart than the keyframe interval are all recorded as
+	// keyframes, which doesn't need a snapshot delta
+	static constexpr int TICK_STEP = SERVER_TICK_SPEED * 5 + 1;
+
+	DemoKeyFrameIndex()
+	{
+		CNetBase::Init();
+		m_Info.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_Info.CreateTestStorage();
+	}
+
+	void Record(int FirstTick, int NumSnapshots)
+	{
+		ASSERT_TRUE(m_pStorage);
+		unsigned char aMapData[] = {1, 2, 3, 4};
+		int32_t aSnapshot[2] = {}; // empty snapshot
+		int32_t aMessage[4] = {1, 2, 3, 4};
+
+		CDemoRecorder Recorder(&*m_pDelta);
+		ASSERT_EQ(Recorder.Start(m_pStorage.get(), nullptr, m_pFilename, "0.6 626fce9a778df4d4", "test", {}, 0, "client", sizeof(aMapData), aMapData, nullptr, nullptr, nullptr), 0);
+		for(int i = 0; i < NumSnapshots; i++)
+		{
+			Recorder.RecordSnapshot(FirstTick + i * TICK_STEP, aSnapshot, sizeof(aSnapshot));
+			aMessage[0] = i;
+			Recorder.RecordMessage(aMessage, sizeof(aMessage));
+		}
+		ASSERT_EQ(Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE), 0);
+	}
+
+	void Truncate(int Bytes)
+	{
+		IOHANDLE File = m_pStorage->OpenFile(m_pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		std::vector<unsigned char> vData(io_length(File));
+		ASSERT_EQ(io_read(File, vData.data(), vData.size()), vData.size());
+		io_close(File);
+
+		File = m_pStorage->OpenFile(m_pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		io_write(File, vData.data(), vData.size() - Bytes);
+		io_close(File);
+	}
+
+	void ExpectLoad(bool KeyFrameIndex, int FirstTick, int LastTick)
+	{
+		CDemoPlayer Player(&*m_pDelta, &*m_pDelta, false);
+		ASSERT_EQ(Player.Load(m_pStorage.get(), nullptr, m_pFilename, IStorage::TYPE_SAVE), 0);
+		EXPECT_EQ(Player.Info()->m_KeyFrameIndex, KeyFrameIndex);
+		EXPECT_EQ(Player.BaseInfo()->m_FirstTick, FirstTick);
+		EXPECT_EQ(Player.BaseInfo()->m_LastTick, LastTick);
+		Player.Stop();
+	}
+};
+
+TEST_F(DemoKeyFrameIndex, Load)
+{
+	Record(100, 10);
+	ExpectLoad(true, 100, 100 + 9 * TICK_STEP);
+}
+
+TEST_F(DemoKeyFrameIndex, MultipleIndexChunks)
+{
+	Record(100, 2500);
+	ExpectLoad(true, 100, 100 + 2499 * TICK_STEP);
+}
+
+TEST_F(DemoKeyFrameIndex, TruncatedFallsBackToScan)
+{
+	Record(100, 10);
+	Truncate(1);
+	ExpectLoad(false, 100, 100 + 9 * TICK_STEP);
+}
+
+class CCallRecorder : public CDemoPlayer::IListener
+{
+public:
+	// snapshots start with 'S', messages with 'M'
+	std::vector<std::vector<unsigned char>> m_vCalls;
+
+	void Add(unsigned char Type, const void *pData, int Size)
+	{
+		std::vector<unsigned char> &Call = m_vCalls.emplace_back(1, Type);
+		Call.insert(Call.end(), (const unsigned char *)pData, (const unsigned char *)pData + Size);
+	}
+	void OnDemoPlayerSnapshot(void *pData, int Size) override { Add('S', pData, Size); }
+	void OnDemoPlayerMessage(void *pData, int Size) override { Add('M', pData, Size); }
+};
+
+// seeks back once from inside a listener call, in the middle of a tick
+class CSeekingCallRecorder : public CCallRecorder
+{
+public:
+	CDemoPlayer *m_pPlayer = nullptr;
+	size_t m_SeekAtCall;
+	int m_SeekTick;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		CCallRecorder::OnDemoPlayerSnapshot(pData, Size);
+		if(m_vCalls.size() == m_SeekAtCall)
+		{
+			EXPECT_TRUE(m_pPlayer->SetPos(m_SeekTick));
+		}
+	}
+};
+
+class DemoReadAhead : public DemoKeyFrameIndex
+{
+protected:
+	std::vector<std::vector<unsigned char>> Play(bool ReadAhead, int SeekTick, size_t ListenerSeekAtCall = 0, int ListenerSeekTick = 0)
+	{
+		CSeekingCallRecorder Calls;
+		Calls.m_SeekAtCall = ListenerSeekAtCall;
+		Calls.m_SeekTick = ListenerSeekTick;
+		CDemoPlayer Player(&*m_pDelta, &*m_pDelta, false);
+		Calls.m_pPlayer = &Player;
+		Player.SetListener(&Calls);
+		Player.SetReadAhead(ReadAhead);
+		EXPECT_EQ(Player.Load(m_pStorage.get(), nullptr, m_pFilename, IStorage::TYPE_SAVE), 0);
+		Player.Play();
+		// without real time, everything until the end is played at once
+		Player.Update(false);
+		EXPECT_TRUE(Player.BaseInfo()->m_Paused);
+		EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, Player.BaseInfo()->m_LastTick);
+
+		if(SeekTick >= 0)
+		{
+			EXPECT_TRUE(Player.SetPos(SeekTick));
+			EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, SeekTick);
+			Player.Unpause();
+			Player.Update(false);
+			EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, Player.BaseInfo()->m_LastTick);
+		}
+		EXPECT_TRUE(Player.IsPlaying());
+		Player.Stop();
+
+		return Calls.m_vCalls;
+	}
+};
+
+TEST_F(DemoReadAhead, SameCallsAsSynchronous)
+{
+	Record(100, 300);
+	const std::vector<std::vector<unsigned char>> vExpected = Play(false, -1);
+	EXPECT_EQ(vExpected.size(), 300 * 2);
+	EXPECT_EQ(Play(true, -1), vExpected);
+}
+
+TEST_F(DemoReadAhead, SameCallsAfterSeek)
+{
+	Record(100, 300);
+	const std::vector<std::vector<unsigned char>> vExpected = Play(false, 100 + 150 * TICK_STEP);
+	EXPECT_GT(vExpected.size(), 300 * 2);
+	EXPECT_EQ(Play(true, 100 + 150 * TICK_STEP), vExpected);
+}
+
+TEST_F(DemoReadAhead, SameCallsAfterSeekFromListener)
+{
+	Record(100, 300);
+	const std::vector<std::vector<unsigned char>> vExpected = Play(false, -1, 2 * 200 + 1, 100 + 50 * TICK_STEP);
+	EXPECT_GT(vExpected.size(), 300 * 2);
+	EXPECT_EQ(Play(true, -1, 2 * 200 + 1, 100 + 50 * TICK_STEP), vExpected);
+}
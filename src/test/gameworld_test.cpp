@@ -16,7 +16,10 @@
 
 #include <generated/protocol.h>
 
+#include <game/prng.h>
 #include <game/server/entities/character.h>
+#include <game/server/entities/laser.h>
+#include <game/server/entities/pickup.h>
 #include <game/server/gamecontext.h>
 #include <game/server/gamecontroller.h>
 #include <game/server/gameworld.h>
@@ -25,8 +28,10 @@
 
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <memory>
 #include <thread>
+#include <vector>
 
 bool IsInterrupted()
 {
@@ -251,6 +256,123 @@ TEST_F(CTestGameWorld, IntersectEntity)
 	EXPECT_EQ(pIntersectedChar, pChrRight);
 }
 
+TEST_F(CTestGameWorld, FindEntitiesMatchesLinearSearch)
+{
+	CNetObj_PlayerInput Input = {};
+	for(int i = 0; i < 48; i++)
+	{
+		CCharacter *pChr = new(i) CCharacter(&GameServer()->m_World, Input);
+		pChr->m_Pos = vec2((i % 8) * 300.0f, (i / 8) * 300.0f);
+		GameServer()->m_World.InsertEntity(pChr);
+	}
+
+	auto &&CheckFindEntities = [&](vec2 Pos, float Radius) {
+		std::vector<CEntity *> vpExpected;
+		for(CEntity *pEnt = GameServer()->m_World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->GetProximityRadius())
+				vpExpected.push_back(pEnt);
+
+		CEntity *apEnts[MAX_CLIENTS];
+		const int Num = GameServer()->m_World.FindEntities(Pos, Radius, apEnts, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
+		EXPECT_EQ(std::vector<CEntity *>(apEnts, apEnts + Num), vpExpected);
+	};
+
+	CheckFindEntities(vec2(0, 0), 100.0f);
+	CheckFindEntities(vec2(450, 450), 400.0f);
+	CheckFindEntities(vec2(1050, 1500), 650.0f);
+	CheckFindEntities(vec2(-5000, -5000), 100.0f);
+	CheckFindEntities(vec2(1000, 1000), 10000.0f);
+
+	// positions are written directly, the world has to pick the change up
+	CCharacter *pMoved = (CCharacter *)GameServer()->m_World.FindFirst(CGameWorld::ENTTYPE_CHARACTER);
+	pMoved->m_Pos = vec2(-5000, -5000);
+	CheckFindEntities(vec2(-5000, -5000), 100.0f);
+	CheckFindEntities(vec2(2100, 1500), 100.0f);
+	EXPECT_EQ(GameServer()->m_World.ClosestCharacter(vec2(-4990, -4990), 50.0f, nullptr), pMoved);
+}
+
+TEST_F(CTestGameWorld, SnapCullingMatchesAllEntities)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+	Prng.Seed(aSeed);
+	auto &&RandomCoord = [&]() {
+		return (float)(Prng.RandomBits() % 8000) - 2000.0f;
+	};
+
+	for(int i = 0; i < 96; i++)
+	{
+		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_HEALTH, 0, 0, 0, 0);
+		pPickup->m_Pos = vec2(RandomCoord(), RandomCoord());
+	}
+	// lasers span more than one cell
+	for(int i = 0; i < 4; i++)
+		new CLaser(&GameServer()->m_World, vec2(RandomCoord(), RandomCoord()), direction(i * 1.3f), 3000.0f, -1, WEAPON_LASER);
+
+	bool Afk = true;
+	int LastWhisperTo = -1;
+	GameServer()->CreatePlayer(0, TEAM_GAME, Afk, LastWhisperTo);
+	CPlayer *pPlayer = GameServer()->m_apPlayers[0];
+
+	std::unique_ptr<CSnapshotBuffer> pCulled = CSnapshotBuffer_New();
+	std::unique_ptr<CSnapshotBuffer> pAll = CSnapshotBuffer_New();
+	for(int i = 0; i < 32; i++)
+	{
+		pPlayer->m_ViewPos = vec2(RandomCoord(), RandomCoord());
+		pPlayer->m_ShowAll = false;
+
+		m_pServer->m_pSnapshotBuilder->Init(false);
+		GameServer()->m_World.Snap(0);
+		const int CulledSize = m_pServer->m_pSnapshotBuilder->Finish(*pCulled);
+
+		// every entity checks its own visibility, in the order the world snaps them
+		m_pServer->m_pSnapshotBuilder->Init(false);
+		for(CEntity *pEnt = GameServer()->m_World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			pEnt->Snap(0);
+		for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+		{
+			if(Type == CGameWorld::ENTTYPE_CHARACTER)
+				continue;
+			for(CEntity *pEnt = GameServer()->m_World.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+				pEnt->Snap(0);
+		}
+		const int AllSize = m_pServer->m_pSnapshotBuilder->Finish(*pAll);
+
+		ASSERT_EQ(CulledSize, AllSize) << "view (" << pPlayer->m_ViewPos.x << ", " << pPlayer->m_ViewPos.y << ")";
+		EXPECT_EQ(mem_comp(pCulled->m_aData, pAll->m_aData, CulledSize), 0) << "view (" << pPlayer->m_ViewPos.x << ", " << pPlayer->m_ViewPos.y << ")";
+	}
+}
+
+TEST(SpatialGrid, MaxRadiusShrinks)
+{
+	struct CEnt
+	{
+		CSpatialGrid<CEnt>::CNode m_Node;
+	};
+	CSpatialGrid<CEnt> Grid;
+	CEnt aSmall[64];
+	CEnt Large;
+	for(int i = 0; i < 64; i++)
+		Grid.Insert(&aSmall[i].m_Node, &aSmall[i], i, vec2(i * 100.0f, 0.0f), 10.0f);
+	Grid.Insert(&Large.m_Node, &Large, 64, vec2(0.0f, 0.0f), 5000.0f);
+	EXPECT_EQ(Grid.MaxRadius(), 5000.0f);
+
+	// a large radius makes small queries cover too many cells
+	auto &&NoCallback = [](const CSpatialGrid<CEnt>::CNode *) {};
+	EXPECT_FALSE(Grid.Query(vec2(0.0f, 0.0f), vec2(10.0f, 10.0f), NoCallback));
+
+	Grid.Move(&Large.m_Node, vec2(0.0f, 0.0f), 20.0f);
+	EXPECT_EQ(Grid.MaxRadius(), 20.0f);
+	Grid.Remove(&Large.m_Node);
+	EXPECT_EQ(Grid.MaxRadius(), 10.0f);
+	EXPECT_TRUE(Grid.Query(vec2(0.0f, 0.0f), vec2(10.0f, 10.0f), NoCallback));
+
+	for(auto &Small : aSmall)
+		Grid.Remove(&Small.m_Node);
+	EXPECT_EQ(Grid.MaxRadius(), 0.0f);
+	EXPECT_EQ(Grid.Size(), 0);
+}
+
 TEST_F(CTestGameWorld, BasicTick)
 {
 	int ClientId = 0;
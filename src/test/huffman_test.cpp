@@ -1,9 +1,16 @@
+#include <base/log.h>
 #include <base/mem.h>
+#include <base/time.h>
 
+#include <engine/shared/compression.h>
 #include <engine/shared/huffman.h>
 
+#include <game/prng.h>
+
 #include <gtest/gtest.h>
 
+#include <vector>
+
 TEST(Huffman, CompressionShouldNotChangeData)
 {
 	CHuffman Huffman;
@@ -47,3 +54,111 @@ TEST(Huffman, CompressionCompatible)
 	EXPECT_EQ(match, 0) << "The compression is not compatible with older/other implementations anymore";
 	EXPECT_EQ(Size, 15);
 }
+
+TEST(Huffman, DecompressionRoundTrip)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x1234, 0x5678};
+	Prng.Seed(aSeed);
+
+	unsigned char aInput[1400];
+	unsigned char aCompressed[2048];
+	unsigned char aDecompressed[1400];
+	for(int i = 0; i < 2000; i++)
+	{
+		// mostly zeros like snapshot deltas, sometimes all kinds of bytes
+		const int Size = Prng.RandomBits() % sizeof(aInput);
+		const unsigned Range = i % 2 ? 256 : 16;
+		for(int b = 0; b < Size; b++)
+			aInput[b] = Prng.RandomBits() % 3 ? 0 : Prng.RandomBits() % Range;
+
+		const int CompressedSize = Huffman.Compress(aInput, Size, aCompressed, sizeof(aCompressed));
+		ASSERT_GT(CompressedSize, 0);
+		ASSERT_EQ(Huffman.Decompress(aCompressed, CompressedSize, aDecompressed, sizeof(aDecompressed)), Size);
+		ASSERT_EQ(mem_comp(aInput, aDecompressed, Size), 0);
+
+		// exactly fitting and too small output buffers
+		EXPECT_EQ(Huffman.Decompress(aCompressed, CompressedSize, aDecompressed, Size), Size);
+		if(Size > 0)
+		{
+			EXPECT_EQ(Huffman.Decompress(aCompressed, CompressedSize, aDecompressed, Size - 1), -1);
+		}
+	}
+}
+
+static void CreatePacketCorpus(CHuffman &Huffman, std::vector<std::vector<unsigned char>> &vCorpus, int *pTotalSize)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {0xdead, 0xbeef};
+	Prng.Seed(aSeed);
+
+	*pTotalSize = 0;
+	for(int Packet = 0; Packet < 512; Packet++)
+	{
+		// snapshot deltas: item keys followed by mostly unchanged fields and
+		// small position changes; inputs: a few small values
+		int aInts[300];
+		int NumInts = 0;
+		if(Packet % 4 != 3)
+		{
+			const int NumItems = 1 + Prng.RandomBits() % 20;
+			for(int Item = 0; Item < NumItems; Item++)
+			{
+				aInts[NumInts++] = Prng.RandomBits() % 24;
+				aInts[NumInts++] = Prng.RandomBits() % 64;
+				for(int Field = 0; Field < 12; Field++)
+				{
+					const unsigned Kind = Prng.RandomBits() % 8;
+					aInts[NumInts++] = Kind < 5 ? 0 : (Kind < 7 ? (int)(Prng.RandomBits() % 65) - 32 : (int)Prng.RandomBits());
+				}
+			}
+		}
+		else
+		{
+			for(int Field = 0; Field < 10; Field++)
+				aInts[NumInts++] = Field < 2 ? (int)(Prng.RandomBits() % 2048) - 1024 : (int)(Prng.RandomBits() % 4);
+		}
+
+		unsigned char aPacked[sizeof(aInts) * 2];
+		const long PackedSize = CVariableInt::Compress(aInts, NumInts * sizeof(int), aPacked, sizeof(aPacked));
+		ASSERT_GT(PackedSize, 0);
+		*pTotalSize += PackedSize;
+
+		std::vector<unsigned char> vCompressed(PackedSize * 2 + 16);
+		const int CompressedSize = Huffman.Compress(aPacked, PackedSize, vCompressed.data(), vCompressed.size());
+		ASSERT_GT(CompressedSize, 0);
+		vCompressed.resize(CompressedSize);
+		vCorpus.push_back(std::move(vCompressed));
+	}
+}
+
+TEST(Huffman, BenchmarkDecompress)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	std::vector<std::vector<unsigned char>> vCorpus;
+	int TotalSize;
+	CreatePacketCorpus(Huffman, vCorpus, &TotalSize);
+
+	// run with --no-capture to see the result
+	unsigned char aDecompressed[2048];
+	int Decompressed = 0;
+	const int64_t Start = time_get_nanoseconds().count();
+	const int Rounds = 50;
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		for(const auto &vPacket : vCorpus)
+		{
+			const int Size = Huffman.Decompress(vPacket.data(), vPacket.size(), aDecompressed, sizeof(aDecompressed));
+			ASSERT_GT(Size, 0);
+			Decompressed += Size;
+		}
+	}
+	const int64_t Duration = time_get_nanoseconds().count() - Start;
+	EXPECT_EQ(Decompressed, TotalSize * Rounds);
+	log_info("huffman", "decompressed %d bytes in %.2f ms, %.1f MB/s", Decompressed, Duration / 1e6, Decompressed / (Duration / 1e9) / 1e6);
+}
@@ -54,3 +54,58 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+TEST(Net, BatchedSendKeepsPackets)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	// runs of equally sized packets can be sent as one segmented datagram,
+	// more packets than fit into the queue flush it in between
+	const int NumPackets = 140;
+	auto &&PacketSize = [](int i) { return i % 10 == 9 ? 37 : 100 + (i / 10) * 10; };
+	NETSTATS StatsBefore;
+	net_stats(&StatsBefore);
+	net_udp_set_batching(Socket2, true);
+	for(int i = 0; i < NumPackets; i++)
+	{
+		unsigned char aData[256];
+		for(int b = 0; b < PacketSize(i); b++)
+			aData[b] = i + b;
+		EXPECT_EQ(net_udp_send(Socket2, &Target, aData, PacketSize(i)), PacketSize(i));
+	}
+	net_udp_flush(Socket2);
+#if defined(CONF_PLATFORM_LINUX)
+	NETSTATS StatsAfter;
+	net_stats(&StatsAfter);
+	EXPECT_LE(StatsAfter.sent_syscalls - StatsBefore.sent_syscalls, 2u);
+#endif
+
+	for(int i = 0; i < NumPackets; i++)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		// several packets are received at once, only wait when none is left
+		while((Bytes = net_udp_recv(Socket1, &Addr, &pData)) <= 0)
+			ASSERT_EQ(net_socket_read_wait(Socket1, 10s), 1);
+		ASSERT_EQ(Bytes, PacketSize(i)) << i;
+		for(int b = 0; b < PacketSize(i); b++)
+			ASSERT_EQ(pData[b], (unsigned char)(i + b)) << i;
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
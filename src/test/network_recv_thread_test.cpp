@@ -0,0 +1,84 @@
+#include <base/mem.h>
+#include <base/net.h>
+#include <base/secure.h>
+
+#include <engine/shared/network.h>
+#include <engine/shared/network_recv_thread.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+static const CNetRecvThread::CPacket *WaitForPacket(CNetRecvThread &RecvThread)
+{
+	const CNetRecvThread::CPacket *pPacket;
+	while(!(pPacket = RecvThread.Receive()))
+	{
+		if(!RecvThread.Wait(10s))
+			return nullptr;
+	}
+	return pPacket;
+}
+
+TEST(NetRecvThread, UnpacksPackets)
+{
+	CNetBase::Init();
+
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	CNetRecvThread RecvThread;
+	RecvThread.Start(Socket1);
+
+	CNetBase::SendPacketConnless(Socket2, &Target, "hello", 5, false, nullptr);
+
+	// repetitive enough to be sent compressed
+	CNetPacketConstruct Construct = {};
+	Construct.m_Ack = 5;
+	Construct.m_NumChunks = 1;
+	Construct.m_DataSize = 200;
+	for(int i = 0; i < Construct.m_DataSize; i++)
+		Construct.m_aChunkData[i] = i % 4;
+	CNetPacketConstruct Sent = Construct;
+	CNetBase::SendPacket(Socket2, &Target, &Sent, NET_SECURITY_TOKEN_UNSUPPORTED, false);
+	EXPECT_NE(Sent.m_Flags & NET_PACKETFLAG_COMPRESSION, 0);
+
+	const CNetRecvThread::CPacket *pPacket = WaitForPacket(RecvThread);
+	ASSERT_NE(pPacket, nullptr);
+	ASSERT_TRUE(pPacket->m_Decoded);
+	EXPECT_EQ(pPacket->m_Result, 0);
+	EXPECT_FALSE(pPacket->m_Sixup);
+	EXPECT_EQ(pPacket->m_Packet.m_Flags, NET_PACKETFLAG_CONNLESS);
+	ASSERT_EQ(pPacket->m_Packet.m_DataSize, 5);
+	EXPECT_EQ(mem_comp(pPacket->m_Packet.m_aChunkData, "hello", 5), 0);
+
+	pPacket = WaitForPacket(RecvThread);
+	ASSERT_NE(pPacket, nullptr);
+	ASSERT_TRUE(pPacket->m_Decoded);
+	EXPECT_EQ(pPacket->m_Result, 0);
+	EXPECT_EQ(pPacket->m_Packet.m_Flags, NET_PACKETFLAG_COMPRESSION);
+	EXPECT_EQ(pPacket->m_Packet.m_Ack, 5);
+	EXPECT_EQ(pPacket->m_Packet.m_NumChunks, 1);
+	ASSERT_EQ(pPacket->m_Packet.m_DataSize, Construct.m_DataSize);
+	EXPECT_EQ(mem_comp(pPacket->m_Packet.m_aChunkData, Construct.m_aChunkData, Construct.m_DataSize), 0);
+
+	RecvThread.Stop();
+	EXPECT_TRUE(RecvThread.Empty());
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
@@ -0,0 +1,199 @@
+#include <test/test.h>
+
+#include <base/mem.h>
+
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapbugs.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class CTestPredictionWorld : public ::testing::Test
+{
+public:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IStorage> m_pStorage;
+	CMap m_Map;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CMapBugs m_MapBugs;
+	CTuningParams m_aTuningList[TuneZone::NUM];
+	CGameWorld m_World;
+	CPrng m_Prng;
+
+	CTestPredictionWorld()
+	{
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		EXPECT_NE(m_pStorage, nullptr);
+		EXPECT_TRUE(m_Map.Load(m_pStorage.get(), "maps/coverage.map", IStorage::TYPE_ALL));
+		m_Layers.Init(&m_Map, true);
+		m_Collision.Init(&m_Layers);
+		m_MapBugs = CMapBugs::Create(m_Map.BaseName(), m_Map.Size(), m_Map.Sha256());
+
+		m_World.Init(&m_Collision, m_aTuningList, &m_MapBugs);
+		m_World.m_WorldConfig.m_IsDDRace = true;
+		m_World.m_WorldConfig.m_IsVanilla = false;
+		m_World.m_WorldConfig.m_IsFNG = false;
+		m_World.m_WorldConfig.m_InfiniteAmmo = true;
+		m_World.m_WorldConfig.m_PredictTiles = true;
+		m_World.m_WorldConfig.m_PredictFreeze = 1;
+		m_World.m_WorldConfig.m_PredictWeapons = true;
+		m_World.m_WorldConfig.m_PredictDDRace = true;
+		m_World.m_WorldConfig.m_IsSolo = false;
+		m_World.m_WorldConfig.m_UseTuneZones = false;
+		m_World.m_WorldConfig.m_BugDDRaceInput = false;
+		m_World.m_WorldConfig.m_NoWeakHookAndBounce = false;
+		m_World.m_WorldConfig.m_PredictEvents = false;
+
+		uint64_t aSeed[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+		m_Prng.Seed(aSeed);
+	}
+
+	float RandomCoord(float Size)
+	{
+		return (float)(m_Prng.RandomBits() % (unsigned)(Size + 256.0f)) - 128.0f;
+	}
+
+	vec2 RandomPos()
+	{
+		return vec2(RandomCoord(m_Collision.GetWidth() * 32.0f), RandomCoord(m_Collision.GetHeight() * 32.0f));
+	}
+
+	// a snapshot with characters all over the map
+	void AddCharacters(int Num)
+	{
+		m_World.NetObjBegin(CTeamsCore(), 0);
+		for(int i = 0; i < Num; i++)
+		{
+			CNetObj_Character Char;
+			mem_zero(&Char, sizeof(Char));
+			const vec2 Pos = RandomPos();
+			Char.m_X = round_to_int(Pos.x);
+			Char.m_Y = round_to_int(Pos.y);
+			Char.m_Weapon = WEAPON_GUN;
+			Char.m_Health = 10;
+			Char.m_Emote = EMOTE_NORMAL;
+			Char.m_HookedPlayer = -1;
+			m_World.NetCharAdd(i, &Char, nullptr, 0, i == 0);
+		}
+		m_World.NetObjEnd();
+	}
+
+	std::vector<CEntity *> BruteForceFindEntities(vec2 Pos, float Radius, int Max, int Type)
+	{
+		std::vector<CEntity *> vpEnts;
+		for(CEntity *pEnt = m_World.FindFirst(Type); pEnt && (int)vpEnts.size() < Max; pEnt = pEnt->TypeNext())
+			if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
+				vpEnts.push_back(pEnt);
+		return vpEnts;
+	}
+
+	CCharacter *BruteForceIntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, const CCharacter *pNotThis, int CollideWith)
+	{
+		float ClosestLen = distance(Pos0, Pos1) * 100.0f;
+		CCharacter *pClosest = nullptr;
+		for(CEntity *pEnt = m_World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		{
+			if(pEnt == pNotThis || (CollideWith != -1 && !pEnt->CanCollide(CollideWith)))
+				continue;
+			vec2 IntersectPos;
+			if(closest_point_on_line(Pos0, Pos1, pEnt->m_Pos, IntersectPos) && distance(pEnt->m_Pos, IntersectPos) < pEnt->m_ProximityRadius + Radius)
+			{
+				const float Len = distance(Pos0, IntersectPos);
+				if(Len < ClosestLen)
+				{
+					NewPos = IntersectPos;
+					ClosestLen = Len;
+					pClosest = (CCharacter *)pEnt;
+				}
+			}
+		}
+		return pClosest;
+	}
+
+	void ExpectQueriesMatchBruteForce()
+	{
+		for(int i = 0; i < 500; i++)
+		{
+			const vec2 Pos = RandomPos();
+			// mostly small radii like explosions and hammer hits, sometimes larger than the map
+			const float Radius = i % 10 == 0 ? (float)(m_Prng.RandomBits() % 20000) : (float)(m_Prng.RandomBits() % 400);
+			const int Max = i % 3 == 0 ? 1 + m_Prng.RandomBits() % 4 : (int)MAX_CLIENTS;
+			CEntity *apEnts[MAX_CLIENTS];
+			const int Num = m_World.FindEntities(Pos, Radius, apEnts, Max, CGameWorld::ENTTYPE_CHARACTER);
+			EXPECT_EQ(std::vector<CEntity *>(apEnts, apEnts + Num), BruteForceFindEntities(Pos, Radius, Max, CGameWorld::ENTTYPE_CHARACTER))
+				<< "Pos=(" << Pos.x << ", " << Pos.y << ") Radius=" << Radius << " Max=" << Max;
+
+			const vec2 Pos1 = i % 4 == 0 ? RandomPos() : Pos + direction(m_Prng.RandomBits() % 628 / 100.0f) * (float)(m_Prng.RandomBits() % 800);
+			const float LineRadius = (float)(m_Prng.RandomBits() % 8);
+			CCharacter *pNotThis = m_World.GetCharacterById(m_Prng.RandomBits() % MAX_CLIENTS);
+			const int CollideWith = i % 2 == 0 ? -1 : (int)(m_Prng.RandomBits() % MAX_CLIENTS);
+			vec2 NewPos = vec2(-1.0f, -1.0f);
+			vec2 ExpectedNewPos = vec2(-1.0f, -1.0f);
+			CCharacter *pHit = m_World.IntersectCharacter(Pos, Pos1, LineRadius, NewPos, pNotThis, CollideWith);
+			CCharacter *pExpectedHit = BruteForceIntersectCharacter(Pos, Pos1, LineRadius, ExpectedNewPos, pNotThis, CollideWith);
+			EXPECT_EQ(pHit, pExpectedHit) << "from (" << Pos.x << ", " << Pos.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+			EXPECT_EQ(NewPos, ExpectedNewPos) << "from (" << Pos.x << ", " << Pos.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+
+			if(::testing::Test::HasFailure())
+				return;
+		}
+	}
+};
+
+TEST_F(CTestPredictionWorld, QueriesMatchBruteForce)
+{
+	AddCharacters(MAX_CLIENTS);
+	ExpectQueriesMatchBruteForce();
+}
+
+TEST_F(CTestPredictionWorld, QueriesMatchBruteForceAfterMoving)
+{
+	AddCharacters(MAX_CLIENTS);
+	ExpectQueriesMatchBruteForce();
+
+	// positions are written directly, the world has to pick the changes up
+	for(CEntity *pEnt = m_World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		if(m_Prng.RandomBits() % 2)
+			pEnt->m_Pos = RandomPos();
+	ExpectQueriesMatchBruteForce();
+
+	// and move while ticking
+	for(int Tick = 1; Tick <= 50; Tick++)
+	{
+		m_World.m_GameTick = Tick;
+		m_World.Tick();
+	}
+	ExpectQueriesMatchBruteForce();
+}
+
+TEST_F(CTestPredictionWorld, QueriesMatchBruteForceInCopy)
+{
+	AddCharacters(MAX_CLIENTS / 2);
+	CGameWorld Copy;
+	Copy.CopyWorld(&m_World);
+	for(CEntity *pEnt = Copy.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		pEnt->m_Pos = RandomPos();
+
+	// the copy has its own grid, the original keeps its positions
+	ExpectQueriesMatchBruteForce();
+	for(CEntity *pEnt = Copy.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+	{
+		CEntity *apEnts[MAX_CLIENTS];
+		const int Num = Copy.FindEntities(pEnt->m_Pos, 1.0f, apEnts, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
+		EXPECT_NE(std::find(apEnts, apEnts + Num, pEnt), apEnts + Num);
+	}
+}
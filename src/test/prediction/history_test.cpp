@@ -0,0 +1,260 @@
+#include <test/test.h>
+
+#include <base/mem.h>
+
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/client/prediction/history.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapbugs.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+static const int NUM_CHARACTERS = 8;
+static const int NUM_PREDICTED_TICKS = 6;
+
+// like the client: the gameworld follows the snapshots, and the predicted world is copied from it
+// or continued, depending on what the prediction history allows
+class CTestPredictionHistory : public ::testing::Test
+{
+public:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IStorage> m_pStorage;
+	CMap m_Map;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CMapBugs m_MapBugs;
+	CTuningParams m_aTuningList[TuneZone::NUM];
+	CGameWorld m_GameWorld;
+	CGameWorld m_PredictedWorld;
+	// the snapshots are taken from it
+	CGameWorld m_ServerWorld;
+	CPredictionHistory m_History;
+	CPredictionHistory::CSettings m_Settings;
+	int m_GameTick = 0;
+	int m_NumPredictedTicks = 0;
+
+	CTestPredictionHistory()
+	{
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		EXPECT_NE(m_pStorage, nullptr);
+		EXPECT_TRUE(m_Map.Load(m_pStorage.get(), "maps/coverage.map", IStorage::TYPE_ALL));
+		m_Layers.Init(&m_Map, true);
+		m_Collision.Init(&m_Layers);
+		m_MapBugs = CMapBugs::Create(m_Map.BaseName(), m_Map.Size(), m_Map.Sha256());
+
+		m_GameWorld.Init(&m_Collision, m_aTuningList, &m_MapBugs);
+		m_GameWorld.m_WorldConfig.m_IsDDRace = true;
+		m_GameWorld.m_WorldConfig.m_IsVanilla = false;
+		m_GameWorld.m_WorldConfig.m_IsFNG = false;
+		m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
+		m_GameWorld.m_WorldConfig.m_PredictTiles = true;
+		m_GameWorld.m_WorldConfig.m_PredictFreeze = 1;
+		m_GameWorld.m_WorldConfig.m_PredictWeapons = true;
+		m_GameWorld.m_WorldConfig.m_PredictDDRace = true;
+		m_GameWorld.m_WorldConfig.m_IsSolo = false;
+		m_GameWorld.m_WorldConfig.m_UseTuneZones = false;
+		m_GameWorld.m_WorldConfig.m_BugDDRaceInput = false;
+		m_GameWorld.m_WorldConfig.m_NoWeakHookAndBounce = false;
+		m_GameWorld.m_WorldConfig.m_PredictEvents = false;
+
+		m_GameWorld.NetObjBegin(CTeamsCore(), 0);
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_Character Char;
+			mem_zero(&Char, sizeof(Char));
+			Char.m_X = 32 * (10 + 3 * i) + 16;
+			Char.m_Y = 32 * 10 + 16;
+			Char.m_Weapon = i % 2 ? WEAPON_GUN : WEAPON_GRENADE;
+			Char.m_Health = 10;
+			Char.m_Emote = EMOTE_NORMAL;
+			Char.m_HookedPlayer = -1;
+			m_GameWorld.NetCharAdd(i, &Char, nullptr, 0, i == 0);
+		}
+		m_GameWorld.NetObjEnd();
+		m_ServerWorld.CopyWorld(&m_GameWorld);
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
+	}
+
+	// inputs only depend on the tick, so predicting a tick again gives the same result
+	static void TickWorld(CGameWorld *pWorld, int Tick)
+	{
+		CNetObj_PlayerInput aInputs[NUM_CHARACTERS];
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			mem_zero(&aInputs[i], sizeof(aInputs[i]));
+			aInputs[i].m_Direction = (Tick / 7 + i) % 3 - 1;
+			aInputs[i].m_TargetX = (Tick * 13 + i * 37) % 200 - 100;
+			aInputs[i].m_TargetY = -50;
+			aInputs[i].m_Jump = (Tick + i) % 11 == 0;
+			aInputs[i].m_Hook = (Tick / 20 + i) % 3 == 0;
+			aInputs[i].m_Fire = (Tick + i) / 4;
+			if(CCharacter *pChar = pWorld->GetCharacterById(i))
+				pChar->OnDirectInput(&aInputs[i]);
+		}
+		pWorld->m_GameTick = Tick;
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+			if(CCharacter *pChar = pWorld->GetCharacterById(i))
+				pChar->OnPredictedInput(&aInputs[i]);
+		pWorld->Tick();
+	}
+
+	// the gameworld advances to the next snapshot by itself, the snapshot then only confirms it
+	void Advance(int Ticks)
+	{
+		for(int i = 0; i < Ticks; i++)
+		{
+			TickWorld(&m_GameWorld, ++m_GameTick);
+			TickWorld(&m_ServerWorld, m_GameTick);
+		}
+	}
+
+	void Snapshot(int Ticks)
+	{
+		Advance(Ticks);
+		m_History.OnSnapshot(&m_GameWorld, m_GameTick, [](int Type, CEntity *pEnt) { return true; });
+	}
+
+	// returns whether the prediction was continued
+	bool Predict(int PredGameTick)
+	{
+		const bool Continue = m_History.CanContinue(&m_GameWorld, &m_PredictedWorld, m_GameTick, PredGameTick, PredGameTick, m_Settings);
+		if(!Continue)
+			m_PredictedWorld.CopyWorld(&m_GameWorld);
+		for(int Tick = Continue ? m_PredictedWorld.GameTick() + 1 : m_GameTick + 1; Tick <= PredGameTick; Tick++)
+		{
+			TickWorld(&m_PredictedWorld, Tick);
+			m_History.OnPredictedTick(&m_PredictedWorld);
+			m_NumPredictedTicks++;
+		}
+		return Continue;
+	}
+
+	void ExpectSameAsFullPrediction()
+	{
+		// the gameworld must stay the parent of the predicted world
+		CGameWorld Full;
+		Full.CopyWorld(&m_ServerWorld);
+		for(int Tick = m_GameTick + 1; Tick <= m_PredictedWorld.GameTick(); Tick++)
+			TickWorld(&Full, Tick);
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_CharacterCore Expected, Predicted;
+			mem_zero(&Expected, sizeof(Expected));
+			mem_zero(&Predicted, sizeof(Predicted));
+			Full.GetCharacterById(i)->Core()->Write(&Expected);
+			m_PredictedWorld.GetCharacterById(i)->Core()->Write(&Predicted);
+			EXPECT_EQ(mem_comp(&Expected, &Predicted, sizeof(Expected)), 0) << "character " << i << " at tick " << m_PredictedWorld.GameTick();
+		}
+	}
+};
+
+TEST_F(CTestPredictionHistory, ContinuesConfirmedSnapshots)
+{
+	Snapshot(1);
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS));
+	int NumSnapshots = 0;
+	for(; NumSnapshots < 50; NumSnapshots++)
+	{
+		Snapshot(2);
+		for(int i = 0; i < 2; i++)
+		{
+			EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS + i));
+			ExpectSameAsFullPrediction();
+		}
+	}
+	EXPECT_EQ(m_History.NumContinuedSnapshots(), NumSnapshots);
+	// only the new ticks were predicted
+	EXPECT_EQ(m_NumPredictedTicks, m_PredictedWorld.GameTick() - 1);
+}
+
+TEST_F(CTestPredictionHistory, RestartsFromDifferentSnapshot)
+{
+	Snapshot(1);
+	Predict(m_GameTick + NUM_PREDICTED_TICKS);
+
+	// the server moved a character differently than predicted
+	Advance(2);
+	for(CGameWorld *pWorld : {&m_ServerWorld, &m_GameWorld})
+	{
+		CCharacter *pChar = pWorld->GetCharacterById(3);
+		CCharacterCore Core = pChar->GetCore();
+		Core.m_Vel.x += 1.0f;
+		pChar->SetCore(Core);
+	}
+	EXPECT_FALSE(m_History.OnSnapshot(&m_GameWorld, m_GameTick, [](int Type, CEntity *pEnt) { return true; }));
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS));
+	ExpectSameAsFullPrediction();
+
+	// the next correctly predicted snapshot is continued again
+	Snapshot(2);
+	EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS));
+	ExpectSameAsFullPrediction();
+}
+
+TEST_F(CTestPredictionHistory, RestartsFromUnpredictedEntities)
+{
+	Snapshot(1);
+	Predict(m_GameTick + NUM_PREDICTED_TICKS);
+
+	// a character that is not in the predicted world doesn't confirm the prediction
+	Advance(1);
+	EXPECT_FALSE(m_History.OnSnapshot(&m_GameWorld, m_GameTick, [](int Type, CEntity *pEnt) { return Type != CGameWorld::ENTTYPE_CHARACTER || pEnt->GetId() != 2; }));
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS));
+}
+
+TEST_F(CTestPredictionHistory, RestartsWithoutPredictedTick)
+{
+	Snapshot(1);
+	Predict(m_GameTick + 2);
+
+	// the snapshot is ahead of the prediction
+	Snapshot(3);
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS));
+	ExpectSameAsFullPrediction();
+}
+
+TEST_F(CTestPredictionHistory, RestartsAfterInvalidate)
+{
+	Snapshot(1);
+	Predict(m_GameTick + NUM_PREDICTED_TICKS);
+	EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 1));
+
+	// e.g. a pre-input for an already predicted tick
+	m_History.Invalidate();
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 2));
+	EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 3));
+
+	// an invalidated prediction isn't continued by a matching snapshot
+	m_History.Invalidate();
+	Snapshot(1);
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 3));
+	ExpectSameAsFullPrediction();
+}
+
+TEST_F(CTestPredictionHistory, RestartsWithOtherSettings)
+{
+	Snapshot(1);
+	Predict(m_GameTick + NUM_PREDICTED_TICKS);
+
+	m_Settings.m_Dummy = true;
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 1));
+	EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 2));
+
+	m_GameWorld.m_WorldConfig.m_PredictFreeze = 0;
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 3));
+	EXPECT_TRUE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 4));
+
+	// the same tick is predicted again, the antiping tick has to be fetched again
+	EXPECT_FALSE(Predict(m_GameTick + NUM_PREDICTED_TICKS + 4));
+}
@@ -1,4 +1,7 @@
+#include "test.h"
+
 #include <base/detect.h>
+#include <base/fs.h>
 #include <base/str.h>
 #include <base/time.h>
 
@@ -12,6 +15,10 @@
 #include <gtest/gtest.h>
 #include <sqlite3.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #if defined(CONF_TEST_MYSQL)
 int DummyMysqlInit = (MysqlInit(), 1);
 #endif
@@ -626,6 +633,323 @@ TEST_P(RandomMap, UnfinishedDoesntExist)
 	EXPECT_STREQ(m_pRandomMapResult->m_aMessage, "nameless tee has no more unfinished maps on this server!");
 }
 
+struct RankCache : public SingleScore
+{
+	RankCache()
+	{
+		m_Cache.Reset("GER");
+	}
+
+	// the finishes are inserted from different servers and the rankings are
+	// compared with and without regional rankings
+	void SetUp() override
+	{
+		str_copy(m_aSqlServerNameBefore, g_Config.m_SvSqlServerName);
+		m_RegionalRankingsBefore = g_Config.m_SvRegionalRankings;
+	}
+
+	void TearDown() override
+	{
+		str_copy(g_Config.m_SvSqlServerName, m_aSqlServerNameBefore);
+		g_Config.m_SvRegionalRankings = m_RegionalRankingsBefore;
+	}
+
+	void InsertFinish(const char *pName, const char *pServer, float Time)
+	{
+		str_copy(g_Config.m_SvSqlServerName, pServer, sizeof(g_Config.m_SvSqlServerName));
+		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+		str_copy(ScoreData.m_aMap, "Kobra 3", sizeof(ScoreData.m_aMap));
+		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320", sizeof(ScoreData.m_aGameUuid));
+		str_copy(ScoreData.m_aName, pName, sizeof(ScoreData.m_aName));
+		ScoreData.m_ClientId = 0;
+		ScoreData.m_Time = Time;
+		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08", sizeof(ScoreData.m_aTimestamp));
+		for(float &TimeCp : ScoreData.m_aCurrentTimeCp)
+			TimeCp = 0;
+		ASSERT_TRUE(CScoreWorker::SaveScore(m_pConn, &ScoreData, Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void LoadCache()
+	{
+		auto pResult = std::make_shared<CScoreRankCacheResult>();
+		CSqlRankCacheRequest Request(pResult);
+		str_copy(Request.m_aMap, "Kobra 3", sizeof(Request.m_aMap));
+		ASSERT_TRUE(CScoreWorker::LoadRankCache(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+		for(const CScoreRankCacheResult::CFinish &Finish : pResult->m_vFinishes)
+			m_Cache.AddFinish(Finish.m_aName, Finish.m_aServer, Finish.m_Time);
+	}
+
+	void ExpectSameAsDatabase(const char *pName, int Offset)
+	{
+		str_copy(m_PlayerRequest.m_aName, pName, sizeof(m_PlayerRequest.m_aName));
+		m_PlayerRequest.m_Offset = Offset;
+		for(int Regional = 0; Regional < 2; Regional++)
+		{
+			g_Config.m_SvRegionalRankings = Regional;
+			for(int Top = 0; Top < 2; Top++)
+			{
+				auto pExpected = std::make_shared<CScorePlayerResult>();
+				m_PlayerRequest.m_pResult = pExpected;
+				if(Top)
+					ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+				else
+					ASSERT_TRUE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+
+				CScorePlayerResult Result;
+				if(Top)
+					m_Cache.ShowTop(&m_PlayerRequest, &Result);
+				else
+					m_Cache.ShowRank(&m_PlayerRequest, &Result);
+
+				EXPECT_EQ(Result.m_MessageKind, pExpected->m_MessageKind);
+				for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+				{
+					EXPECT_STREQ(Result.m_Data.m_aaMessages[i], pExpected->m_Data.m_aaMessages[i])
+						<< "name=" << pName << " offset=" << Offset << " regional=" << Regional << " top=" << Top;
+				}
+			}
+		}
+	}
+
+	void ExpectAllSameAsDatabase()
+	{
+		for(const char *pName : {"nameless tee", "brainless tee", "Brainless tee", "ger1", "ger2", "usa1", "unknown"})
+			ExpectSameAsDatabase(pName, 0);
+		for(int Offset : {2, 4, 8, -1, -3, -9})
+			ExpectSameAsDatabase("", Offset);
+	}
+
+	void InsertFinishes(bool AddToCache)
+	{
+		// times are unique per rank, players with the same time have no defined order in /top5
+		const struct
+		{
+			const char *m_pName;
+			const char *m_pServer;
+			float m_Time;
+		} aFinishes[] = {
+			{"brainless tee", "GER", 90.02f},
+			{"Brainless tee", "GER2", 120.0f},
+			{"ger1", "GER", 80.5f},
+			{"ger1", "USA", 70.0f},
+			{"ger1", "GER", 75.0f},
+			{"ger2", "ger", 200.0f},
+			{"usa1", "USA", 150.0f},
+			{"usa1", "USA", 160.0f},
+			{"usa2", "USA", 1234.56f},
+		};
+		for(const auto &Finish : aFinishes)
+		{
+			InsertFinish(Finish.m_pName, Finish.m_pServer, Finish.m_Time);
+			if(AddToCache)
+				m_Cache.AddFinish(Finish.m_pName, Finish.m_pServer, Finish.m_Time);
+		}
+	}
+
+	CRankCache m_Cache;
+	char m_aSqlServerNameBefore[sizeof(g_Config.m_SvSqlServerName)];
+	int m_RegionalRankingsBefore;
+};
+
+TEST_P(RankCache, Loaded)
+{
+	InsertFinishes(false);
+	LoadCache();
+	ExpectAllSameAsDatabase();
+	g_Config.m_SvHideScore = 1;
+	ExpectSameAsDatabase("ger1", 0);
+	g_Config.m_SvHideScore = 0;
+}
+
+TEST_P(RankCache, Added)
+{
+	LoadCache();
+	InsertFinishes(true);
+	ExpectAllSameAsDatabase();
+}
+
+TEST_P(RankCache, LoadedAndAdded)
+{
+	// finishes saved while the cache is loading might be in the database result as well
+	InsertFinishes(true);
+	LoadCache();
+	ExpectAllSameAsDatabase();
+}
+
+struct CTestWriteData : ISqlData
+{
+	CTestWriteData(std::shared_ptr<ISqlResult> pResult, int Points) :
+		ISqlData(std::move(pResult)), m_Points(Points) {}
+	int m_Points;
+};
+
+static bool TestWrite(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CTestWriteData *>(pGameData);
+	if(pData->m_Points < 0)
+	{
+		str_copy(pError, "negative points", ErrorSize);
+		return false;
+	}
+	char aName[16];
+	str_format(aName, sizeof(aName), "tee %d", pData->m_Points);
+	return pSqlServer->AddPoints(aName, pData->m_Points, pError, ErrorSize);
+}
+
+TEST(ConnectionPool, BatchedWrites)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFilename, sizeof(aFilename), ".sqlite");
+	const int WriteBatchBefore = g_Config.m_SvSqlWriteBatch;
+	g_Config.m_SvSqlWriteBatch = 16;
+
+	// one failing write rolls back the transaction it is in, the other
+	// writes of it have to be executed exactly once anyway
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, aFilename);
+		for(int i = 0; i < 100; i++)
+		{
+			vpResults.push_back(std::make_shared<ISqlResult>());
+			Pool.ExecuteWrite(TestWrite, std::make_unique<CTestWriteData>(vpResults.back(), i == 50 ? -1 : i + 1), "test write");
+		}
+		Pool.OnShutdown();
+
+		const CDbConnectionPool::CQueryStats Stats = Pool.Stats()["test write"];
+		EXPECT_EQ(Stats.m_Queued, 0);
+		// the worker may already execute writes while they are queued
+		EXPECT_GE(Stats.m_MaxQueued, 1);
+		EXPECT_LE(Stats.m_MaxQueued, 100);
+		EXPECT_EQ(Stats.m_NumCompleted, 99);
+		EXPECT_EQ(Stats.m_NumFailed, 1);
+	}
+	for(int i = 0; i < 100; i++)
+	{
+		EXPECT_TRUE(vpResults[i]->m_Completed);
+		EXPECT_EQ(vpResults[i]->m_Success, i != 50);
+	}
+
+	{
+		auto pConn = CreateSqliteConnection(aFilename, false);
+		char aError[256] = {};
+		ASSERT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+		ASSERT_TRUE(pConn->PrepareStatement("SELECT COUNT(*), SUM(Points) FROM record_points", aError, sizeof(aError))) << aError;
+		bool End;
+		ASSERT_TRUE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+		ASSERT_FALSE(End);
+		EXPECT_EQ(pConn->GetInt(1), 99);
+		EXPECT_EQ(pConn->GetInt(2), 100 * 101 / 2 - 51);
+		pConn->Disconnect();
+	}
+	fs_remove(aFilename);
+	g_Config.m_SvSqlWriteBatch = WriteBatchBefore;
+}
+
+struct CTestReadResult : ISqlResult
+{
+	int m_Order = -1;
+};
+
+static std::atomic_int gs_ReadOrder;
+
+static bool TestRead(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	auto *pResult = dynamic_cast<CTestReadResult *>(pGameData->m_pResult.get());
+	if(!pSqlServer->PrepareStatement("SELECT COUNT(*) FROM record_race", pError, ErrorSize))
+	{
+		return false;
+	}
+	bool End;
+	if(!pSqlServer->Step(&End, pError, ErrorSize))
+	{
+		return false;
+	}
+	pResult->m_Order = gs_ReadOrder.fetch_add(1);
+	return true;
+}
+
+static bool TestSlowRead(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	return TestRead(pSqlServer, pGameData, pError, ErrorSize);
+}
+
+TEST(ConnectionPool, ReadFairness)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFilename, sizeof(aFilename), ".sqlite");
+	const int ReadWorkersBefore = g_Config.m_SvSqlReadWorkers;
+	g_Config.m_SvSqlReadWorkers = 1;
+	gs_ReadOrder = 0;
+
+	// a burst of slow queries of one kind doesn't delay other kinds
+	std::vector<std::shared_ptr<CTestReadResult>> vpSlowResults;
+	auto pFastResult = std::make_shared<CTestReadResult>();
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, aFilename);
+		for(int i = 0; i < 20; i++)
+		{
+			vpSlowResults.push_back(std::make_shared<CTestReadResult>());
+			Pool.Execute(TestSlowRead, std::make_unique<ISqlData>(vpSlowResults.back()), "slow read");
+		}
+		Pool.Execute(TestRead, std::make_unique<ISqlData>(pFastResult), "fast read");
+		while(!vpSlowResults.back()->m_Completed)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		EXPECT_EQ(Pool.Stats()["slow read"].m_NumCompleted, 20);
+	}
+	EXPECT_TRUE(pFastResult->m_Completed);
+	EXPECT_TRUE(pFastResult->m_Success);
+	EXPECT_LE(pFastResult->m_Order, 2);
+	for(const auto &pResult : vpSlowResults)
+	{
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	fs_remove(aFilename);
+	g_Config.m_SvSqlReadWorkers = ReadWorkersBefore;
+}
+
+TEST(ConnectionPool, ConcurrentReads)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFilename, sizeof(aFilename), ".sqlite");
+	const int ReadWorkersBefore = g_Config.m_SvSqlReadWorkers;
+	g_Config.m_SvSqlReadWorkers = 4;
+
+	std::vector<std::shared_ptr<CTestReadResult>> vpResults;
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, aFilename);
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, aFilename);
+		for(int i = 0; i < 100; i++)
+		{
+			vpResults.push_back(std::make_shared<CTestReadResult>());
+			Pool.Execute(i % 2 ? TestRead : TestSlowRead, std::make_unique<ISqlData>(vpResults.back()), i % 2 ? "fast read" : "slow read");
+		}
+		for(const auto &pResult : vpResults)
+		{
+			while(!pResult->m_Completed)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+	for(const auto &pResult : vpResults)
+	{
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	fs_remove(aFilename);
+	g_Config.m_SvSqlReadWorkers = ReadWorkersBefore;
+}
+
 auto g_pSqliteConn = CreateSqliteConnection(":memory:", true);
 #if defined(CONF_TEST_MYSQL)
 CMysqlConfig gMysqlConfig{
@@ -665,3 +989,4 @@ INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
 INSTANTIATE(Points);
 INSTANTIATE(RandomMap);
+INSTANTIATE(RankCache);
@@ -1,5 +1,6 @@
 #include <base/mem.h>
 
+#include <engine/server/snapshot_pipeline.h>
 #include <engine/shared/snapshot.h>
 
 #include <generated/protocol.h>
@@ -69,3 +70,140 @@ TEST(Snapshot, CrcOverflow)
 	pBuilder->Finish(Buffer);
 	ASSERT_EQ(Buffer.AsSnapshot()->Crc(), 1);
 }
+
+TEST(SnapshotStorage, AddGetPurge)
+{
+	rust::Box<CSnapshotBuilder> pBuilder = CSnapshotBuilder_New();
+	CSnapshotBuffer Buffer;
+	CSnapshotStorage Storage;
+	// span more than the tick index to also cover colliding ticks
+	for(int Tick = 0; Tick < CSnapshotStorage::TICK_INDEX_SIZE * 3; Tick += 2)
+	{
+		pBuilder->Init(false);
+		CNetObj_Flag Flag;
+		Flag.m_X = Tick;
+		Flag.m_Y = 0;
+		Flag.m_Team = 0;
+		ASSERT_TRUE(pBuilder->NewItem(NETOBJTYPE_FLAG, 0, Flag.AsSlice()));
+		int Size = pBuilder->Finish(Buffer);
+		Storage.Add(Tick, Tick, Size, Buffer.AsSnapshot(), 0, nullptr);
+	}
+
+	for(int Tick = 0; Tick < CSnapshotStorage::TICK_INDEX_SIZE * 3; Tick++)
+	{
+		int64_t Tagtime;
+		const CSnapshot *pSnap;
+		int Size = Storage.Get(Tick, &Tagtime, &pSnap, nullptr);
+		if(Tick % 2)
+		{
+			EXPECT_EQ(Size, -1);
+			continue;
+		}
+		ASSERT_GT(Size, 0);
+		EXPECT_EQ(Tagtime, Tick);
+		EXPECT_EQ(pSnap->Crc(), (unsigned)Tick);
+	}
+
+	Storage.PurgeUntil(100);
+	EXPECT_EQ(Storage.Get(98, nullptr, nullptr, nullptr), -1);
+	EXPECT_GT(Storage.Get(100, nullptr, nullptr, nullptr), 0);
+	EXPECT_EQ(Storage.m_pFirst->m_Tick, 100);
+	EXPECT_EQ(Storage.m_pFirst->m_pPrev, nullptr);
+
+	// purged holders are reused
+	const CSnapshotStorage::CHolder *pLast = Storage.m_pLast;
+	Storage.PurgeUntil(CSnapshotStorage::TICK_INDEX_SIZE * 3);
+	EXPECT_EQ(Storage.m_pFirst, nullptr);
+	EXPECT_EQ(Storage.m_pLast, nullptr);
+	Storage.Add(1000, 0, sizeof(CSnapshot), CSnapshot::EmptySnapshot(), 0, nullptr);
+	EXPECT_EQ(Storage.m_pLast, pLast);
+	EXPECT_EQ(Storage.Get(1000, nullptr, nullptr, nullptr), (int)sizeof(CSnapshot));
+}
+
+static void FillPipelineJob(CSnapshotPipeline::CJob *pJob, CSnapshotStorage *pStorage, int ClientId, int Tick, int View)
+{
+	rust::Box<CSnapshotBuilder> pBuilder = CSnapshotBuilder_New();
+	pBuilder->Init(false);
+	for(int Id = 0; Id <= View; Id++)
+	{
+		CNetObj_Flag Flag;
+		Flag.m_X = Id * 32 + Tick;
+		Flag.m_Y = View;
+		Flag.m_Team = Id % 2;
+		ASSERT_TRUE(pBuilder->NewItem(NETOBJTYPE_FLAG, Id, Flag.AsSlice()));
+	}
+	pJob->m_SnapshotSize = pBuilder->Finish(pJob->m_Snapshot);
+	pJob->m_ClientId = ClientId;
+	pJob->m_Sixup = false;
+	pJob->m_Tick = Tick;
+	pJob->m_PurgeUntilTick = Tick - 2;
+	pJob->m_AckedTick = Tick - 1;
+	pJob->m_Tagtime = 0;
+	pJob->m_pStorage = pStorage;
+}
+
+TEST(SnapshotPipeline, ThreadedMatchesSerial)
+{
+	constexpr int NUM_CLIENTS = 16;
+	rust::Box<CSnapshotDelta> pDelta = CSnapshotDelta_New();
+	rust::Box<CSnapshotDelta> pDeltaSixup = CSnapshotDelta_New();
+
+	CSnapshotPipeline Serial;
+	CSnapshotPipeline Threaded;
+	Serial.Init(0, &*pDelta, &*pDeltaSixup);
+	Threaded.Init(3, &*pDelta, &*pDeltaSixup);
+
+	CSnapshotStorage aSerialStorage[NUM_CLIENTS];
+	CSnapshotStorage aThreadedStorage[NUM_CLIENTS];
+
+	for(int Tick = 1; Tick <= 4; Tick++)
+	{
+		Serial.Clear();
+		Threaded.Clear();
+		for(int ClientId = 0; ClientId < NUM_CLIENTS; ClientId++)
+		{
+			FillPipelineJob(Serial.NewJob(), &aSerialStorage[ClientId], ClientId, Tick, ClientId);
+			FillPipelineJob(Threaded.NewJob(), &aThreadedStorage[ClientId], ClientId, Tick, ClientId);
+		}
+		Serial.Run(&*pDelta, &*pDeltaSixup);
+		Threaded.Run(&*pDelta, &*pDeltaSixup);
+
+		ASSERT_EQ(Serial.NumJobs(), Threaded.NumJobs());
+		for(int i = 0; i < Serial.NumJobs(); i++)
+		{
+			const CSnapshotPipeline::CJob *pSerialJob = Serial.Job(i);
+			const CSnapshotPipeline::CJob *pThreadedJob = Threaded.Job(i);
+			EXPECT_EQ(pSerialJob->m_ClientId, pThreadedJob->m_ClientId);
+			EXPECT_EQ(pSerialJob->m_Crc, pThreadedJob->m_Crc);
+			EXPECT_EQ(pSerialJob->m_DeltaTick, Tick == 1 ? -1 : Tick - 1);
+			EXPECT_EQ(pSerialJob->m_DeltaTick, pThreadedJob->m_DeltaTick);
+			ASSERT_EQ(pSerialJob->m_CompressedSize, pThreadedJob->m_CompressedSize);
+			EXPECT_EQ(mem_comp(pSerialJob->m_aCompressedData, pThreadedJob->m_aCompressedData, pSerialJob->m_CompressedSize), 0);
+		}
+	}
+}
+
+TEST(SnapshotPipeline, IdenticalSnapshotsShareDelta)
+{
+	rust::Box<CSnapshotDelta> pDelta = CSnapshotDelta_New();
+	rust::Box<CSnapshotDelta> pDeltaSixup = CSnapshotDelta_New();
+
+	CSnapshotPipeline Pipeline;
+	Pipeline.Init(0, &*pDelta, &*pDeltaSixup);
+
+	CSnapshotStorage aStorage[3];
+	for(int Tick = 1; Tick <= 3; Tick++)
+	{
+		Pipeline.Clear();
+		// clients 0 and 2 see the same thing, client 1 doesn't
+		FillPipelineJob(Pipeline.NewJob(), &aStorage[0], 0, Tick, 5);
+		FillPipelineJob(Pipeline.NewJob(), &aStorage[1], 1, Tick, 3);
+		FillPipelineJob(Pipeline.NewJob(), &aStorage[2], 2, Tick, 5);
+		Pipeline.Run(&*pDelta, &*pDeltaSixup);
+
+		EXPECT_EQ(Pipeline.Job(0)->Result(), Pipeline.Job(0));
+		EXPECT_EQ(Pipeline.Job(1)->Result(), Pipeline.Job(1));
+		EXPECT_EQ(Pipeline.Job(2)->Result(), Pipeline.Job(0));
+		EXPECT_EQ(Pipeline.Job(2)->m_DeltaTick, Pipeline.Job(0)->m_DeltaTick);
+	}
+}
@@ -0,0 +1,72 @@
+#include <engine/client/sound_mix.h>
+
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <vector>
+
+static std::vector<short> RandomSamples(CPrng *pPrng, unsigned Num)
+{
+	std::vector<short> vSamples(Num);
+	for(auto &Sample : vSamples)
+		Sample = (short)(pPrng->RandomBits() & 0xffff);
+	return vSamples;
+}
+
+static void ExpectMixMatchesScalar(int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {(uint64_t)Channels, Frames};
+	Prng.Seed(aSeed);
+	const std::vector<short> vData = RandomSamples(&Prng, Frames * Channels);
+
+	std::vector<int> vMix(Frames * 2);
+	for(auto &Value : vMix)
+		Value = (int)(Prng.RandomBits() % 65536) - 32768;
+	std::vector<int> vExpected = vMix;
+	for(unsigned i = 0; i < Frames; i++)
+	{
+		vExpected[i * 2] += vData[i * Channels] * VolumeL;
+		vExpected[i * 2 + 1] += vData[i * Channels + Channels - 1] * VolumeR;
+	}
+
+	SoundMixVoice(vMix.data(), vData.data(), Channels, Frames, VolumeL, VolumeR);
+	EXPECT_EQ(vMix, vExpected) << "Channels=" << Channels << " Frames=" << Frames << " VolumeL=" << VolumeL << " VolumeR=" << VolumeR;
+}
+
+TEST(SoundMix, Mono)
+{
+	for(unsigned Frames : {0u, 1u, 7u, 8u, 9u, 17u, 1024u})
+	{
+		ExpectMixMatchesScalar(1, Frames, 255, 255);
+		ExpectMixMatchesScalar(1, Frames, 17, 203);
+	}
+}
+
+TEST(SoundMix, Stereo)
+{
+	for(unsigned Frames : {0u, 1u, 3u, 4u, 5u, 17u, 1024u})
+	{
+		ExpectMixMatchesScalar(2, Frames, 255, 255);
+		ExpectMixMatchesScalar(2, Frames, 203, 0);
+	}
+}
+
+TEST(SoundMix, LargeVolume)
+{
+	// does not fit the 16 bit vector multiplication
+	ExpectMixMatchesScalar(1, 33, 40000, 1);
+	ExpectMixMatchesScalar(2, 33, 1, 40000);
+}
+
+TEST(SoundMix, Output)
+{
+	const int aMix[] = {0, 256 * 101, -256 * 101, 255, -255, 1 << 30, -(1 << 30), 12345678, -12345678};
+	short aOut[std::size(aMix)];
+	SoundMixToOutput(aOut, aMix, std::size(aMix), 1);
+	const short aExpected[] = {0, 1, -1, 0, -1, 32767, -32768, 477, -478};
+	for(unsigned i = 0; i < std::size(aMix); i++)
+		EXPECT_EQ(aOut[i], aExpected[i]) << "i=" << i;
+}
@@ -1,13 +1,20 @@
+#include "test.h"
+
+#include <base/aio.h>
 #include <base/detect.h>
+#include <base/fs.h>
 #include <base/io.h>
+#include <base/math.h>
 #include <base/time.h>
 
 #include <engine/external/json-parser/json.h>
 #include <engine/server.h>
+#include <engine/shared/compressed_stream.h>
 #include <engine/shared/config.h>
 
 #include <game/gamecore.h>
 #include <game/server/teehistorian.h>
+#include <game/server/teehistorian_reader.h>
 
 #include <gtest/gtest.h>
 
@@ -109,7 +116,7 @@ protected:
 
 	void Expect(const unsigned char *pOutput, size_t OutputSize)
 	{
-		static CUuid TEEHISTORIAN_UUID = CalculateUuid("teehistorian@ddnet.tw");
+		static const CUuid EXPECTED_UUID = CalculateUuid("teehistorian@ddnet.tw");
 		static const char PREFIX1[] = "{\"comment\":\"teehistorian@ddnet.tw\",\"version\":\"2\",\"version_minor\":\"20\",\"game_uuid\":\"a1eb7182-796e-3b3e-941d-38ca71b2a4a8\",\"server_version\":\"DDNet test\",\"start_time\":\"";
 		static const char PREFIX2[] = "\",\"server_name\":\"server name\",\"server_port\":\"8303\",\"game_type\":\"game type\",\"map_name\":\"Kobra 3 Solo\",\"map_size\":\"903514\",\"map_sha256\":\"0123456789012345678901234567890123456789012345678901234567890123\",\"map_crc\":\"eceaf25c\",\"prng_description\":\"test-prng:02468ace\",\"config\":{},\"tuning\":{},\"uuids\":[";
 		static const char PREFIX3[] = "]}";
@@ -118,7 +125,7 @@ protected:
 		str_timestamp_ex(m_GameInfo.m_StartTime, aTimeBuf, sizeof(aTimeBuf), "%Y-%m-%dT%H:%M:%S%z");
 
 		std::vector<unsigned char> vBuffer;
-		WriteBuffer(vBuffer, &TEEHISTORIAN_UUID, sizeof(TEEHISTORIAN_UUID));
+		WriteBuffer(vBuffer, &EXPECTED_UUID, sizeof(EXPECTED_UUID));
 		WriteBuffer(vBuffer, PREFIX1, str_length(PREFIX1));
 		WriteBuffer(vBuffer, aTimeBuf, str_length(aTimeBuf));
 		WriteBuffer(vBuffer, PREFIX2, str_length(PREFIX2));
@@ -931,3 +938,261 @@ TEST_F(TeeHistorian, PrevGameUuid)
 	EXPECT_STREQ(JsonPrevGameUuid, "fe19c218-f555-4002-a273-126c59ccc17a");
 	json_value_free(pJson);
 }
+
+TEST_F(TeeHistorian, CompressedFile)
+{
+	for(int i = 1; i <= 500; i++)
+	{
+		Tick(i);
+		for(int ClientId = 0; ClientId < 8; ClientId++)
+			Player(ClientId, i * (ClientId + 1), -i * ClientId);
+	}
+	Finish();
+
+	// written the same way as by the server, in small blocks to get many
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	CCompressedStreamWriter Writer(9, 1024);
+	ASYNCIO *pAio = aio_new_encoded(File, CCompressedStreamWriter::AioEncoder, &Writer);
+	for(size_t Offset = 0; Offset < m_vBuffer.size(); Offset += 100)
+		aio_write(pAio, &m_vBuffer[Offset], minimum<size_t>(100, m_vBuffer.size() - Offset));
+	aio_close(pAio);
+	aio_wait(pAio);
+	EXPECT_EQ(aio_error(pAio), 0);
+	aio_free(pAio);
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	const int64_t FileSize = io_length(File);
+	EXPECT_LT(FileSize, (int64_t)m_vBuffer.size());
+
+	CCompressedStreamReader Reader;
+	ASSERT_TRUE(Reader.Open(File));
+	std::vector<unsigned char> vDecompressed;
+	std::vector<unsigned char> vBlock;
+	uint64_t BlockOffset;
+	int NumBlocks = 0;
+	while(Reader.ReadBlock(vBlock, &BlockOffset))
+	{
+		EXPECT_EQ(BlockOffset, vDecompressed.size());
+		vDecompressed.insert(vDecompressed.end(), vBlock.begin(), vBlock.end());
+		NumBlocks++;
+	}
+	EXPECT_FALSE(Reader.Error());
+	EXPECT_GT(NumBlocks, 1);
+	EXPECT_EQ(vDecompressed, m_vBuffer);
+
+	// a cut off file can still be decoded up to the last complete block
+	io_seek(File, 0, IOSEEK_START);
+	std::vector<unsigned char> vFile(FileSize - 10);
+	ASSERT_EQ(io_read(File, vFile.data(), vFile.size()), vFile.size());
+	io_close(File);
+	File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, vFile.data(), vFile.size());
+	io_close(File);
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	CCompressedStreamReader TruncatedReader;
+	ASSERT_TRUE(TruncatedReader.Open(File));
+	int NumTruncatedBlocks = 0;
+	while(TruncatedReader.ReadBlock(vBlock))
+	{
+		EXPECT_EQ(mem_comp(vBlock.data(), &m_vBuffer[NumTruncatedBlocks * 1024], vBlock.size()), 0);
+		NumTruncatedBlocks++;
+	}
+	EXPECT_TRUE(TruncatedReader.Error());
+	EXPECT_EQ(NumTruncatedBlocks, NumBlocks - 1);
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+}
+
+class TeeHistorianIndex : public TeeHistorian
+{
+protected:
+	enum
+	{
+		NUM_TICKS = CTeeHistorianIndex::CHECKPOINT_INTERVAL * 2 + 123,
+		NUM_PLAYERS = 6,
+	};
+
+	// expected state after each tick
+	std::vector<std::vector<CTeeHistorianReader::CPlayer>> m_vvExpected;
+
+	void Record()
+	{
+		std::vector<CTeeHistorianReader::CPlayer> vPlayers(NUM_PLAYERS);
+		for(auto &Player : vPlayers)
+			Player = {};
+		m_vvExpected.push_back(vPlayers);
+
+		for(int Tick = 1; Tick <= NUM_TICKS; Tick++)
+		{
+			this->Tick(Tick);
+			// some ticks without any changes, players dying and moving
+			for(int ClientId = 0; ClientId < NUM_PLAYERS; ClientId++)
+			{
+				CTeeHistorianReader::CPlayer &Player = vPlayers[ClientId];
+				if((Tick / (50 + ClientId * 30)) % 3 == 2)
+				{
+					DeadPlayer(ClientId);
+					Player.m_Alive = false;
+				}
+				else
+				{
+					if(Tick % (ClientId + 2) == 0 || !Player.m_Alive)
+					{
+						Player.m_X = Tick * (ClientId + 1);
+						Player.m_Y = -Tick / (ClientId + 1);
+					}
+					this->Player(ClientId, Player.m_X, Player.m_Y);
+					Player.m_Alive = true;
+				}
+			}
+			Inputs();
+			for(int ClientId = 0; ClientId < NUM_PLAYERS; ClientId++)
+			{
+				CTeeHistorianReader::CPlayer &Player = vPlayers[ClientId];
+				if(Tick % 7 == ClientId)
+				{
+					Player.m_Input.m_Direction = Tick % 3 - 1;
+					Player.m_Input.m_TargetX = Tick * ClientId;
+					Player.m_Input.m_TargetY = -Tick;
+					// a new id every now and then to get INPUT_NEW
+					m_TH.RecordPlayerInput(ClientId, 1 + Tick / 1000, &Player.m_Input);
+					Player.m_HaveInput = true;
+				}
+				if(Tick % 97 == ClientId)
+				{
+					Player.m_Team = Tick % 5;
+					m_TH.RecordPlayerTeam(ClientId, Player.m_Team);
+				}
+			}
+			if(Tick == 10)
+				m_TH.RecordPlayerJoin(3, CTeeHistorian::PROTOCOL_6);
+			if(Tick == 2000)
+				m_TH.RecordPlayerDrop(3, "bye");
+			if(Tick % 11 == 0)
+				m_TH.RecordPlayerMessage(1, "\x01\x02\x03", 3);
+			m_vvExpected.push_back(vPlayers);
+		}
+		Finish();
+	}
+
+	void WriteFile(const char *pFilename, bool Compressed)
+	{
+		IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		if(Compressed)
+		{
+			CCompressedStreamWriter Writer(6, 4096);
+			ASSERT_EQ(Writer.Write(File, m_vBuffer.data(), m_vBuffer.size()), 0);
+			ASSERT_EQ(Writer.Flush(File), 0);
+		}
+		else
+		{
+			io_write(File, m_vBuffer.data(), m_vBuffer.size());
+		}
+		io_close(File);
+	}
+
+	void ExpectState(CTeeHistorianReader &Reader, int Tick)
+	{
+		ASSERT_TRUE(Reader.SeekTick(Tick)) << Tick;
+		EXPECT_EQ(Reader.Tick(), Tick);
+		const std::vector<CTeeHistorianReader::CPlayer> &vExpected = m_vvExpected[minimum<int>(Tick, NUM_TICKS)];
+		for(int ClientId = 0; ClientId < NUM_PLAYERS; ClientId++)
+		{
+			const CTeeHistorianReader::CPlayer &Expected = vExpected[ClientId];
+			const CTeeHistorianReader::CPlayer &Actual = Reader.Player(ClientId);
+			ASSERT_EQ(Actual.m_Alive, Expected.m_Alive) << "tick=" << Tick << " cid=" << ClientId;
+			if(Expected.m_Alive)
+			{
+				ASSERT_EQ(Actual.m_X, Expected.m_X) << "tick=" << Tick << " cid=" << ClientId;
+				ASSERT_EQ(Actual.m_Y, Expected.m_Y) << "tick=" << Tick << " cid=" << ClientId;
+			}
+			ASSERT_EQ(Actual.m_HaveInput, Expected.m_HaveInput) << "tick=" << Tick << " cid=" << ClientId;
+			ASSERT_EQ(mem_comp(&Actual.m_Input, &Expected.m_Input, sizeof(Expected.m_Input)), 0) << "tick=" << Tick << " cid=" << ClientId;
+			ASSERT_EQ(Actual.m_Team, Expected.m_Team) << "tick=" << Tick << " cid=" << ClientId;
+		}
+	}
+
+	void ExpectSeekable(bool Index, bool Compressed)
+	{
+		m_GameInfo.m_Index = Index;
+		Reset(&m_GameInfo);
+		Record();
+
+		CTestInfo Info;
+		WriteFile(Info.m_aFilename, Compressed);
+
+		CTeeHistorianReader Reader;
+		ASSERT_TRUE(Reader.Open(io_open(Info.m_aFilename, IOFLAG_READ)));
+		EXPECT_EQ(Reader.HasIndex(), Index);
+		if(Index)
+		{
+			EXPECT_EQ(Reader.NumCheckpoints(), 3);
+			ASSERT_EQ(Reader.ClientRanges().size(), 1u);
+			EXPECT_EQ(Reader.ClientRanges()[0].m_ClientId, 3);
+			EXPECT_EQ(Reader.ClientRanges()[0].m_JoinTick, 10);
+			EXPECT_EQ(Reader.ClientRanges()[0].m_DropTick, 2000);
+		}
+
+		// backwards, forwards, across checkpoints and past the end
+		for(int Tick : {2000, 1, 0, 1499, 1500, 1501, 1502, 3000, 3001, 2999, (int)NUM_TICKS, NUM_TICKS + 100, 750})
+		{
+			ExpectState(Reader, Tick);
+		}
+		for(int Tick = 0; Tick <= NUM_TICKS; Tick += 13)
+		{
+			ExpectState(Reader, Tick);
+		}
+		Reader.Close();
+		fs_remove(Info.m_aFilename);
+	}
+};
+
+TEST_F(TeeHistorianIndex, SeekPlain)
+{
+	ExpectSeekable(true, false);
+}
+
+TEST_F(TeeHistorianIndex, SeekCompressed)
+{
+	ExpectSeekable(true, true);
+}
+
+TEST_F(TeeHistorianIndex, SeekWithoutIndex)
+{
+	ExpectSeekable(false, false);
+}
+
+TEST_F(TeeHistorianIndex, CheckpointsBounded)
+{
+	m_GameInfo.m_Index = true;
+	Reset(&m_GameInfo);
+	const int LastTick = CTeeHistorianIndex::CHECKPOINT_INTERVAL * CTeeHistorianIndex::MAX_CHECKPOINTS * 3;
+	for(int Tick = 1; Tick <= LastTick; Tick += CTeeHistorianIndex::CHECKPOINT_INTERVAL / 2)
+	{
+		this->Tick(Tick);
+	}
+	Finish();
+
+	CTestInfo Info;
+	WriteFile(Info.m_aFilename, false);
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Open(io_open(Info.m_aFilename, IOFLAG_READ)));
+	EXPECT_TRUE(Reader.HasIndex());
+	EXPECT_LE(Reader.NumCheckpoints(), (int)CTeeHistorianIndex::MAX_CHECKPOINTS);
+	EXPECT_GE(Reader.NumCheckpoints(), (int)CTeeHistorianIndex::MAX_CHECKPOINTS / 2);
+	for(int Tick : {LastTick, 1, LastTick / 2, LastTick / 3})
+	{
+		ASSERT_TRUE(Reader.SeekTick(Tick)) << Tick;
+		EXPECT_EQ(Reader.Tick(), Tick);
+	}
+	Reader.Close();
+	fs_remove(Info.m_aFilename);
+}
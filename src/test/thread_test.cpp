@@ -51,6 +51,28 @@ TEST(Thread, SemaphoreSingleThreaded)
 	sphore_destroy(&Semaphore);
 }
 
+TEST(Thread, SemaphoreTryWait)
+{
+	SEMAPHORE Semaphore;
+	sphore_init(&Semaphore);
+	EXPECT_FALSE(sphore_trywait(&Semaphore));
+	sphore_signal(&Semaphore);
+	EXPECT_TRUE(sphore_trywait(&Semaphore));
+	EXPECT_FALSE(sphore_trywait(&Semaphore));
+	sphore_destroy(&Semaphore);
+}
+
+TEST(Thread, SemaphoreWrapperTryWait)
+{
+	CSemaphore Semaphore;
+	EXPECT_FALSE(Semaphore.TryWait());
+	Semaphore.Signal();
+	EXPECT_EQ(Semaphore.GetApproximateValue(), 1);
+	EXPECT_TRUE(Semaphore.TryWait());
+	EXPECT_EQ(Semaphore.GetApproximateValue(), 0);
+	EXPECT_FALSE(Semaphore.TryWait());
+}
+
 TEST(Thread, SemaphoreWrapperSingleThreaded)
 {
 	CSemaphore Semaphore;
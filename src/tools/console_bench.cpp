@@ -0,0 +1,136 @@
+#include <base/fs.h>
+#include <base/io.h>
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char *TOOL_NAME = "console_bench";
+static const char *AUTOEXEC_FILENAME = "console_bench.cfg";
+
+static void ConCount(IConsole::IResult *pResult, void *pUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s [lines] [extra commands]", TOOL_NAME);
+		return -1;
+	}
+	const int NumLines = argc >= 2 ? str_toint(argv[1]) : 200000;
+	const int NumExtraCommands = argc >= 3 ? str_toint(argv[2]) : 500;
+	if(NumLines < 1 || NumExtraCommands < 0)
+	{
+		log_error(TOOL_NAME, "Invalid arguments");
+		return -1;
+	}
+
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::BASIC, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_ECON).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+	pConsole->StoreCommands(false);
+
+	// stand-ins for the chat and rcon commands registered by the server
+	int NumCalls = 0;
+	std::vector<std::string> vExtraNames;
+	for(int i = 0; i < NumExtraCommands; i++)
+	{
+		char aName[32];
+		str_format(aName, sizeof(aName), "%c_bench_command_%d", 'a' + i % 26, i);
+		vExtraNames.emplace_back(aName);
+	}
+	for(const std::string &Name : vExtraNames)
+	{
+		pConsole->Register(Name.c_str(), "?i", CFGFLAG_SERVER, ConCount, &NumCalls, "");
+	}
+
+	// integer config variables and the extra commands, all taking one integer
+	std::vector<std::string> vNames;
+	int NumCommands = 0;
+	for(const IConsole::ICommandInfo *pInfo = pConsole->FirstCommandInfo(IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SERVER); pInfo; pInfo = pConsole->NextCommandInfo(pInfo, IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SERVER))
+	{
+		NumCommands++;
+		if(str_comp(pInfo->Params(), "?i") == 0)
+			vNames.emplace_back(pInfo->Name());
+	}
+	if(vNames.empty())
+	{
+		log_error(TOOL_NAME, "No commands found");
+		return -1;
+	}
+
+	IOHANDLE File = io_open(AUTOEXEC_FILENAME, IOFLAG_WRITE);
+	if(!File)
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' for writing", AUTOEXEC_FILENAME);
+		return -1;
+	}
+	std::mt19937 Rng(0);
+	std::uniform_int_distribution<size_t> Distribution(0, vNames.size() - 1);
+	for(int i = 0; i < NumLines; i++)
+	{
+		char aLine[128];
+		str_copy(aLine, vNames[Distribution(Rng)].c_str());
+		// commands are case insensitive
+		if(i % 4 == 0)
+		{
+			for(char *pChar = aLine; *pChar; pChar++)
+			{
+				if(*pChar >= 'a' && *pChar <= 'z')
+					*pChar = *pChar - 'a' + 'A';
+			}
+		}
+		str_append(aLine, " 0");
+		io_write(File, aLine, str_length(aLine));
+		io_write_newline(File);
+	}
+	io_close(File);
+	log_info(TOOL_NAME, "Executing %d lines using %d of %d commands", NumLines, (int)vNames.size(), NumCommands);
+
+	double BestSeconds = 0.0;
+	for(int Run = 0; Run < 5; Run++)
+	{
+		const auto Start = time_get_nanoseconds();
+		if(!pConsole->ExecuteFile(AUTOEXEC_FILENAME, IConsole::CLIENT_ID_UNSPECIFIED, true, IStorage::TYPE_ABSOLUTE))
+		{
+			fs_remove(AUTOEXEC_FILENAME);
+			return -1;
+		}
+		const double Seconds = (time_get_nanoseconds() - Start).count() / 1e9;
+		BestSeconds = Run == 0 ? Seconds : std::min(BestSeconds, Seconds);
+		log_info(TOOL_NAME, "run=%d time=%.3fs lines/s=%.0f", Run, Seconds, NumLines / Seconds);
+	}
+	log_info(TOOL_NAME, "best time=%.3fs lines/s=%.0f extra commands called=%d", BestSeconds, NumLines / BestSeconds, NumCalls);
+
+	fs_remove(AUTOEXEC_FILENAME);
+	return 0;
+}
@@ -0,0 +1,208 @@
+#include <base/fs.h>
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *TOOL_NAME = "map_compress_bench";
+static const char *OUTPUT_FILENAME = "map_compress_bench.map";
+
+class CBenchMap
+{
+public:
+	class CItem
+	{
+	public:
+		int m_Type;
+		int m_Id;
+		CUuid m_Uuid;
+		std::vector<char> m_vData;
+	};
+
+	std::string m_Path;
+	std::vector<CItem> m_vItems;
+	std::vector<std::vector<char>> m_vvData;
+	SHA256_DIGEST m_OutputSha256;
+};
+
+static bool LoadMap(IStorage *pStorage, const char *pPath, CBenchMap *pMap)
+{
+	CDataFileReader Reader;
+	if(!Reader.Open(pStorage, pPath, IStorage::TYPE_ABSOLUTE))
+	{
+		return false;
+	}
+
+	pMap->m_Path = pPath;
+	for(int Index = 0; Index < Reader.NumItems(); Index++)
+	{
+		CBenchMap::CItem Item;
+		const char *pData = static_cast<const char *>(Reader.GetItem(Index, &Item.m_Type, &Item.m_Id, &Item.m_Uuid));
+		// Filter ITEMTYPE_EX items, they will be automatically added again.
+		if(Item.m_Type == ITEMTYPE_EX)
+		{
+			continue;
+		}
+		Item.m_vData.assign(pData, pData + Reader.GetItemSize(Index));
+		pMap->m_vItems.push_back(std::move(Item));
+	}
+	for(int Index = 0; Index < Reader.NumData(); Index++)
+	{
+		const char *pData = static_cast<const char *>(Reader.GetData(Index));
+		if(pData == nullptr)
+		{
+			return false;
+		}
+		pMap->m_vvData.emplace_back(pData, pData + Reader.GetDataSize(Index));
+		Reader.UnloadData(Index);
+	}
+	return true;
+}
+
+// adds the time spent in `Finish` to `pSeconds`, i.e. compressing the data and writing it
+static bool SaveMap(IStorage *pStorage, const CBenchMap &Map, CJobPool *pJobPool, SHA256_DIGEST *pSha256, double *pSeconds)
+{
+	CDataFileWriter Writer;
+	if(!Writer.Open(pStorage, OUTPUT_FILENAME, IStorage::TYPE_ABSOLUTE))
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' for writing", OUTPUT_FILENAME);
+		return false;
+	}
+	for(const CBenchMap::CItem &Item : Map.m_vItems)
+	{
+		Writer.AddItem(Item.m_Type, Item.m_Id, Item.m_vData.size(), Item.m_vData.data(), &Item.m_Uuid);
+	}
+	for(const std::vector<char> &vData : Map.m_vvData)
+	{
+		Writer.AddData(vData.size(), vData.data());
+	}
+	const auto Start = time_get_nanoseconds();
+	Writer.Finish(pJobPool);
+	*pSeconds += (time_get_nanoseconds() - Start).count() / 1e9;
+
+	CDataFileReader Reader;
+	if(!Reader.Open(pStorage, OUTPUT_FILENAME, IStorage::TYPE_ABSOLUTE))
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' after writing it", OUTPUT_FILENAME);
+		return false;
+	}
+	*pSha256 = Reader.Sha256();
+	return true;
+}
+
+static int ListMap(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	std::vector<std::string> *pvFilenames = static_cast<std::vector<std::string> *>(pUser);
+	if(!IsDir && str_endswith(pName, ".map"))
+	{
+		pvFilenames->emplace_back(pName);
+	}
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc != 2 && argc != 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s <map directory> [max threads]", TOOL_NAME);
+		return -1;
+	}
+	const int MaxThreads = argc == 3 ? str_toint(argv[2]) : std::max(1, (int)std::thread::hardware_concurrency());
+	if(MaxThreads < 1)
+	{
+		log_error(TOOL_NAME, "Invalid number of threads '%s'", argv[2]);
+		return -1;
+	}
+
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+
+	std::vector<std::string> vFilenames;
+	fs_listdir(argv[1], ListMap, IStorage::TYPE_ABSOLUTE, &vFilenames);
+	std::sort(vFilenames.begin(), vFilenames.end());
+
+	// maps are kept in memory, so loading them is not measured
+	std::vector<CBenchMap> vMaps;
+	int64_t TotalSize = 0;
+	for(const std::string &Filename : vFilenames)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", argv[1], Filename.c_str());
+		CBenchMap Map;
+		if(!LoadMap(pStorage.get(), aPath, &Map))
+		{
+			log_warn(TOOL_NAME, "Skipping '%s', failed to load it", aPath);
+			continue;
+		}
+		for(const std::vector<char> &vData : Map.m_vvData)
+		{
+			TotalSize += vData.size();
+		}
+		vMaps.push_back(std::move(Map));
+	}
+	if(vMaps.empty())
+	{
+		log_error(TOOL_NAME, "No maps found in '%s'", argv[1]);
+		return -1;
+	}
+	log_info(TOOL_NAME, "Loaded %d maps with %.1f MiB of uncompressed data", (int)vMaps.size(), TotalSize / 1024.0 / 1024.0);
+
+	std::vector<int> vThreadCounts;
+	for(int Threads = 1; Threads < MaxThreads; Threads *= 2)
+	{
+		vThreadCounts.push_back(Threads);
+	}
+	vThreadCounts.push_back(MaxThreads);
+
+	bool Mismatch = false;
+	double SerialSeconds = 0.0;
+	for(const int Threads : vThreadCounts)
+	{
+		// the thread calling Finish compresses as well
+		CJobPool JobPool;
+		JobPool.Init(Threads - 1);
+
+		double Seconds = 0.0;
+		for(CBenchMap &Map : vMaps)
+		{
+			SHA256_DIGEST Sha256;
+			if(!SaveMap(pStorage.get(), Map, Threads > 1 ? &JobPool : nullptr, &Sha256, &Seconds))
+			{
+				return -1;
+			}
+			if(Threads == 1)
+			{
+				Map.m_OutputSha256 = Sha256;
+			}
+			else if(Sha256 != Map.m_OutputSha256)
+			{
+				log_error(TOOL_NAME, "Output of '%s' with %d threads differs from output with 1 thread", Map.m_Path.c_str(), Threads);
+				Mismatch = true;
+			}
+		}
+		if(Threads == 1)
+		{
+			SerialSeconds = Seconds;
+		}
+		log_info(TOOL_NAME, "threads=%d time=%.3fs speedup=%.2fx", Threads, Seconds, SerialSeconds / Seconds);
+	}
+
+	pStorage->RemoveFile(OUTPUT_FILENAME, IStorage::TYPE_ABSOLUTE);
+	return Mismatch ? -1 : 0;
+}
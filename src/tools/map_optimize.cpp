@@ -7,12 +7,14 @@
 
 #include <engine/gfx/image_manipulation.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <game/mapitems.h>
 
 #include <algorithm>
 #include <cstdint>
+#include <thread>
 #include <vector>
 
 static void ClearTransparentPixels(uint8_t *pImg, int Width, int Height)
@@ -326,7 +328,9 @@ int main(int argc, const char **argv)
 	}
 
 	Reader.Close();
-	Writer.Finish();
+	CJobPool JobPool;
+	JobPool.Init(std::max(1, (int)std::thread::hardware_concurrency()) - 1);
+	Writer.Finish(&JobPool);
 
 	return 0;
 }
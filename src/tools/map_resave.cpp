@@ -5,8 +5,12 @@
 #include <base/os.h>
 
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
+#include <algorithm>
+#include <thread>
+
 static const char *TOOL_NAME = "map_resave";
 
 static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStorage *pStorage)
@@ -52,7 +56,9 @@ static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStora
 	}
 
 	Reader.Close();
-	Writer.Finish();
+	CJobPool JobPool;
+	JobPool.Init(std::max(1, (int)std::thread::hardware_concurrency()) - 1);
+	Writer.Finish(&JobPool);
 	log_info(TOOL_NAME, "Resaved '%s' to '%s'", pSourceMap, pDestinationMap);
 	return 0;
 }
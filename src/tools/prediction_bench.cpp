@@ -0,0 +1,238 @@
+#include <base/logger.h>
+#include <base/mem.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/client/prediction/history.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapbugs.h>
+#include <game/prng.h>
+
+#include <algorithm>
+#include <iterator>
+
+static const char *TOOL_NAME = "prediction_bench";
+
+static const int WEAPONS[] = {WEAPON_GUN, WEAPON_SHOTGUN, WEAPON_GRENADE, WEAPON_LASER};
+
+// inputs only depend on the tick, so predicting a tick again gives the same result
+static unsigned RandomBits(int Tick, int Id, int Index)
+{
+	uint64_t x = ((uint64_t)Tick << 32) ^ ((uint64_t)Id << 8) ^ Index;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return (unsigned)(x ^ (x >> 31));
+}
+
+static void RandomInput(int Tick, int Id, CNetObj_PlayerInput *pInput)
+{
+	mem_zero(pInput, sizeof(*pInput));
+	pInput->m_Direction = (int)(RandomBits(Tick, Id, 0) % 3) - 1;
+	pInput->m_TargetX = (int)(RandomBits(Tick, Id, 1) % 512) - 256;
+	pInput->m_TargetY = (int)(RandomBits(Tick, Id, 2) % 512) - 256;
+	if(pInput->m_TargetX == 0 && pInput->m_TargetY == 0)
+		pInput->m_TargetY = -1;
+	pInput->m_Jump = RandomBits(Tick, Id, 3) % 8 == 0;
+	pInput->m_Hook = (Tick / 20 + Id) % 3 == 0;
+	// a press and a release every few ticks
+	pInput->m_Fire = (Tick + Id) / 4;
+}
+
+static void ApplyInputs(CGameWorld *pWorld, int Tick, bool Direct)
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChar = pWorld->GetCharacterById(i);
+		if(!pChar)
+			continue;
+		CNetObj_PlayerInput Input;
+		RandomInput(Tick, i, &Input);
+		if(Direct)
+			pChar->OnDirectInput(&Input);
+		else
+			pChar->OnPredictedInput(&Input);
+	}
+}
+
+static void TickWorld(CGameWorld *pWorld, int Tick)
+{
+	ApplyInputs(pWorld, Tick, true);
+	pWorld->m_GameTick = Tick;
+	ApplyInputs(pWorld, Tick, false);
+	pWorld->Tick();
+}
+
+class CRunResult
+{
+public:
+	int64_t m_CopyNs = 0;
+	int64_t m_TickNs = 0;
+	int m_NumTicks = 0;
+	int m_NumCopies = 0;
+	int m_MaxEntities = 0;
+	vec2 m_Checksum = vec2(0, 0);
+};
+
+// Like the client, predicts ahead of the snapshot once per predicted tick. Snapshots arrive
+// every `SnapshotInterval` ticks. Without `Incremental` each prediction starts from the
+// snapshot again, otherwise the prediction history decides whether the previous prediction
+// can be continued. The snapshots are predicted correctly, so it always can.
+static CRunResult Run(CGameWorld *pSetup, int NumSnapshots, int SnapshotInterval, int NumPredictedTicks, bool Incremental)
+{
+	CGameWorld GameWorld;
+	GameWorld.CopyWorld(pSetup);
+	CGameWorld PredictedWorld;
+	CPredictionHistory History;
+	CRunResult Result;
+	int Tick = GameWorld.GameTick();
+	for(int Snapshot = 0; Snapshot < NumSnapshots; Snapshot++)
+	{
+		for(int i = 0; i < SnapshotInterval; i++)
+			TickWorld(&GameWorld, ++Tick);
+
+		const auto SnapshotStart = time_get_nanoseconds();
+		if(Incremental)
+			History.OnSnapshot(&GameWorld, Tick, [](int Type, CEntity *pEnt) { return true; });
+		Result.m_TickNs += (time_get_nanoseconds() - SnapshotStart).count();
+
+		for(int PredGameTick = Tick + NumPredictedTicks; PredGameTick < Tick + NumPredictedTicks + SnapshotInterval; PredGameTick++)
+		{
+			const auto CopyStart = time_get_nanoseconds();
+			if(!Incremental || !History.CanContinue(&GameWorld, &PredictedWorld, Tick, PredGameTick, PredGameTick, CPredictionHistory::CSettings()))
+			{
+				PredictedWorld.CopyWorld(&GameWorld);
+				Result.m_NumCopies++;
+			}
+			const auto TickStart = time_get_nanoseconds();
+			for(int PredTick = PredictedWorld.GameTick() + 1; PredTick <= PredGameTick; PredTick++)
+			{
+				TickWorld(&PredictedWorld, PredTick);
+				if(Incremental)
+					History.OnPredictedTick(&PredictedWorld);
+				Result.m_NumTicks++;
+			}
+			const auto End = time_get_nanoseconds();
+			Result.m_CopyNs += (TickStart - CopyStart).count();
+			Result.m_TickNs += (End - TickStart).count();
+
+			int NumEntities = 0;
+			for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+				for(CEntity *pEnt = PredictedWorld.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+					NumEntities++;
+			Result.m_MaxEntities = std::max(Result.m_MaxEntities, NumEntities);
+			for(int i = 0; i < MAX_CLIENTS; i++)
+				if(CCharacter *pChar = PredictedWorld.GetCharacterById(i))
+					Result.m_Checksum += pChar->m_Pos;
+		}
+	}
+	return Result;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc < 2 || argc > 6)
+	{
+		log_error(TOOL_NAME, "Usage: %s <map> [characters] [snapshots] [predicted ticks] [snapshot interval]", TOOL_NAME);
+		return -1;
+	}
+	const int NumCharacters = argc >= 3 ? str_toint(argv[2]) : MAX_CLIENTS;
+	const int NumSnapshots = argc >= 4 ? str_toint(argv[3]) : 500;
+	const int NumPredictedTicks = argc >= 5 ? str_toint(argv[4]) : 10;
+	const int SnapshotInterval = argc >= 6 ? str_toint(argv[5]) : 2;
+	if(NumCharacters < 1 || NumCharacters > MAX_CLIENTS || NumSnapshots < 1 || NumPredictedTicks < 1 || SnapshotInterval < 1)
+	{
+		log_error(TOOL_NAME, "Invalid arguments");
+		return -1;
+	}
+
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::BASIC, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	CMap Map;
+	if(!Map.Load(pStorage, argv[1], IStorage::TYPE_ALL))
+	{
+		log_error(TOOL_NAME, "Failed to load map '%s'", argv[1]);
+		return -1;
+	}
+	CLayers Layers;
+	Layers.Init(&Map, true);
+	CCollision Collision;
+	Collision.Init(&Layers);
+	const CMapBugs MapBugs = CMapBugs::Create(Map.BaseName(), Map.Size(), Map.Sha256());
+	CTuningParams aTuningList[TuneZone::NUM];
+
+	CGameWorld GameWorld;
+	GameWorld.Init(&Collision, aTuningList, &MapBugs);
+	GameWorld.m_WorldConfig.m_IsDDRace = true;
+	GameWorld.m_WorldConfig.m_IsVanilla = false;
+	GameWorld.m_WorldConfig.m_IsFNG = false;
+	GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
+	GameWorld.m_WorldConfig.m_PredictTiles = true;
+	GameWorld.m_WorldConfig.m_PredictFreeze = 1;
+	GameWorld.m_WorldConfig.m_PredictWeapons = true;
+	GameWorld.m_WorldConfig.m_PredictDDRace = true;
+	GameWorld.m_WorldConfig.m_IsSolo = false;
+	GameWorld.m_WorldConfig.m_UseTuneZones = false;
+	GameWorld.m_WorldConfig.m_BugDDRaceInput = false;
+	GameWorld.m_WorldConfig.m_NoWeakHookAndBounce = false;
+	GameWorld.m_WorldConfig.m_PredictEvents = false;
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+	Prng.Seed(aSeed);
+
+	// the snapshot: characters standing on free spots all over the map
+	GameWorld.NetObjBegin(CTeamsCore(), 0);
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		CNetObj_Character Char;
+		mem_zero(&Char, sizeof(Char));
+		vec2 Pos;
+		int Tries = 0;
+		do
+		{
+			Pos = vec2((Prng.RandomBits() % Collision.GetWidth()) * 32 + 16, (Prng.RandomBits() % Collision.GetHeight()) * 32 + 16);
+		} while(Collision.TestBox(Pos, CCharacterCore::PhysicalSizeVec2()) && ++Tries < 10000);
+		Char.m_X = round_to_int(Pos.x);
+		Char.m_Y = round_to_int(Pos.y);
+		Char.m_Direction = 0;
+		Char.m_Weapon = WEAPONS[i % std::size(WEAPONS)];
+		Char.m_AmmoCount = 10;
+		Char.m_Health = 10;
+		Char.m_Armor = 0;
+		Char.m_Emote = EMOTE_NORMAL;
+		Char.m_HookedPlayer = -1;
+		GameWorld.NetCharAdd(i, &Char, nullptr, 0, i == 0);
+	}
+	GameWorld.NetObjEnd();
+
+	// fill the world with projectiles and lasers before measuring
+	for(int Tick = 1; Tick <= SERVER_TICK_SPEED; Tick++)
+		TickWorld(&GameWorld, Tick);
+
+	log_info(TOOL_NAME, "snapshots=%d predicted ticks=%d snapshot interval=%d characters=%d", NumSnapshots, NumPredictedTicks, SnapshotInterval, NumCharacters);
+	for(bool Incremental : {false, true})
+	{
+		const CRunResult Result = Run(&GameWorld, NumSnapshots, SnapshotInterval, NumPredictedTicks, Incremental);
+		log_info(TOOL_NAME, "%s: copy=%.3fs (%d copies) tick=%.3fs total=%.3fs ticks=%d max entities=%d checksum=%.2f,%.2f",
+			Incremental ? "incremental" : "full",
+			Result.m_CopyNs / 1e9, Result.m_NumCopies, Result.m_TickNs / 1e9, (Result.m_CopyNs + Result.m_TickNs) / 1e9,
+			Result.m_NumTicks, Result.m_MaxEntities, Result.m_Checksum.x, Result.m_Checksum.y);
+	}
+	return 0;
+}
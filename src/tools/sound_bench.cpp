@@ -0,0 +1,138 @@
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/client/sound_mix.h>
+
+#include <game/prng.h>
+
+#include <algorithm>
+#include <vector>
+
+static const char *TOOL_NAME = "sound_bench";
+
+static const int MIX_RATE = 48000;
+static const int MASTER_VOLUME = 100;
+
+class CBenchVoice
+{
+public:
+	const std::vector<short> *m_pData;
+	int m_Channels;
+	unsigned m_NumFrames;
+	unsigned m_Tick;
+	int m_VolumeL;
+	int m_VolumeR;
+};
+
+// the per frame loop the mixer used before the kernel, as reference
+static void MixVoiceScalar(int *pMixBuffer, const short *pData, int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	const short *pInL = pData;
+	const short *pInR = Channels == 1 ? pData : pData + 1;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		*pMixBuffer++ += (*pInL) * VolumeL;
+		*pMixBuffer++ += (*pInR) * VolumeR;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+static int64_t Run(std::vector<CBenchVoice> vVoices, int NumBlocks, unsigned BlockFrames, bool Scalar, uint64_t *pChecksum)
+{
+	std::vector<int> vMixBuffer(BlockFrames * 2);
+	std::vector<short> vOut(BlockFrames * 2);
+	*pChecksum = 0;
+
+	const auto Start = time_get_nanoseconds();
+	for(int Block = 0; Block < NumBlocks; Block++)
+	{
+		std::fill(vMixBuffer.begin(), vMixBuffer.end(), 0);
+		for(CBenchVoice &Voice : vVoices)
+		{
+			// mixes the voice from its current tick until the end of the block, looping
+			unsigned Done = 0;
+			while(Done < BlockFrames)
+			{
+				const unsigned End = minimum(BlockFrames - Done, Voice.m_NumFrames - Voice.m_Tick);
+				const short *pData = Voice.m_pData->data() + Voice.m_Tick * Voice.m_Channels;
+				if(Scalar)
+					MixVoiceScalar(vMixBuffer.data() + Done * 2, pData, Voice.m_Channels, End, Voice.m_VolumeL, Voice.m_VolumeR);
+				else
+					SoundMixVoice(vMixBuffer.data() + Done * 2, pData, Voice.m_Channels, End, Voice.m_VolumeL, Voice.m_VolumeR);
+				Voice.m_Tick = (Voice.m_Tick + End) % Voice.m_NumFrames;
+				Done += End;
+			}
+		}
+		SoundMixToOutput(vOut.data(), vMixBuffer.data(), BlockFrames * 2, MASTER_VOLUME);
+		for(short Sample : vOut)
+			*pChecksum = *pChecksum * 31 + (unsigned short)Sample;
+	}
+	return (time_get_nanoseconds() - Start).count();
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 4)
+	{
+		log_error(TOOL_NAME, "Usage: %s [voices] [blocks] [block frames]", TOOL_NAME);
+		return -1;
+	}
+	const int NumVoices = argc >= 2 ? str_toint(argv[1]) : 64;
+	const int NumBlocks = argc >= 3 ? str_toint(argv[2]) : 20000;
+	const int BlockFrames = argc >= 4 ? str_toint(argv[3]) : 512;
+	if(NumVoices < 1 || NumBlocks < 1 || BlockFrames < 1)
+	{
+		log_error(TOOL_NAME, "Invalid arguments");
+		return -1;
+	}
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+	Prng.Seed(aSeed);
+
+	// a few synthesized mono and stereo samples of different lengths, like the game sounds
+	std::vector<std::vector<short>> vvSamples;
+	std::vector<int> vSampleChannels;
+	for(int i = 0; i < 8; i++)
+	{
+		const int Channels = i % 2 + 1;
+		const unsigned NumFrames = MIX_RATE / 4 + Prng.RandomBits() % MIX_RATE;
+		std::vector<short> vData(NumFrames * Channels);
+		for(auto &Sample : vData)
+			Sample = (short)((int)(Prng.RandomBits() % 65536) - 32768) / 8;
+		vvSamples.push_back(std::move(vData));
+		vSampleChannels.push_back(Channels);
+	}
+
+	std::vector<CBenchVoice> vVoices;
+	for(int i = 0; i < NumVoices; i++)
+	{
+		CBenchVoice Voice;
+		const int Sample = Prng.RandomBits() % vvSamples.size();
+		Voice.m_pData = &vvSamples[Sample];
+		Voice.m_Channels = vSampleChannels[Sample];
+		Voice.m_NumFrames = vvSamples[Sample].size() / Voice.m_Channels;
+		Voice.m_Tick = Prng.RandomBits() % Voice.m_NumFrames;
+		Voice.m_VolumeL = Prng.RandomBits() % 256;
+		Voice.m_VolumeR = Prng.RandomBits() % 256;
+		vVoices.push_back(Voice);
+	}
+
+	const double AudioSeconds = (double)NumBlocks * BlockFrames / MIX_RATE;
+	log_info(TOOL_NAME, "voices=%d blocks=%d block frames=%d audio=%.1fs", NumVoices, NumBlocks, BlockFrames, AudioSeconds);
+	for(bool Scalar : {true, false})
+	{
+		uint64_t Checksum;
+		const int64_t Ns = Run(vVoices, NumBlocks, BlockFrames, Scalar, &Checksum);
+		log_info(TOOL_NAME, "%s: %.3fs (%.2fus per block, %.0fx realtime) checksum=%016llx",
+			Scalar ? "scalar" : "kernel", Ns / 1e9, Ns / 1e3 / NumBlocks, AudioSeconds / (Ns / 1e9), (unsigned long long)Checksum);
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include <base/io.h>
+#include <base/logger.h>
+#include <base/os.h>
+
+#include <engine/shared/compressed_stream.h>
+
+#include <vector>
+
+static const char *TOOL_NAME = "teehistorian_decompress";
+
+static int Decompress(const char *pSource, const char *pDestination)
+{
+	IOHANDLE Source = io_open(pSource, IOFLAG_READ);
+	if(!Source)
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' for reading", pSource);
+		return -1;
+	}
+
+	CCompressedStreamReader Reader;
+	if(!Reader.Open(Source))
+	{
+		log_error(TOOL_NAME, "'%s' is not a compressed teehistorian file", pSource);
+		io_close(Source);
+		return -1;
+	}
+
+	IOHANDLE Destination = io_open(pDestination, IOFLAG_WRITE);
+	if(!Destination)
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' for writing", pDestination);
+		io_close(Source);
+		return -1;
+	}
+
+	std::vector<unsigned char> vBlock;
+	uint64_t Size = 0;
+	while(Reader.ReadBlock(vBlock))
+	{
+		io_write(Destination, vBlock.data(), vBlock.size());
+		Size += vBlock.size();
+	}
+	io_close(Source);
+	const bool WriteError = io_error(Destination) != 0;
+	io_close(Destination);
+
+	if(WriteError)
+	{
+		log_error(TOOL_NAME, "Failed to write '%s'", pDestination);
+		return -1;
+	}
+	if(Reader.Error())
+	{
+		// the blocks before are intact, e.g. if the server crashed while writing
+		log_error(TOOL_NAME, "'%s' is corrupted or cut off after %llu bytes", pSource, (unsigned long long)Size);
+		return -1;
+	}
+	log_info(TOOL_NAME, "Decompressed '%s' to '%s' (%llu bytes)", pSource, pDestination, (unsigned long long)Size);
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+	if(argc != 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s <source.teehistorian.z> <destination.teehistorian>", TOOL_NAME);
+		return -1;
+	}
+	return Decompress(argv[1], argv[2]);
+}